@@ -0,0 +1,283 @@
+// Search of the machine dependent parameters of the invertor files, written to the configuration file that the
+// library reads at startup (`invertor_config.c').  The parameters are tuned one after the other, each over a list of
+// candidates with the others at their best value so far:
+//	gemm_mc, gemm_kc, gemm_nc	by invgemm of order n,
+//	leaf				by invertor_inplace_by_a.c of order n,
+//	threads				by invertor_inplace_by_a.c (with -fopenmp and more than one processor),
+//	prll_block, prll_chunk		by invertor_by_prll.c,
+// then the sequential rate of every engine (rate_<engine>, GFLOP/s on one thread) for the cost model of
+// `invertor_dispatch.c'.  Every measurement runs in a new process started with a temporary configuration, so that
+// the parameters are taken exactly as the library takes them from the file: the median of reps runs after a warm-up.
+
+// Compilation:
+//	gcc -O3 -march=native -fopenmp -o autotune.e autotune.c -lm
+// Running (the file is INVERTOR_CONFIG or $HOME/.invertor.conf unless -o is given):
+//	./autotune.e [-n 1024] [-r 3] [-o invertor.conf]
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
+#include<time.h>
+#include<unistd.h>
+#include<sys/wait.h>
+
+#include "invertor_dispatch.c"
+#include "benchcommon.c"
+
+#define TUNEPARAMS 7
+#define TUNEMAXCANDIDATES 16
+
+struct tuneparam
+{
+	const char *key;
+	int value;		//best so far, starting at the compiled default
+	const char *measure;	//what is timed to compare the candidates
+	int candidates[TUNEMAXCANDIDATES];	//ends at -1
+};
+
+double tunemeasure(const char *what, int n, int reps);
+int tunewrite(const char *path, struct tuneparam *params, int nparams, double *rates, int n);
+double tunerun(const char *config, struct tuneparam *params, int nparams, int threads, const char *what, int n, int reps);
+int tuneprocessors(void);
+
+double tunemeasure(const char *what, int n, int reps)
+{
+	//Runs in the measuring process: median seconds of reps runs of what, 0 if it fails.
+	int i, j, r, e, status;
+	double **a, **x, *times, *work, start, median;
+
+	times=(double *) malloc(reps*sizeof(double));
+	a=(double **) malloc(n*sizeof(double *));
+	x=(double **) malloc(n*sizeof(double *));
+	if(times==NULL || a==NULL || x==NULL) return 0;
+	for(i=0;i<n;i++)
+	{
+		a[i]=(double *) malloc(n*sizeof(double));
+		x[i]=(double *) malloc(n*sizeof(double));
+		if(a[i]==NULL || x[i]==NULL) return 0;
+	}
+	//Symmetric and diagonally dominant, so that every engine, invertmatspd included, can invert it.
+	srand(1);
+	for(i=0;i<n;i++)
+		for(j=0;j<=i;j++) a[i][j]=a[j][i]=(double)rand()/RAND_MAX-0.5+((i==j)?0.5*n:0);
+
+	if(strcmp(what, "gemm")==0)
+	{
+		//Rows of a and x are not contiguous: the product is taken on copies.
+		work=(double *) malloc((3*(size_t)n*n+invgemmworksize(n, n, n))*sizeof(double));
+		if(work==NULL) return 0;
+		for(i=0;i<n;i++) memcpy(work+(size_t)i*n, a[i], n*sizeof(double));
+		memcpy(work+(size_t)n*n, work, (size_t)n*n*sizeof(double));
+		for(r=-1;r<reps;r++)
+		{
+			start=benchseconds();
+			invgemm(n, n, n, 1.0, work, n, work+(size_t)n*n, n, 0.0, work+2*(size_t)n*n, n, work+3*(size_t)n*n);
+			if(r>=0) times[r]=benchseconds()-start;
+		}
+		free(work);
+	}
+	else
+	{
+		for(e=0;e<INVENGINES && strcmp(what, invertorname(e))!=0;e++);
+		if(e==INVENGINES) return 0;
+		for(r=-1;r<reps;r++)
+		{
+			start=benchseconds();
+			status=invertmatengine(e, n, a, x);
+			if(status==0) return 0;
+			if(r>=0) times[r]=benchseconds()-start;
+		}
+	}
+
+	qsort(times, reps, sizeof(double), benchcompare);
+	median=benchpercentile(times, reps, 50);
+	for(i=0;i<n;i++)
+	{
+		free(a[i]);
+		free(x[i]);
+	}
+	free(a);
+	free(x);
+	free(times);
+	return median;
+}
+
+int tunewrite(const char *path, struct tuneparam *params, int nparams, double *rates, int n)
+{
+	//Writes the parameters (and the rates, when given) as a configuration file.
+	FILE *f;
+	int i;
+	char host[256];
+
+	f=fopen(path, "w");
+	if(f==NULL)
+	{
+		printf("\nUnable to write the configuration %s\n",path);
+		return 0;
+	}
+	if(gethostname(host, sizeof(host))!=0) snprintf(host, sizeof(host), "this machine");
+	host[sizeof(host)-1]=0;
+	fprintf(f, "# invertor configuration of %s, written by autotune (order %d)\n", host, n);
+	for(i=0;i<nparams;i++) fprintf(f, "%s = %d\n", params[i].key, params[i].value);
+	if(rates!=NULL)
+		for(i=0;i<INVENGINES;i++)
+			if(rates[i]>0) fprintf(f, "rate_%s = %.3f\n", invertorname(i), rates[i]);
+	return (fclose(f)==0);
+}
+
+double tunerun(const char *config, struct tuneparam *params, int nparams, int threads, const char *what, int n, int reps)
+{
+	//Writes params to config and times what in a new process reading it; threads (if > 0) replaces the key threads.
+	//Returns the median seconds, or a huge value if the process fails.
+	int i, fd[2], wstatus, saved, written;
+	char line[64], nstr[16], rstr[16];
+	ssize_t got;
+	pid_t pid;
+
+	for(i=0;i<nparams && strcmp(params[i].key, "threads")!=0;i++);
+	saved=(i<nparams)?params[i].value:0;
+	if(threads>0 && i<nparams) params[i].value=threads;
+	written=tunewrite(config, params, nparams, NULL, n);
+	if(i<nparams) params[i].value=saved;
+	if(written==0) return HUGE_VAL;
+
+	snprintf(nstr, sizeof(nstr), "%d", n);
+	snprintf(rstr, sizeof(rstr), "%d", reps);
+	if(pipe(fd)!=0) return HUGE_VAL;
+	fflush(stdout);
+	pid=fork();
+	if(pid<0) return HUGE_VAL;
+	if(pid==0)
+	{
+		close(fd[0]);
+		dup2(fd[1], 1);
+		execl("/proc/self/exe", "autotune", "-measure", what, nstr, rstr, (char *) NULL);
+		_exit(1);
+	}
+	close(fd[1]);
+	got=read(fd[0], line, sizeof(line)-1);
+	close(fd[0]);
+	waitpid(pid, &wstatus, 0);
+	if(got<=0 || !WIFEXITED(wstatus) || WEXITSTATUS(wstatus)!=0) return HUGE_VAL;
+	line[got]=0;
+	return (atof(line)>0)?atof(line):HUGE_VAL;
+}
+
+int tuneprocessors(void)
+{
+#ifdef _OPENMP
+	return omp_get_num_procs();
+#else
+	return 1;
+#endif
+}
+
+int main(int argc, char** argv)
+{
+	struct tuneparam params[TUNEPARAMS]=
+	{
+		{"gemm_mc", GEMMMC, "gemm", {48, 72, 96, 120, 144, 192, 240, -1}},
+		{"gemm_kc", GEMMKC, "gemm", {128, 192, 256, 320, 384, 512, -1}},
+		{"gemm_nc", GEMMNC, "gemm", {512, 1024, 2048, 4096, -1}},
+		{"leaf", INVLEAFORDER, "inplace_by_a", {16, 24, 32, 48, 64, 96, 128, -1}},
+		{"threads", 0, "inplace_by_a", {-1}},
+		{"prll_block", PRLLBLOCKORDER, "by_prll", {64, 96, 128, 192, 256, 384, -1}},
+		{"prll_chunk", 0, "by_prll", {0, 1, 2, 4, 8, 16, -1}},
+	};
+	int n=1024, reps=3, a, p, c, e, fd, procs, best;
+	char out[4096], config[64];
+	const char *outpath=NULL;
+	double seconds, bestseconds, rates[INVENGINES];
+
+	if(argc==5 && strcmp(argv[1], "-measure")==0)
+	{
+		seconds=tunemeasure(argv[2], atoi(argv[3]), atoi(argv[4]));
+		printf("%.9g\n", seconds);
+		return (seconds>0)?0:1;
+	}
+	for(a=1;a<argc;a++)
+	{
+		if(strcmp(argv[a], "-n")==0 && a+1<argc) n=atoi(argv[++a]);
+		else if(strcmp(argv[a], "-r")==0 && a+1<argc) reps=atoi(argv[++a]);
+		else if(strcmp(argv[a], "-o")==0 && a+1<argc) outpath=argv[++a];
+		else
+		{
+			fprintf(stderr, "Usage: %s [-n order] [-r reps] [-o file]\n", argv[0]);
+			return 1;
+		}
+	}
+	if(n<64) n=64;
+	if(reps<1) reps=1;
+	if(outpath==NULL) outpath=invconfigpath(out, sizeof(out));
+	if(getenv("INVERTOR_LEAF")!=NULL)
+	{
+		fprintf(stderr, "INVERTOR_LEAF is ignored while tuning\n");
+		unsetenv("INVERTOR_LEAF");
+	}
+
+	//Thread counts: powers of two up to the processors, and the processors.
+	procs=tuneprocessors();
+	for(c=0,p=1;p<procs && c<TUNEMAXCANDIDATES-2;p*=2) params[4].candidates[c++]=p;
+	params[4].candidates[c++]=procs;
+	params[4].candidates[c]=-1;
+	params[4].value=procs;
+
+	snprintf(config, sizeof(config), "/tmp/invertorXXXXXX");
+	fd=mkstemp(config);
+	if(fd<0)
+	{
+		printf("\nUnable to create a temporary configuration\n");
+		return 1;
+	}
+	close(fd);
+	setenv("INVERTOR_CONFIG", config, 1);
+
+	for(p=0;p<TUNEPARAMS;p++)
+	{
+		if(params[p].candidates[1]<0) continue;	//a single candidate: nothing to compare
+		best=params[p].value;
+		bestseconds=HUGE_VAL;
+		for(c=0;params[p].candidates[c]>=0;c++)
+		{
+			params[p].value=params[p].candidates[c];
+			seconds=tunerun(config, params, TUNEPARAMS, 0, params[p].measure, n, reps);
+			fprintf(stderr, "%-10s %5d  %-12s %.4g s\n", params[p].key, params[p].value, params[p].measure, seconds);
+			if(seconds<bestseconds)
+			{
+				bestseconds=seconds;
+				best=params[p].value;
+			}
+		}
+		params[p].value=best;
+		fprintf(stderr, "%-10s %5d  chosen\n", params[p].key, best);
+	}
+
+	//Sequential rates of the engines with the parameters found.
+	for(e=0;e<INVENGINES;e++)
+	{
+		seconds=tunerun(config, params, TUNEPARAMS, 1, invertorname(e), n, reps);
+		rates[e]=(seconds<HUGE_VAL)?2.0*n*n*(double)n/seconds*1e-9:0;
+		fprintf(stderr, "rate_%-12s %.3f GFLOP/s\n", invertorname(e), rates[e]);
+	}
+
+	unlink(config);
+	if(tunewrite(outpath, params, TUNEPARAMS, rates, n)==0) return 1;
+	printf("Configuration written to %s\n", outpath);
+	return 0;
+}
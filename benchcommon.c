@@ -0,0 +1,102 @@
+// Timing helpers shared by the benchmark and tuning programs (`benchgemm.c', `benchinvertor.c', `benchkernels.c' and
+// `autotune.c'), which include this file:
+//	benchseconds()			wall clock seconds (CLOCK_MONOTONIC, not clock() which adds up the threads)
+//	benchlist(arg, list)		comma separated positive integers of an argument, at most BENCHMAXLIST
+//	benchcompare			comparison of doubles for qsort
+//	benchpercentile(sorted, count, p)	percentile p of sorted times, interpolated between the closest ranks
+//	benchengine(name, size)		short name of INVERTORENGINE, for the programs built per engine
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef BENCHCOMMON_C
+#define BENCHCOMMON_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+
+#ifndef BENCHMAXLIST
+#define BENCHMAXLIST 64
+#endif
+
+double benchseconds(void);
+int benchlist(const char *arg, int *list);
+int benchcompare(const void *x, const void *y);
+double benchpercentile(const double *sorted, int count, double p);
+#ifdef INVERTORENGINE
+void benchengine(char *name, int size);
+#endif
+
+double benchseconds(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec+1e-9*t.tv_nsec;
+}
+
+int benchlist(const char *arg, int *list)
+{
+	//Comma separated positive integers of arg into list; returns their number.
+	int count;
+	char *end;
+
+	count=0;
+	while(*arg && count<BENCHMAXLIST)
+	{
+		list[count]=(int) strtol(arg, &end, 10);
+		if(end==arg) break;
+		if(list[count]>0) count++;
+		arg=(*end==',')?end+1:end;
+	}
+	return count;
+}
+
+int benchcompare(const void *x, const void *y)
+{
+	double a=*(const double *) x, b=*(const double *) y;
+	return (a>b)-(a<b);
+}
+
+double benchpercentile(const double *sorted, int count, double p)
+{
+	//Percentile p (0 to 100) of count sorted values, interpolated between the closest ranks.
+	double rank;
+	int i;
+
+	rank=p/100*(count-1);
+	i=(int) rank;
+	if(i>=count-1) return sorted[count-1];
+	return sorted[i]+(rank-i)*(sorted[i+1]-sorted[i]);
+}
+
+#ifdef INVERTORENGINE
+void benchengine(char *name, int size)
+{
+	//Name of the engine: INVERTORENGINE without the directory, the `invertor_' prefix and `.c'.
+	const char *s;
+	char *dot;
+
+	s=strrchr(INVERTORENGINE, '/');
+	s=(s==NULL)?INVERTORENGINE:s+1;
+	if(strncmp(s, "invertor_", 9)==0) s+=9;
+	snprintf(name, size, "%s", s);
+	dot=strrchr(name, '.');
+	if(dot!=NULL) *dot=0;
+}
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+// Benchmark of the blocked matrix multiplication `invertor_gemm.c' used by the Schur complement updates.
+// For square orders n it times C := C + A * B with invgemm and with the plain loop it replaced,
+// and prints GFLOP/s next to the peak of one core measured by a register-only multiply-add loop.
+
+// Compilation:
+//	gcc -O3 -march=native -o benchgemm.e benchgemm.c -lm
+// Running:
+//	./benchgemm.e [n1 n2 ...]
+// Without arguments the orders 64 128 256 512 1024 are used.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<math.h>
+#include<time.h>
+
+#include "invertor_matrix.c"
+#include "invertor_gemm.c"
+#include "benchcommon.c"
+
+//Independent vector accumulators of the peak loop: enough to cover the multiply-add latency on every port
+//while still fitting in the registers, as the accumulators of the micro-kernel do.
+#define PEAKACC 12
+
+double benchpeak(void);
+void benchnaive(int n, struct invmat *a, struct invmat *b, struct invmat *c);
+
+double benchpeak(void)
+{
+	//Every pass performs PEAKACC independent vector multiply-adds on values kept in registers,
+	//with the same vector type as the micro-kernel of invgemm.
+	int i;
+	long r, reps;
+	gemmvec acc[PEAKACC], x, y;
+	double start, seconds, sum;
+
+	x=0.999999-(gemmvec){0};
+	y=1e-7-(gemmvec){0};
+	for(i=0;i<PEAKACC;i++) acc[i]=i-(gemmvec){0};
+	reps=1000000;
+	do
+	{
+		start=benchseconds();
+		for(r=0;r<reps;r++)
+			for(i=0;i<PEAKACC;i++)
+				acc[i]=acc[i]*x+y;
+		seconds=benchseconds()-start;
+		reps*=2;
+	}
+	while(seconds<0.2);
+	reps/=2;
+
+	for(sum=0,i=0;i<PEAKACC;i++) sum+=acc[i][0];
+	if(sum==12345) printf(" ");
+	return 2.0*GEMMVL*PEAKACC*reps/seconds*1e-9;
+}
+
+void benchnaive(int n, struct invmat *a, struct invmat *b, struct invmat *c)
+{
+	//The loop schurcomplement used before invgemm.
+	int i,j,k;
+	for(i=0;i<n;i++)
+		for(j=0;j<n;j++)
+			for(k=0;k<n;k++)
+				MATEL(c,i,j)+=MATEL(a,i,k)*MATEL(b,k,j);
+}
+
+int main(int argc, char** argv)
+{
+	int defaults[]={64, 128, 256, 512, 1024};
+	int count, t, n, i, j, reps, r;
+	struct invmat a, b, c, d;
+	double peak, flops, start, seconds, gemmrate, naiverate, err;
+
+	count=(argc>1)?argc-1:(int)(sizeof(defaults)/sizeof(defaults[0]));
+	peak=benchpeak();
+	printf("Measured peak of one core: %.2lf GFLOP/s\n", peak);
+	printf("%8s %14s %8s %14s %12s\n", "n", "invgemm GF/s", "of peak", "naive GF/s", "max diff");
+
+	srand(1);
+	for(t=0;t<count;t++)
+	{
+		n=(argc>1)?atoi(argv[t+1]):defaults[t];
+		if(n<=0) continue;
+		if(invmatalloc(&a,n,n)==0 || invmatalloc(&b,n,n)==0 || invmatalloc(&c,n,n)==0 || invmatalloc(&d,n,n)==0) return 1;
+		for(i=0;i<n;i++)
+			for(j=0;j<n;j++)
+			{
+				MATEL(&a,i,j)=(double)rand()/RAND_MAX-0.5;
+				MATEL(&b,i,j)=(double)rand()/RAND_MAX-0.5;
+			}
+		flops=2.0*n*n*n;
+
+		reps=1;
+		do
+		{
+			start=benchseconds();
+			for(r=0;r<reps;r++) invgemm(n, n, n, 1.0, a.data, a.ld, b.data, b.ld, 1.0, c.data, c.ld, NULL);
+			seconds=benchseconds()-start;
+			reps*=2;
+		}
+		while(seconds<0.2);
+		gemmrate=flops*(reps/2)/seconds*1e-9;
+
+		start=benchseconds();
+		benchnaive(n, &a, &b, &d);
+		seconds=benchseconds()-start;
+		naiverate=flops/seconds*1e-9;
+
+		//One more product from zero checks invgemm against the plain loop.
+		invgemm(n, n, n, 1.0, a.data, a.ld, b.data, b.ld, 0.0, c.data, c.ld, NULL);
+		for(err=0,i=0;i<n;i++)
+			for(j=0;j<n;j++)
+				if(fabs(MATEL(&c,i,j)-MATEL(&d,i,j))>err) err=fabs(MATEL(&c,i,j)-MATEL(&d,i,j));
+
+		printf("%8d %14.2lf %7.1lf%% %14.2lf %12.2le\n", n, gemmrate, 100*gemmrate/peak, naiverate, err);
+		invmatfree(&a);
+		invmatfree(&b);
+		invmatfree(&c);
+		invmatfree(&d);
+	}
+	return 0;
+}
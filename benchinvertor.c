@@ -0,0 +1,199 @@
+// Benchmark of an inversion engine over orders and thread counts.
+// The engine is chosen at compilation (INVERTORENGINE, default `invertor_inplace_by_a.c'), so that every engine keeps
+// its own invertmat; build one binary per engine and run them with the same arguments.  Every (order, threads) point
+// runs in a child process of its own, so that its peak resident memory is its own: the matrix is inverted once to
+// warm up and then reps times, timed by the wall clock (CLOCK_MONOTONIC, not clock() which adds up the threads).
+// One line per point is printed, as CSV or as JSON lines: engine, n, threads, reps, median, 10th and 90th percentile
+// and minimum seconds, GFLOP/s of the median (2 n^3 operations), peak resident MB after the inversions and the
+// residual max |A X - I|.
+
+// Compilation, for each engine:
+//	gcc -O3 -march=native -fopenmp -DINVERTORENGINE='"invertor_by_a.c"' -o bench_by_a.e benchinvertor.c -lm
+// Running:
+//	./bench_by_a.e [-n 256,512,1024] [-t 1,2,4] [-r 5] [-json] [-noheader]
+// e.g. the four engines into one file:
+//	for e in by_a inplace_by_a by_ad by_prll; do ./bench_$e.e -n 500,1000,2000 -t 1,4 -noheader; done > bench.csv
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
+#include<time.h>
+#include<unistd.h>
+#include<sys/wait.h>
+#include<sys/resource.h>
+
+#ifndef INVERTORENGINE
+#define INVERTORENGINE "invertor_inplace_by_a.c"
+#endif
+#include INVERTORENGINE
+#include "invertor_gemm.c"
+#include "benchcommon.c"
+
+#ifdef _OPENMP
+#include<omp.h>
+#endif
+
+
+struct benchresult
+{
+	int status;		//return value of invertmat for every repetition
+	int reps;
+	double median, p10, p90, min;
+	double rssmb;
+	double residual;
+};
+
+void benchpoint(int n, int threads, int reps, struct benchresult *res);
+double benchresidual(int n, double** a, double** x);
+
+void benchpoint(int n, int threads, int reps, struct benchresult *res)
+{
+	//Runs in the child: the same seeded, diagonally dominant matrix for every engine.
+	int i, j, r;
+	double **a, **x, *times, start;
+	struct rusage usage;
+
+	memset(res, 0, sizeof(*res));
+	res->reps=reps;
+#ifdef _OPENMP
+	omp_set_num_threads(threads);
+#endif
+	a=(double **) malloc(n*sizeof(double *));
+	x=(double **) malloc(n*sizeof(double *));
+	times=(double *) malloc(reps*sizeof(double));
+	if(a==NULL || x==NULL || times==NULL) return;
+	for(i=0;i<n;i++)
+	{
+		a[i]=(double *) malloc(n*sizeof(double));
+		x[i]=(double *) malloc(n*sizeof(double));
+		if(a[i]==NULL || x[i]==NULL) return;
+	}
+	srand(1);
+	for(i=0;i<n;i++)
+		for(j=0;j<n;j++) a[i][j]=(double)rand()/RAND_MAX-0.5+((i==j)?0.5*sqrt((double)n):0);
+
+	res->status=invertmat(n, a, x);
+	for(r=0;r<reps && res->status;r++)
+	{
+		start=benchseconds();
+		res->status=invertmat(n, a, x);
+		times[r]=benchseconds()-start;
+	}
+	getrusage(RUSAGE_SELF, &usage);
+	res->rssmb=usage.ru_maxrss/1024.0;
+	if(res->status==0) return;
+
+	qsort(times, reps, sizeof(double), benchcompare);
+	res->median=benchpercentile(times, reps, 50);
+	res->p10=benchpercentile(times, reps, 10);
+	res->p90=benchpercentile(times, reps, 90);
+	res->min=times[0];
+	res->residual=benchresidual(n, a, x);
+}
+
+double benchresidual(int n, double** a, double** x)
+{
+	//max |A X - I| with invgemm, a few rows of A at a time against a contiguous copy of X.
+	int i, j, i0, m;
+	double *xc, *ar, *r, err;
+
+	xc=(double *) malloc((size_t)n*n*sizeof(double));
+	ar=(double *) malloc((size_t)64*n*sizeof(double));
+	r=(double *) malloc((size_t)64*n*sizeof(double));
+	if(xc==NULL || ar==NULL || r==NULL) return -1;
+	for(i=0;i<n;i++) memcpy(xc+(size_t)i*n, x[i], n*sizeof(double));
+	err=0;
+	for(i0=0;i0<n;i0+=64)
+	{
+		m=(n-i0<64)?n-i0:64;
+		for(i=0;i<m;i++) memcpy(ar+(size_t)i*n, a[i0+i], n*sizeof(double));
+		invgemm(m, n, n, 1.0, ar, n, xc, n, 0.0, r, n, NULL);
+		for(i=0;i<m;i++)
+			for(j=0;j<n;j++)
+				if(fabs(r[(size_t)i*n+j]-((i0+i==j)?1:0))>err) err=fabs(r[(size_t)i*n+j]-((i0+i==j)?1:0));
+	}
+	free(xc);
+	free(ar);
+	free(r);
+	return err;
+}
+
+int main(int argc, char** argv)
+{
+	int sizes[BENCHMAXLIST]={256, 512, 1024}, threads[BENCHMAXLIST]={1};
+	int nsizes=3, nthreads=1, reps=5, json=0, header=1;
+	int a, s, t, fd[2], wstatus;
+	char engine[64];
+	double gflops;
+	pid_t pid;
+	struct benchresult res;
+
+	for(a=1;a<argc;a++)
+	{
+		if(strcmp(argv[a], "-n")==0 && a+1<argc) nsizes=benchlist(argv[++a], sizes);
+		else if(strcmp(argv[a], "-t")==0 && a+1<argc) nthreads=benchlist(argv[++a], threads);
+		else if(strcmp(argv[a], "-r")==0 && a+1<argc) reps=atoi(argv[++a]);
+		else if(strcmp(argv[a], "-json")==0) json=1;
+		else if(strcmp(argv[a], "-noheader")==0) header=0;
+		else
+		{
+			fprintf(stderr, "Usage: %s [-n n1,n2,...] [-t t1,t2,...] [-r reps] [-json] [-noheader]\n", argv[0]);
+			return 1;
+		}
+	}
+	if(reps<1) reps=1;
+	benchengine(engine, sizeof(engine));
+#ifndef _OPENMP
+	if(nthreads>1 || threads[0]!=1) fprintf(stderr, "Compiled without -fopenmp: every point runs on 1 thread\n");
+	threads[0]=1;
+	nthreads=1;
+#endif
+
+	if(header && !json) printf("engine,n,threads,reps,status,median_s,p10_s,p90_s,min_s,gflops,peak_rss_mb,residual\n");
+	for(s=0;s<nsizes;s++)
+		for(t=0;t<nthreads;t++)
+		{
+			//The child sends its result through a pipe; a child that dies leaves status 0.
+			memset(&res, 0, sizeof(res));
+			if(pipe(fd)!=0) return 1;
+			fflush(stdout);
+			pid=fork();
+			if(pid<0) return 1;
+			if(pid==0)
+			{
+				close(fd[0]);
+				benchpoint(sizes[s], threads[t], reps, &res);
+				if(write(fd[1], &res, sizeof(res))!=sizeof(res)) _exit(1);
+				_exit(0);
+			}
+			close(fd[1]);
+			if(read(fd[0], &res, sizeof(res))!=sizeof(res)) res.status=0;
+			close(fd[0]);
+			waitpid(pid, &wstatus, 0);
+
+			gflops=(res.status && res.median>0)?2.0*sizes[s]*sizes[s]*(double)sizes[s]/res.median*1e-9:0;
+			if(json)
+				printf("{\"engine\":\"%s\",\"n\":%d,\"threads\":%d,\"reps\":%d,\"status\":%d,\"median_s\":%.6g,\"p10_s\":%.6g,\"p90_s\":%.6g,\"min_s\":%.6g,\"gflops\":%.4g,\"peak_rss_mb\":%.1f,\"residual\":%.3g}\n",
+					engine, sizes[s], threads[t], reps, res.status, res.median, res.p10, res.p90, res.min, gflops, res.rssmb, res.residual);
+			else
+				printf("%s,%d,%d,%d,%d,%.6g,%.6g,%.6g,%.6g,%.4g,%.1f,%.3g\n",
+					engine, sizes[s], threads[t], reps, res.status, res.median, res.p10, res.p90, res.min, gflops, res.rssmb, res.residual);
+		}
+	return 0;
+}
@@ -0,0 +1,387 @@
+// Microbenchmark of the primitives of an engine, one at a time, over a grid of shapes, to find which of them moved
+// when the time of an inversion moves.  As for `benchinvertor.c', the engine is chosen at compilation
+// (INVERTORENGINE) and the primitives it has are timed:
+//	every engine:		invgemm, the fixed order kernels invertfixed (orders 5 to 16)
+//	invertor_by_a.c:	byamatmulthree, invertmatone ... invertmatfour
+//	invertor_inplace_by_a.c, invertor_by_ad.c:	schurcomplement, inplaceleftmatmul, inplacerightmatmul, invleafgj
+//	invertor_by_ad.c:	schurad
+//	invertor_by_prll.c:	invertcases (orders 1 to 4), invleafgj
+// The blocks are of order n (-n list) with the inner or panel dimension k (-k list, default k = n).  A kernel is
+// repeated until a trial takes BENCHTRIAL seconds and the median of BENCHTRIALS trials is kept.  One CSV line per
+// kernel and shape: ns per call, GFLOP/s and the bytes of the operands read and written per operation.
+// With -baseline file (an earlier output of the same binary) the baseline time and the ratio are added and a kernel
+// slower than the baseline by more than -tolerance percent (default 10) is flagged; the exit status is then 2.
+
+// Compilation, for each engine:
+//	gcc -O3 -march=native -DINVERTORENGINE='"invertor_inplace_by_a.c"' -o benchkernels_inplace.e benchkernels.c -lm
+// Running:
+//	./benchkernels_inplace.e [-n 64,128,256] [-k 32,64] [-baseline base.csv] [-tolerance 10] > now.csv
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
+#include<time.h>
+
+#ifndef INVERTORENGINE
+#define INVERTORENGINE "invertor_inplace_by_a.c"
+#endif
+#include INVERTORENGINE
+#include "invertor_gemm.c"
+#include "invertor_fixed.c"
+#include "benchcommon.c"
+
+//The engine is recognised by the constants it defines.
+#if defined(INPLACETASKCUTOFF)
+#define BENCHINPLACE
+#elif defined(ADTASKCUTOFF)
+#define BENCHBYAD
+#elif defined(PRLLBLOCKORDER)
+#define BENCHPRLL
+#else
+#define BENCHBYA
+#endif
+
+#define BENCHTRIAL 0.02
+#define BENCHTRIALS 5
+#define BENCHMAXBASE 4096
+
+//Operands of a kernel: the blocks are placed in a and b (order n + k) or in the descriptors x, y, z, r.
+struct benchargs
+{
+	int n, k;
+	struct invmat a, b, x, y, z, r;
+	double **rows, **inrows;
+	struct invworkspace *ws;
+};
+
+struct benchbase
+{
+	char key[96];
+	double ns;
+};
+
+typedef int (*benchkernel)(struct benchargs *g);
+
+double benchns(benchkernel kernel, struct benchargs *g);
+void benchfill(struct invmat *mat, int m, int n, int diagonal);
+int benchreport(const char *engine, const char *kernel, int n, int k, double ns, double flops, double bytes, struct benchbase *base, int nbase, double tolerance);
+int benchbaseline(const char *path, struct benchbase *base);
+
+double benchns(benchkernel kernel, struct benchargs *g)
+{
+	//Median over the trials of the nanoseconds per call; the calls of a trial are doubled until it lasts BENCHTRIAL.
+	//0 if the kernel fails (the later calls are not checked, so that the check is not timed).
+	long r, reps;
+	int t;
+	double start, seconds, trials[BENCHTRIALS];
+
+	if(kernel(g)==0) return 0;
+	reps=1;
+	for(;;)
+	{
+		start=benchseconds();
+		for(r=0;r<reps;r++) kernel(g);
+		seconds=benchseconds()-start;
+		if(seconds>=BENCHTRIAL) break;
+		reps*=2;
+	}
+	trials[0]=seconds/reps;
+	for(t=1;t<BENCHTRIALS;t++)
+	{
+		start=benchseconds();
+		for(r=0;r<reps;r++) kernel(g);
+		trials[t]=(benchseconds()-start)/reps;
+	}
+	qsort(trials, BENCHTRIALS, sizeof(double), benchcompare);
+	return trials[BENCHTRIALS/2]*1e9;
+}
+
+void benchfill(struct invmat *mat, int m, int n, int diagonal)
+{
+	//Small random entries; with diagonal set, a dominant diagonal so that the square blocks are well conditioned.
+	int i, j;
+
+	for(i=0;i<m;i++)
+		for(j=0;j<n;j++) MATEL(mat,i,j)=((double)rand()/RAND_MAX-0.5)/(m+n)+((diagonal && i==j)?1:0);
+}
+
+//The kernels.  Repeated calls must keep the values bounded: the products that write over an operand use a
+//signed permutation for the square factor, and the inversions in place return to the matrix every second call.
+
+int benchgemm(struct benchargs *g)
+{
+	int status;
+	size_t mark=invwsmark(g->ws);
+	status=invgemm(g->n, g->n, g->k, 1.0, g->x.data, g->x.ld, g->y.data, g->y.ld, 0.0, g->z.data, g->z.ld, invwsdoubles(g->ws, invgemmworksize(g->n, g->n, g->k)));
+	invwsrelease(g->ws, mark);
+	return status;
+}
+
+int benchfixed(struct benchargs *g)
+{
+	return invertfixed(g->n, g->a.data, g->a.ld, g->b.data, g->b.ld);
+}
+
+#ifdef INVERTOR_LEAF_C
+int benchleafgj(struct benchargs *g)
+{
+	int status;
+	size_t mark=invwsmark(g->ws);
+	status=invleafgj(g->n, g->a.data, g->a.ld, (int *) invwsdoubles(g->ws, g->n), invwsdoubles(g->ws, invleafworksize(g->n)));
+	invwsrelease(g->ws, mark);
+	return status;
+}
+#endif
+
+#if defined(BENCHINPLACE) || defined(BENCHBYAD)
+int benchschurcomplement(struct benchargs *g)
+{
+	//a(0,0) (n * n) += a(0,n) (n * k) * a(n,0) (k * n)
+	return schurcomplement(&g->a, g->n, 0, 0, g->n, g->k, g->n, 0, g->k, g->ws);
+}
+
+int benchleftmatmul(struct benchargs *g)
+{
+	//b(0,n) (n * k) := -b(0,0) b(0,n), b(0,0) a signed permutation of order n.
+	return inplaceleftmatmul(&g->b, g->n, 0, g->k, 0, g->n, g->ws);
+}
+
+int benchrightmatmul(struct benchargs *g)
+{
+	//b(n,0) (k * n) := b(n,0) b(0,0)
+	return inplacerightmatmul(&g->b, g->n, 0, g->k, g->n, 0, g->ws);
+}
+#endif
+
+#ifdef BENCHBYAD
+int benchschurad(struct benchargs *g)
+{
+	//b(0,0) (n * n) := a(0,0) - a(0,0) (b(0,n) (n * k) * b(n,0) (k * n))
+	return schurad(&g->a, &g->b, g->n, 0, 0, g->n, g->k, g->n, 0, g->k, g->ws);
+}
+#endif
+
+#ifdef BENCHBYA
+int benchmatmulthree(struct benchargs *g)
+{
+	//r (n * n) := x (n * k) * y (k * n) * z (n * n)
+	return byamatmulthree(&g->x, g->n, g->k, &g->y, g->k, g->n, &g->z, g->n, g->n, &g->r, g->n, g->n, g->ws);
+}
+
+int benchinvertmatsmall(struct benchargs *g)
+{
+	switch(g->n)
+	{
+		case 1: return invertmatone(&g->a, &g->b);
+		case 2: return invertmattwo(&g->a, &g->b);
+		case 3: return invertmatthree(&g->a, &g->b);
+		case 4: return invertmatfour(&g->a, &g->b);
+	}
+	return 0;
+}
+#endif
+
+#ifdef BENCHPRLL
+int benchinvertcases(struct benchargs *g)
+{
+	return invertcases(g->n, 0, g->rows, 0, g->inrows);
+}
+#endif
+
+int benchreport(const char *engine, const char *kernel, int n, int k, double ns, double flops, double bytes, struct benchbase *base, int nbase, double tolerance)
+{
+	//Prints the CSV line of a kernel and shape; returns 1 if it failed or is slower than its baseline beyond the tolerance.
+	int i, slower;
+	char key[96];
+	double baseline;
+
+	snprintf(key, sizeof(key), "%s,%s,%d,%d", engine, kernel, n, k);
+	if(ns<=0)
+	{
+		printf("%s,failed\n", key);
+		return 1;
+	}
+	baseline=0;
+	for(i=0;i<nbase;i++)
+		if(strcmp(base[i].key, key)==0) baseline=base[i].ns;
+	slower=(baseline>0 && ns>baseline*(1+tolerance/100));
+	printf("%s,%.1f,%.3f,%.4f", key, ns, flops/ns, bytes/flops);
+	if(nbase>0)
+	{
+		if(baseline>0) printf(",%.1f,%.3f,%s", baseline, ns/baseline, slower?"SLOWER":"ok");
+		else printf(",,,new");
+	}
+	printf("\n");
+	return slower;
+}
+
+int benchbaseline(const char *path, struct benchbase *base)
+{
+	//Reads the key (engine, kernel, n, k) and ns per call of every line of an earlier output.
+	FILE *f;
+	char line[512], *field;
+	int count, i;
+
+	f=fopen(path, "r");
+	if(f==NULL)
+	{
+		fprintf(stderr, "Unable to open the baseline %s\n", path);
+		return -1;
+	}
+	count=0;
+	while(count<BENCHMAXBASE && fgets(line, sizeof(line), f)!=NULL)
+	{
+		//The fifth field is the time; the first four are the key.
+		for(field=line, i=0;i<4 && field!=NULL;i++) field=strchr(field+1, ',');
+		if(field==NULL || strncmp(line, "engine,", 7)==0) continue;
+		*field=0;
+		snprintf(base[count].key, sizeof(base[count].key), "%.95s", line);
+		base[count].ns=atof(field+1);
+		count++;
+	}
+	fclose(f);
+	return count;
+}
+
+int main(int argc, char** argv)
+{
+	int sizes[BENCHMAXLIST]={64, 128, 256}, inner[BENCHMAXLIST];
+	int nsizes=3, ninner=0, nbase=0, slower=0;
+	int a, s, t, n, k, i, nmax, kmax;
+	char engine[64];
+	const char *basepath=NULL;
+	double tolerance=10, dn, dk;
+	size_t bytes;
+	void *work;
+	struct invworkspace ws;
+	struct benchargs g;
+	static struct benchbase base[BENCHMAXBASE];
+
+	for(a=1;a<argc;a++)
+	{
+		if(strcmp(argv[a], "-n")==0 && a+1<argc) nsizes=benchlist(argv[++a], sizes);
+		else if(strcmp(argv[a], "-k")==0 && a+1<argc) ninner=benchlist(argv[++a], inner);
+		else if(strcmp(argv[a], "-baseline")==0 && a+1<argc) basepath=argv[++a];
+		else if(strcmp(argv[a], "-tolerance")==0 && a+1<argc) tolerance=atof(argv[++a]);
+		else
+		{
+			fprintf(stderr, "Usage: %s [-n n1,n2,...] [-k k1,k2,...] [-baseline file] [-tolerance percent]\n", argv[0]);
+			return 1;
+		}
+	}
+	if(basepath!=NULL && (nbase=benchbaseline(basepath, base))<0) return 1;
+	benchengine(engine, sizeof(engine));
+
+	//One arena for the scratch of every kernel, sized for the largest shape.
+	for(nmax=16,kmax=16,i=0;i<nsizes;i++) if(sizes[i]>nmax) nmax=sizes[i];
+	for(i=0;i<ninner;i++) if(inner[i]>kmax) kmax=inner[i];
+	if(ninner==0) kmax=nmax;
+	bytes=INVMATALIGN+invmatbytes(nmax, nmax)+2*invwsbytes(invgemmworksize(nmax, nmax, (nmax>kmax)?nmax:kmax))+invwsbytes(4*(size_t)nmax*nmax);
+#ifdef INVERTOR_SIMD_C
+	bytes+=invwsbytes(simdleftworksize(nmax))+invwsbytes(simdrightworksize(nmax));
+#endif
+	work=malloc(bytes);
+	if(work==NULL) return 1;
+	invwsinit(&ws, work, bytes);
+	g.ws=&ws;
+
+	srand(1);
+	printf("engine,kernel,n,k,ns_per_call,gflops,bytes_per_flop%s\n", (nbase>0)?",baseline_ns,ratio,status":"");
+
+	//Leaves: orders 1 to 16, out of place, on a well conditioned block.
+	for(n=1;n<=16;n++)
+	{
+		if(invmatalloc(&g.a, n, n)==0 || invmatalloc(&g.b, n, n)==0) return 1;
+		benchfill(&g.a, n, n, 1);
+		g.n=n;
+		g.k=n;
+		dn=n;
+		if(n>=INVFIXEDMIN) slower+=benchreport(engine, "invertfixed", n, n, benchns(benchfixed, &g), 2*dn*dn*dn, 16*dn*dn, base, nbase, tolerance);
+#ifdef BENCHBYA
+		if(n<=4) slower+=benchreport(engine, "invertmatsmall", n, n, benchns(benchinvertmatsmall, &g), 2*dn*dn*dn, 16*dn*dn, base, nbase, tolerance);
+#endif
+#ifdef BENCHPRLL
+		if(n<=4)
+		{
+			g.rows=(double **) malloc(n*sizeof(double *));
+			g.inrows=(double **) malloc(n*sizeof(double *));
+			for(i=0;i<n;i++)
+			{
+				g.rows[i]=MATROW(&g.a,i);
+				g.inrows[i]=MATROW(&g.b,i);
+			}
+			slower+=benchreport(engine, "invertcases", n, n, benchns(benchinvertcases, &g), 2*dn*dn*dn, 16*dn*dn, base, nbase, tolerance);
+			free(g.rows);
+			free(g.inrows);
+		}
+#endif
+		invmatfree(&g.a);
+		invmatfree(&g.b);
+	}
+
+	for(s=0;s<nsizes;s++)
+		for(t=0;t<((ninner>0)?ninner:1);t++)
+		{
+			n=sizes[s];
+			k=(ninner>0)?inner[t]:n;
+			g.n=n;
+			g.k=k;
+			dn=n;
+			dk=k;
+			if(invmatalloc(&g.a, n+k, n+k)==0 || invmatalloc(&g.b, n+k, n+k)==0) return 1;
+			if(invmatalloc(&g.x, n, k)==0 || invmatalloc(&g.y, k, n)==0 || invmatalloc(&g.z, n, n)==0 || invmatalloc(&g.r, n, n)==0) return 1;
+			benchfill(&g.a, n+k, n+k, 1);
+			benchfill(&g.b, n+k, n+k, 0);
+			benchfill(&g.x, n, k, 0);
+			benchfill(&g.y, k, n, 0);
+			benchfill(&g.z, n, n, 1);
+
+			slower+=benchreport(engine, "invgemm", n, k, benchns(benchgemm, &g), 2*dn*dn*dk, 8*(2*dn*dk+dn*dn), base, nbase, tolerance);
+#if defined(BENCHINPLACE) || defined(BENCHBYAD)
+			slower+=benchreport(engine, "schurcomplement", n, k, benchns(benchschurcomplement, &g), 2*dn*dn*dk, 8*(2*dn*dk+2*dn*dn), base, nbase, tolerance);
+			//b(0,0) := the signed permutation i -> n-1-i, so that B keeps its size over the calls.
+			for(i=0;i<n;i++)
+			{
+				memset(MATROW(&g.b,i), 0, n*sizeof(double));
+				MATEL(&g.b,i,n-1-i)=-1;
+			}
+			slower+=benchreport(engine, "inplaceleftmatmul", n, k, benchns(benchleftmatmul, &g), 2*dn*dn*dk, 8*(dn*dn+2*dn*dk), base, nbase, tolerance);
+			slower+=benchreport(engine, "inplacerightmatmul", n, k, benchns(benchrightmatmul, &g), 2*dn*dn*dk, 8*(dn*dn+2*dn*dk), base, nbase, tolerance);
+#endif
+#ifdef BENCHBYAD
+			benchfill(&g.b, n+k, n+k, 0);
+			slower+=benchreport(engine, "schurad", n, k, benchns(benchschurad, &g), 2*dn*dn*dk+2*dn*dn*dn, 8*(2*dn*dk+2*dn*dn), base, nbase, tolerance);
+#endif
+#ifdef BENCHBYA
+			slower+=benchreport(engine, "byamatmulthree", n, k, benchns(benchmatmulthree, &g), 2*dn*dn*dk+2*dn*dn*dn, 8*(2*dn*dk+2*dn*dn), base, nbase, tolerance);
+#endif
+#ifdef INVERTOR_LEAF_C
+			if(t==0) slower+=benchreport(engine, "invleafgj", n, n, benchns(benchleafgj, &g), 2*dn*dn*dn, 16*dn*dn, base, nbase, tolerance);
+#endif
+			invmatfree(&g.a);
+			invmatfree(&g.b);
+			invmatfree(&g.x);
+			invmatfree(&g.y);
+			invmatfree(&g.z);
+			invmatfree(&g.r);
+		}
+
+	free(work);
+	return (slower>0)?2:0;
+}
@@ -0,0 +1,344 @@
+// Batched inversion of many independent small matrices (orders 1 to 8), e.g. the covariance matrices of track fits.
+// The matrices are processed BATCHVL at a time, one matrix per lane of a vector (GCC vector extensions, lowered to
+// the widest registers the target allows, so compile with -march=native): every element of the closed-form
+// formulas of invertmatone ... invertmatfour in `invertor_by_prll.c' is then one vector operation for BATCHVL
+// matrices.  Orders 5 to 8 are split once into blocks A (order n/2) and D, as in the other invertor engines,
+// and the blocks are inverted by the same formulas.
+// Singular matrices are not printed: they are reported in a mask with one flag per matrix and their inverse is
+// set to zero.  A matrix of order 5 to 8 whose block A or Schur complement is singular is inverted again by the
+// Gauss-Jordan leaf of `invertor_leaf.c' (partial pivoting), so only singular matrices are flagged.
+
+// Two layouts are accepted for the input and the output:
+//	INVBATCHSOA: structure of arrays, element (i,j) of matrix m at a[(i*n+j)*count + m];
+//	INVBATCHINTERLEAVED: blocks of INVBATCHLANES matrices stored element by element, element (i,j) of matrix m at
+//	a[((m/INVBATCHLANES)*n*n + i*n+j)*INVBATCHLANES + m%INVBATCHLANES]  (the last block may be partly used).
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_BATCH_C
+#define INVERTOR_BATCH_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#include "invertor_leaf.c"
+
+#define INVBATCHSOA 0
+#define INVBATCHINTERLEAVED 1
+//Matrices per block of the interleaved layout, and the largest order.
+#define INVBATCHLANES 8
+#define INVBATCHMAXORDER 8
+
+//Matrices per vector; it divides INVBATCHLANES.
+#if defined(__AVX512F__)
+#define BATCHVL 8
+#elif defined(__AVX__)
+#define BATCHVL 4
+#else
+#define BATCHVL 2
+#endif
+//Below this many matrices the batch is not shared among OpenMP threads.
+#define BATCHOMPMIN 4096
+
+typedef double batchvec __attribute__((vector_size(BATCHVL*sizeof(double))));
+typedef long long batchmask __attribute__((vector_size(BATCHVL*sizeof(long long))));
+
+int invertbatch(int n, int count, const double *a, double *inverta, int layout, unsigned char *singular);
+size_t batchindex(int n, int count, int layout, int e, int m);
+int batchgroup(int n, int count, int g, const double *a, double *inverta, int layout, unsigned char *singular);
+batchmask batchinvert(int n, const batchvec *m, int ldm, batchvec *inv, int ldi);
+batchmask batchdeterminant(batchvec *det);
+batchmask batchinvertone(const batchvec *m, int ldm, batchvec *inv, int ldi);
+batchmask batchinverttwo(const batchvec *m, int ldm, batchvec *inv, int ldi);
+batchmask batchinvertthree(const batchvec *m, int ldm, batchvec *inv, int ldi);
+batchmask batchinvertfour(const batchvec *m, int ldm, batchvec *inv, int ldi);
+//Inlined with a constant order in batchgroup.
+static inline batchmask batchinvertblocks(int n, const batchvec *m, int ldm, batchvec *inv, int ldi) __attribute__((always_inline));
+
+int invertbatch(int n, int count, const double *a, double *inverta, int layout, unsigned char *singular)
+{
+	//Inverts the count matrices of order n in a into inverta (same layout; a and inverta must not overlap).
+	//singular (count flags, may be NULL) gets 1 for a singular matrix and 0 otherwise.
+	//Returns 1 when every matrix was inverted, 0 when at least one is singular or the arguments are wrong.
+	int g, allinverted;
+
+	if(n<1 || n>INVBATCHMAXORDER || count<0 || (layout!=INVBATCHSOA && layout!=INVBATCHINTERLEAVED))
+	{
+		printf("\nUnable to invert a batch of order %d (orders 1 to %d, layouts INVBATCHSOA and INVBATCHINTERLEAVED)\n", n, INVBATCHMAXORDER);
+		return 0;
+	}
+
+	allinverted=1;
+	#pragma omp parallel for schedule(static) reduction(min:allinverted) if(count>=BATCHOMPMIN)
+	for(g=0;g<count;g+=BATCHVL)
+	{
+		if(batchgroup(n, count, g, a, inverta, layout, singular)==0) allinverted=0;
+	}
+	return allinverted;
+}
+
+size_t batchindex(int n, int count, int layout, int e, int m)
+{
+	//Position of element e (= i*n+j) of matrix m.
+	if(layout==INVBATCHSOA) return (size_t)e*count+m;
+	return ((size_t)(m/INVBATCHLANES)*n*n+e)*INVBATCHLANES+m%INVBATCHLANES;
+}
+
+int batchgroup(int n, int count, int g, const double *a, double *inverta, int layout, unsigned char *singular)
+{
+	//Matrices g ... g+BATCHVL-1.  The lanes of a full group are contiguous in both layouts; the lanes beyond
+	//count in the last group are filled with the identity and not stored.
+	int e, l, lanes, status;
+	int pivot[INVBATCHMAXORDER];
+	batchvec m[INVBATCHMAXORDER*INVBATCHMAXORDER], inv[INVBATCHMAXORDER*INVBATCHMAXORDER];
+	batchmask bad;
+	double one[INVBATCHMAXORDER*INVBATCHMAXORDER];
+
+	lanes=(count-g<BATCHVL)?count-g:BATCHVL;
+	if(lanes==BATCHVL)
+	{
+		for(e=0;e<n*n;e++) __builtin_memcpy(&m[e], a+batchindex(n, count, layout, e, g), sizeof(batchvec));
+	}
+	else
+	{
+		for(e=0;e<n*n;e++)
+		{
+			m[e]=(batchvec){0}+((e%(n+1)==0)?1.0:0.0);
+			for(l=0;l<lanes;l++) m[e][l]=a[batchindex(n, count, layout, e, g+l)];
+		}
+	}
+
+	//A constant order lets the compiler unroll the block products of batchinvertblocks.
+	switch(n)
+	{
+		case 5: bad=batchinvertblocks(5, m, 5, inv, 5); break;
+		case 6: bad=batchinvertblocks(6, m, 6, inv, 6); break;
+		case 7: bad=batchinvertblocks(7, m, 7, inv, 7); break;
+		case 8: bad=batchinvertblocks(8, m, 8, inv, 8); break;
+		default: bad=batchinvert(n, m, n, inv, n); break;
+	}
+
+	//Orders above 4 went through the block A: its singular lanes are done again with pivoting.
+	for(l=0;l<lanes && n>4;l++)
+	{
+		if(bad[l]==0) continue;
+		for(e=0;e<n*n;e++) one[e]=m[e][l];
+		if(invleafgj(n, one, n, pivot, NULL)==0) continue;
+		for(e=0;e<n*n;e++) inv[e][l]=one[e];
+		bad[l]=0;
+	}
+
+	for(e=0;e<n*n;e++) inv[e]=(batchvec)((batchmask)inv[e] & ~bad);
+	if(lanes==BATCHVL)
+	{
+		for(e=0;e<n*n;e++) __builtin_memcpy(inverta+batchindex(n, count, layout, e, g), &inv[e], sizeof(batchvec));
+	}
+	else
+	{
+		for(e=0;e<n*n;e++)
+			for(l=0;l<lanes;l++) inverta[batchindex(n, count, layout, e, g+l)]=inv[e][l];
+	}
+
+	status=1;
+	for(l=0;l<lanes;l++)
+	{
+		if(bad[l]!=0) status=0;
+		if(singular!=NULL) singular[g+l]=(bad[l]!=0)?1:0;
+	}
+	return status;
+}
+
+batchmask batchinvert(int n, const batchvec *m, int ldm, batchvec *inv, int ldi)
+{
+	//inv (leading dimension ldi) := m^-1 lane by lane for the orders 1 to 4 (5 to 8: batchinvertblocks).
+	//Returns -1 in the lanes where the determinant is zero.
+	switch(n)
+	{
+		case 1: return batchinvertone(m, ldm, inv, ldi);
+		case 2: return batchinverttwo(m, ldm, inv, ldi);
+		case 3: return batchinvertthree(m, ldm, inv, ldi);
+		default: return batchinvertfour(m, ldm, inv, ldi);
+	}
+}
+
+batchmask batchdeterminant(batchvec *det)
+{
+	//Lanes with a zero determinant are flagged and their determinant set to 1, so that no lane divides by zero.
+	batchmask bad;
+	batchvec one;
+
+	one=(batchvec){0}+1.0;
+	bad=(*det==0);
+	*det=(batchvec)(((batchmask)*det & ~bad) | ((batchmask)one & bad));
+	return bad;
+}
+
+#define BM(i,j) m[(i)*ldm+(j)]
+#define BI(i,j) inv[(i)*ldi+(j)]
+
+batchmask batchinvertone(const batchvec *m, int ldm, batchvec *inv, int ldi)
+{
+	batchmask bad;
+	batchvec det;
+
+	det=BM(0,0);
+	bad=batchdeterminant(&det);
+	BI(0,0)=1/det;
+	return bad;
+}
+
+batchmask batchinverttwo(const batchvec *m, int ldm, batchvec *inv, int ldi)
+{
+	batchmask bad;
+	batchvec det, r;
+
+	det=-(BM(0,1)*BM(1,0)) + BM(0,0)*BM(1,1);
+	bad=batchdeterminant(&det);
+	r=1/det;
+	BI(0,0)=BM(1,1)*r;
+	BI(0,1)=-BM(0,1)*r;
+	BI(1,0)=-BM(1,0)*r;
+	BI(1,1)=BM(0,0)*r;
+	return bad;
+}
+
+batchmask batchinvertthree(const batchvec *m, int ldm, batchvec *inv, int ldi)
+{
+	//The cofactors of invertmatthree, the determinant expanded along the first row.
+	batchmask bad;
+	batchvec det, r, c00, c01, c02;
+
+	c00=-(BM(1,2)*BM(2,1)) + BM(1,1)*BM(2,2);
+	c01=BM(1,2)*BM(2,0) - BM(1,0)*BM(2,2);
+	c02=-(BM(1,1)*BM(2,0)) + BM(1,0)*BM(2,1);
+	det=BM(0,0)*c00 + BM(0,1)*c01 + BM(0,2)*c02;
+	bad=batchdeterminant(&det);
+	r=1/det;
+	BI(0,0)=c00*r;
+	BI(0,1)=(BM(0,2)*BM(2,1) - BM(0,1)*BM(2,2))*r;
+	BI(0,2)=(-(BM(0,2)*BM(1,1)) + BM(0,1)*BM(1,2))*r;
+	BI(1,0)=c01*r;
+	BI(1,1)=(-(BM(0,2)*BM(2,0)) + BM(0,0)*BM(2,2))*r;
+	BI(1,2)=(BM(0,2)*BM(1,0) - BM(0,0)*BM(1,2))*r;
+	BI(2,0)=c02*r;
+	BI(2,1)=(BM(0,1)*BM(2,0) - BM(0,0)*BM(2,1))*r;
+	BI(2,2)=(-(BM(0,1)*BM(1,0)) + BM(0,0)*BM(1,1))*r;
+	return bad;
+}
+
+batchmask batchinvertfour(const batchvec *m, int ldm, batchvec *inv, int ldi)
+{
+	//The cofactors of invertmatfour, with the 2 * 2 minors of the rows 0, 1 (s) and of the rows 2, 3 (c)
+	//computed once: each cofactor is then three products instead of six.
+	batchmask bad;
+	batchvec det, r, s0, s1, s2, s3, s4, s5, c0, c1, c2, c3, c4, c5;
+
+	s0=BM(0,0)*BM(1,1) - BM(1,0)*BM(0,1);
+	s1=BM(0,0)*BM(1,2) - BM(1,0)*BM(0,2);
+	s2=BM(0,0)*BM(1,3) - BM(1,0)*BM(0,3);
+	s3=BM(0,1)*BM(1,2) - BM(1,1)*BM(0,2);
+	s4=BM(0,1)*BM(1,3) - BM(1,1)*BM(0,3);
+	s5=BM(0,2)*BM(1,3) - BM(1,2)*BM(0,3);
+	c5=BM(2,2)*BM(3,3) - BM(3,2)*BM(2,3);
+	c4=BM(2,1)*BM(3,3) - BM(3,1)*BM(2,3);
+	c3=BM(2,1)*BM(3,2) - BM(3,1)*BM(2,2);
+	c2=BM(2,0)*BM(3,3) - BM(3,0)*BM(2,3);
+	c1=BM(2,0)*BM(3,2) - BM(3,0)*BM(2,2);
+	c0=BM(2,0)*BM(3,1) - BM(3,0)*BM(2,1);
+
+	det=s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+	bad=batchdeterminant(&det);
+	r=1/det;
+
+	BI(0,0)=( BM(1,1)*c5 - BM(1,2)*c4 + BM(1,3)*c3)*r;
+	BI(0,1)=(-BM(0,1)*c5 + BM(0,2)*c4 - BM(0,3)*c3)*r;
+	BI(0,2)=( BM(3,1)*s5 - BM(3,2)*s4 + BM(3,3)*s3)*r;
+	BI(0,3)=(-BM(2,1)*s5 + BM(2,2)*s4 - BM(2,3)*s3)*r;
+	BI(1,0)=(-BM(1,0)*c5 + BM(1,2)*c2 - BM(1,3)*c1)*r;
+	BI(1,1)=( BM(0,0)*c5 - BM(0,2)*c2 + BM(0,3)*c1)*r;
+	BI(1,2)=(-BM(3,0)*s5 + BM(3,2)*s2 - BM(3,3)*s1)*r;
+	BI(1,3)=( BM(2,0)*s5 - BM(2,2)*s2 + BM(2,3)*s1)*r;
+	BI(2,0)=( BM(1,0)*c4 - BM(1,1)*c2 + BM(1,3)*c0)*r;
+	BI(2,1)=(-BM(0,0)*c4 + BM(0,1)*c2 - BM(0,3)*c0)*r;
+	BI(2,2)=( BM(3,0)*s4 - BM(3,1)*s2 + BM(3,3)*s0)*r;
+	BI(2,3)=(-BM(2,0)*s4 + BM(2,1)*s2 - BM(2,3)*s0)*r;
+	BI(3,0)=(-BM(1,0)*c3 + BM(1,1)*c1 - BM(1,2)*c0)*r;
+	BI(3,1)=( BM(0,0)*c3 - BM(0,1)*c1 + BM(0,2)*c0)*r;
+	BI(3,2)=(-BM(3,0)*s3 + BM(3,1)*s1 - BM(3,2)*s0)*r;
+	BI(3,3)=( BM(2,0)*s3 - BM(2,1)*s1 + BM(2,2)*s0)*r;
+	return bad;
+}
+
+static inline batchmask batchinvertblocks(int n, const batchvec *m, int ldm, batchvec *inv, int ldi)
+{
+	//Orders 5 to 8 by the blocks A (order n/2), B, C, D of m:
+	//	X = A^-1 B,  S = D - C X,  Y = C A^-1,
+	//	inverse = [A^-1 + X S^-1 Y,  -X S^-1;  -S^-1 Y,  S^-1]
+	//with A^-1 and S^-1 from the formulas above.  A lane is flagged when A or S is singular.
+	int i, j, k, a, d;
+	batchmask bad;
+	batchvec ai[4*4], x[4*4], s[4*4], y[4*4], t;
+
+	a=n/2;
+	d=n-a;
+	bad=batchinvert(a, m, ldm, ai, a);
+	for(i=0;i<a;i++)
+		for(j=0;j<d;j++)
+		{
+			for(t=(batchvec){0},k=0;k<a;k++) t+=ai[i*a+k]*BM(k,a+j);
+			x[i*d+j]=t;
+		}
+	for(i=0;i<d;i++)
+		for(j=0;j<d;j++)
+		{
+			for(t=BM(a+i,a+j),k=0;k<a;k++) t-=BM(a+i,k)*x[k*d+j];
+			s[i*d+j]=t;
+		}
+	for(i=0;i<d;i++)
+		for(j=0;j<a;j++)
+		{
+			for(t=(batchvec){0},k=0;k<a;k++) t+=BM(a+i,k)*ai[k*a+j];
+			y[i*a+j]=t;
+		}
+	bad|=batchinvert(d, s, d, &BI(a,a), ldi);
+
+	//-X S^-1 into the block B of inv, then -S^-1 Y into C and A^-1 - (-X S^-1) Y into A.
+	for(i=0;i<a;i++)
+		for(j=0;j<d;j++)
+		{
+			for(t=(batchvec){0},k=0;k<d;k++) t-=x[i*d+k]*BI(a+k,a+j);
+			BI(i,a+j)=t;
+		}
+	for(i=0;i<d;i++)
+		for(j=0;j<a;j++)
+		{
+			for(t=(batchvec){0},k=0;k<d;k++) t-=BI(a+i,a+k)*y[k*a+j];
+			BI(a+i,j)=t;
+		}
+	for(i=0;i<a;i++)
+		for(j=0;j<a;j++)
+		{
+			for(t=ai[i*a+j],k=0;k<d;k++) t-=BI(i,a+k)*y[k*a+j];
+			BI(i,j)=t;
+		}
+	return bad;
+}
+
+#undef BM
+#undef BI
+
+#endif
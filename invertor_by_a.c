@@ -23,42 +23,106 @@
 
 #include<stdlib.h>
 
-int invertmatone(double** mata, double** inverta);
-int invertmattwo(double** mata, double** inverta);
-int invertmatthree(double** mata, double** inverta);
-int invertmatfour(double** mata, double** inverta);
+#include "invertor_matrix.c"
+#include "invertor_gemm.c"
+#include "invertor_simd.c"
+#include "invertor_fixed.c"
+#include "invertor_perf.c"
 
-int invertblocks(int n, double** mata , double** inverta);
+int invertmatone(struct invmat *mata, struct invmat *inverta);
+int invertmattwo(struct invmat *mata, struct invmat *inverta);
+int invertmatthree(struct invmat *mata, struct invmat *inverta);
+int invertmatfour(struct invmat *mata, struct invmat *inverta);
 
-int invertor_by_a(int n, double** mata, double** inverta);
+int invertblocks(int n, struct invmat *mata , struct invmat *inverta, struct invworkspace *ws);
 
-int byamatmul( double** mata, int ma, int na, double** matb, int mb, int nb, double** matres, int mc, int nc);
-int byamatmulthree(double** mata, int ma, int na, double** matb, int mb, int nb, double** matc, int mc, int nc, double** matres, int mres, int nres);
-int byascalarmul(double** mata, int ma, int na, double x);
-int byamatsubtraction( double** mata, int ma, int na, double** matb, int mb, int nb, double** matres, int mc, int nc);
+int invertor_by_a(int n, struct invmat *mata, struct invmat *inverta, struct invworkspace *ws);
+size_t invertorbyaworkspace(int n);
+size_t invertmatworkspace(int n);
+int invertmatws(int n, double** mata, double** inverta, void *work, size_t bytes);
+
+int byamatmulthree(struct invmat *mata, int ma, int na, struct invmat *matb, int mb, int nb, struct invmat *matc, int mc, int nc, struct invmat *matres, int mres, int nres, struct invworkspace *ws);
 
 int invertmat(int n, double** mata, double** inverta)
 {
+	//Adapter for 2 dimensional arrays: one arena of invertmatworkspace(n) bytes is allocated
+	//for the whole inversion and handed to invertmatws.
+        int invertstatus;
+	size_t bytes;
+	void *work;
+
+        if(n<=0) return 0;
+
+	bytes=invertmatworkspace(n);
+	work=malloc(bytes);
+	if(work==NULL)
+	{
+		printf("\nUnable to allocate workspace of %zu bytes for matrix of order %d\n",bytes,n);
+		return 0;
+	}
+	invertstatus=invertmatws(n, mata, inverta, work, bytes);
+	free(work);
+        return invertstatus;
+}
+
+size_t invertmatworkspace(int n)
+{
+	//Bytes of the arena for invertmatws: alignment, the contiguous input and output and the scratch of invertor_by_a.
+	if(n<=0) return 0;
+	return INVMATALIGN+2*invmatbytes(n, n)+invertorbyaworkspace(n);
+}
+
+int invertmatws(int n, double** mata, double** inverta, void *work, size_t bytes)
+{
+	//Input and output are copied through contiguous descriptors carved from work.  No heap allocation is done.
         int invertstatus;
-        int i,j, order;
+	struct invmat mat, invmat;
+	struct invworkspace ws;
 
         if(n<=0) return 0;
 /*
         for(i=0;i<n;i++)
                 for(j=0;j<n;j++)
                         inverta[i][j]=mata[i][j];
-        order = n;
 */
-        invertstatus = invertor_by_a(n, mata, inverta);
+	invwsinit(&ws, work, bytes);
+	if(invmatwsalloc(&ws, &mat, n, n)==0) return 0;
+	if(invmatwsalloc(&ws, &invmat, n, n)==0) return 0;
+	invmatfromrows(&mat, mata);
+
+        invertstatus = invertor_by_a(n, &mat, &invmat, &ws);
 	if(invertstatus==0)
 	{
 		printf("\nUnable to invert matrix of order %d\n",n);
 	}
+	invmattorows(&invmat, inverta);
         return invertstatus;
 }
 
+size_t invertorbyaworkspace(int n)
+{
+	//Bytes of scratch used by invertor_by_a for order n.  Only S is held by a level, while S is inverted;
+	//the buffers of the products are given back after each product.
+	size_t peak, step;
+	int me, ms;
 
-int invertor_by_a(int n, double** mata, double** inverta)
+	if(n<=INVFIXEDMAX) return 0;
+	me=n/2;
+	ms=n-me;
+
+	peak=invertorbyaworkspace(me);
+	step=invwsbytes(invgemmworksize(ms, me, me));	if(step>peak) peak=step;
+	step=invmatbytes(ms, ms)+invwsbytes(invgemmworksize(ms, ms, me));	if(step>peak) peak=step;
+	step=invmatbytes(ms, ms)+invertorbyaworkspace(ms);	if(step>peak) peak=step;
+	step=invwsbytes(invgemmworksize(me, ms, me));	if(step>peak) peak=step;
+	step=invwsbytes(simdrightworksize(ms));		if(step>peak) peak=step;
+	step=invwsbytes(invgemmworksize(me, me, ms));	if(step>peak) peak=step;
+	step=invwsbytes(simdleftworksize(ms));		if(step>peak) peak=step;
+	return peak;
+}
+
+
+int invertor_by_a(int n, struct invmat *mata, struct invmat *inverta, struct invworkspace *ws)
 {
 	int invertstatus;
 	int i,j,k;
@@ -78,14 +142,12 @@ int invertor_by_a(int n, double** mata, double** inverta)
 		case 4:
 			invertstatus=invertmatfour(mata, inverta);
 			break;
-		/*case 5:
-			invertstatus=invertmatfive(mata, inverta);
+		case 5: case 6: case 7: case 8: case 9: case 10: case 11: case 12:
+		case 13: case 14: case 15: case 16:
+			invertstatus=invertfixed(n, MATROW(mata,0), mata->ld, MATROW(inverta,0), inverta->ld);
 			break;
-		case 6:
-			invertstatus=invertmatsix(mata, inverta);
-			break; */
 		default:
-			invertstatus=invertblocks(n, mata, inverta);
+			invertstatus=invertblocks(n, mata, inverta, ws);
 			break;
 	}
 
@@ -93,214 +155,88 @@ int invertor_by_a(int n, double** mata, double** inverta)
 }
 
 
-int invertblocks(int n, double** mata, double** inverta)
+int invertblocks(int n, struct invmat *mata, struct invmat *inverta, struct invworkspace *ws)
 {
+	//The blocks E, F, G, H are views into mata and the four solutions are computed in their final
+	//quadrants of inverta, which also hold the intermediate products.  Only S is kept in the workspace.
+	//	Solution 1 = E^-1 + E^-1 F S^-1 G E^-1	Solution 2 = -E^-1 F S^-1
+	//	Solution 3 = -S^-1 G E^-1		Solution 4 = S^-1,	with S = H - G E^-1 F
 	int invertstatus;
-	int i,j,k;
 	
-
-	double **mate, **matf, **matg, **math, **mats;
-	int me, ne, mf, nf, mg, ng, mh, nh, ms, ns;
-	
-	double **matinve, **matinvs;
-	int minve, ninve, minvs, ninvs;
+	struct invmat mate, matf, matg, math, mats;
+	struct invmat matsol1, matsol2, matsol3, matsol4;
+	int me, ms;
+	size_t mark, inner;
 	
-	double **matsol1, **matsol2, **matsol3, **mattemp1, **mattemp2;
-	int msol1, nsol1, msol2, nsol2, msol3, nsol3, mtemp1, ntemp1, mtemp2, ntemp2;
-
-	
-//	printf("\n We entered n by n inversion function\n");
-		
-	//Preparing the E, F, G, H Matrices
 	me=n/2;
-	ne=n/2;
-	mf=me;
-	nf=n-ne;
-	mg=n-me;
-	ng=ne;
-	mh=n-me;
-	nh=n-ne;
+	ms=n-me;
 	
-	mate=(double **) malloc(me * sizeof(*mate));
-	for(i=0; i<me; i++) mate[i]=(double *)malloc(ne * sizeof(mate[i]));
-
-	matf=(double **) malloc(mf * sizeof(*matf));
-	for(i=0; i<mf; i++) matf[i]=(double *)malloc(nf * sizeof(matf[i]));
-
-	matg=(double **) malloc(mg * sizeof(*matg));
-	for(i=0; i<mg; i++) matg[i]=(double *)malloc(ng * sizeof(matg[i]));
-
-	math=(double **) malloc(mh * sizeof(*math));
-	for(i=0; i<mh; i++) math[i]=(double *)malloc(nh * sizeof(math[i]));
-
-	for(i=0; i<me; i++)
-	{
-		for(j=0; j<ne; j++) mate[i][j]=mata[i][j];
-		for(j=ne; j<n; j++) matf[i][j-ne]=mata[i][j];
-	}
-	for(i=me;i<n;i++)
-	{
-		for(j=0;j<ng;j++) matg[i-me][j]=mata[i][j];
-		for(j=ng;j<n;j++) math[i-me][j-ng]=mata[i][j];
-	}
-	
-/*	
-	
-	printf("\nWe are printint individual matrices here\n");
-	printf("Matrix E\n");
-	for(i=0;i<me;i++)
-	{
-		for(j=0;j<ne;j++) printf("\t%lf",mate[i][j]);
-		printf("\n");
-	}
-	printf("Matrix F\n");
-	for(i=0;i<mf;i++)
+	if(invmatview(&mate, mata, 0, 0, me, me)==0 || invmatview(&matf, mata, 0, me, me, ms)==0
+		|| invmatview(&matg, mata, me, 0, ms, me)==0 || invmatview(&math, mata, me, me, ms, ms)==0
+		|| invmatview(&matsol1, inverta, 0, 0, me, me)==0 || invmatview(&matsol2, inverta, 0, me, me, ms)==0
+		|| invmatview(&matsol3, inverta, me, 0, ms, me)==0 || invmatview(&matsol4, inverta, me, me, ms, ms)==0)
 	{
-		for(j=0;j<nf;j++) printf("\t%lf",matf[i][j]);
-		printf("\n");
-	}
-	printf("Matrix G\n");
-	for(i=0;i<mg;i++)
-	{
-		for(j=0;j<ng;j++) printf("\t%lf",matg[i][j]);
-		printf("\n");
-	}
-	printf("Matrix H\n");
-	for(i=0;i<mh;i++)
-	{
-		for(j=0;j<nh;j++) printf("\t%lf",math[i][j]);
-		printf("\n");
+		printf("\nUnable to partition the matrix of order n = %d\n",n);
+		return 0;
 	}
-
-
-*/
-
-	//Calculating E^-1 and freeing E	
-	minve = me;
-	ninve = ne;
 	
-	matinve=(double **) malloc(minve * sizeof(*matinve));
-	for(i=0; i<minve; i++) matinve[i]=(double *)malloc(ninve * sizeof(matinve[i]));
+	mark=invwsmark(ws);
 	
-	invertstatus=invertor_by_a(me, mate, matinve);
+	//Calculating E^-1 at the place of Solution 1
+	invertstatus=invertor_by_a(me, &mate, &matsol1, ws);
 	if(invertstatus==0)
         {
                 printf("\nUnable to invert matrix of order me = %d\n",me);
+		return 0;
         }
-
-//	printf("\n we finished mate inversion\n");	
-	for(i=0;i<me;i++) free(mate[i]); free(mate);
 	
-	//Calculating S 
-	ms=mh;
-	ns=nh;
-
-	mats=(double **) malloc(ms * sizeof(*mats));
-	for(i=0; i<ms; i++) mats[i]=(double *)malloc(ns * sizeof(mats[i]));
-		
-	mtemp1=ms;
-	ntemp1=ns;
-	
-	mattemp1=(double **) malloc(mtemp1 * sizeof(*mattemp1));
-	for(i=0; i<mtemp1; i++) mattemp1[i]=(double *)malloc(ntemp1 * sizeof(mattemp1[i]));
-
-	byamatmulthree(matg, mg, ng, matinve, minve, ninve, matf, mf, nf, mattemp1, mtemp1, ntemp1);
-
-//	printf("\n we finished multiplication of g e^-1 f\n");	
-	byamatsubtraction(math, mh, nh, mattemp1, mtemp1, ntemp1, mats, ms, ns);
-	
-//	printf("\n we finished mats calculation\n");
-		
-	for(i=0;i<mtemp1;i++) free(mattemp1[i]); free(mattemp1);	
-
-
-	//Calculating S^-1 and freeing S
-	minvs=ms;
-	ninvs=ns;
-	
-	matinvs=(double **) malloc(minvs * sizeof(*matinvs));
-	for(i=0; i<minvs; i++) matinvs[i]=(double *)malloc(ninvs * sizeof(matinvs[i]));
-
-	invertstatus=invertor_by_a(ms,mats, matinvs);
+	//G E^-1 at the place of Solution 3
+	inner=invwsmark(ws);
+	invgemm(ms, me, me, 1.0, matg.data, matg.ld, matsol1.data, matsol1.ld, 0.0, matsol3.data, matsol3.ld, invwsdoubles(ws, invgemmworksize(ms, me, me)));
+	invwsrelease(ws, inner);
+	
+	//Calculating S = H - (G E^-1) F
+	if(invmatwsalloc(ws, &mats, ms, ms)==0) return 0;
+	invmatcopy(&mats, &math);
+	inner=invwsmark(ws);
+	invgemm(ms, ms, me, -1.0, matsol3.data, matsol3.ld, matf.data, matf.ld, 1.0, mats.data, mats.ld, invwsdoubles(ws, invgemmworksize(ms, ms, me)));
+	invwsrelease(ws, inner);
+	
+	//Calculating S^-1 at the place of Solution 4 and giving back S
+	invertstatus=invertor_by_a(ms, &mats, &matsol4, ws);
+	invmatfree(&mats);
+	invwsrelease(ws, mark);
 	if(invertstatus==0)
         {
                 printf("\nUnable to invert matrix of order ms= %d\n",ms);
+		return 0;
         }
-
-	//S^-1 calculated so we free S
-	for(i=0;i<ms;i++) free(mats[i]); free(mats);
 	
-	//At this time we have E^-1, S^-1.  This S^-1 is Solution 4.
-	//We have to prepare other three solutions.
-	//Preparing Solution 3
-	msol3=mg;
-	nsol3=ng;
+	PERFBEGIN(INVPERFASSEMBLY);
+	//Solution 2: -E^-1 F, then multiplied on the right by S^-1
+	inner=invwsmark(ws);
+	invgemm(me, ms, me, -1.0, matsol1.data, matsol1.ld, matf.data, matf.ld, 0.0, matsol2.data, matsol2.ld, invwsdoubles(ws, invgemmworksize(me, ms, me)));
+	invwsrelease(ws, inner);
+	simdrightmatmul(me, ms, matsol2.data, matsol2.ld, matsol4.data, matsol4.ld, invwsdoubles(ws, simdrightworksize(ms)));
+	invwsrelease(ws, inner);
 	
-	matsol3=(double **) malloc(msol3 * sizeof(*matsol3));
-	for(i=0; i<msol3; i++) matsol3[i]=(double *)malloc(nsol3 * sizeof(matsol3[i]));	
-
-	byamatmulthree(matinvs, minvs, ninvs, matg, mg, ng, matinve, minve, ninve, matsol3, msol3, nsol3);
+	//Solution 1: E^-1 + (E^-1 F S^-1) (G E^-1) = E^-1 - Solution 2 * (G E^-1)
+	invgemm(me, me, ms, -1.0, matsol2.data, matsol2.ld, matsol3.data, matsol3.ld, 1.0, matsol1.data, matsol1.ld, invwsdoubles(ws, invgemmworksize(me, me, ms)));
+	invwsrelease(ws, inner);
 	
-	byascalarmul(matsol3, msol3, nsol3, (double) -1.0);
-
-	//At this time We have S^-1 which is solution 4 and Solution 3.
-	//Preparing Solution 2
-	msol2=mf;
-	nsol2=nf;
+	//Solution 3: -S^-1 (G E^-1), computed in place
+	simdleftmatmul(ms, me, matsol4.data, matsol4.ld, matsol3.data, matsol3.ld, invwsdoubles(ws, simdleftworksize(ms)));
+	invwsrelease(ws, inner);
+	PERFEND(INVPERFASSEMBLY);
 	
-	matsol2=(double **) malloc(msol2 * sizeof(*matsol2));
-	for(i=0; i<msol2; i++) matsol2[i]=(double *)malloc(nsol2 * sizeof(matsol2[i]));	
-
-	byamatmulthree(matinve, minve, ninve, matf, mf, nf, matinvs, minvs, ninvs, matsol2, msol2, nsol2);
-
-	byascalarmul(matsol2, msol2, nsol2, (double) -1.0);
-
-	//Preparing Solution 1
-	msol1=me;
-	nsol1=ne;
-	
-	matsol1=(double **) malloc(msol1 * sizeof(*matsol1));
-	for(i=0; i<msol1; i++) matsol1[i]=(double *)malloc(nsol1 * sizeof(matsol1[i]));	
-	
-	mtemp1=msol1;
-	ntemp1=nsol1;	
-	
-	mattemp1=(double **) malloc(mtemp1 * sizeof(*mattemp1));
-	for(i=0;i<mtemp1;i++) mattemp1[i]=(double *)malloc(ntemp1 * sizeof(mattemp1[i]));
-
-	byamatmulthree(matinve, minve, ninve, matf, mf, nf, matsol3, msol3, nsol3, mattemp1, mtemp1, ntemp1);
-	
-	byamatsubtraction(matinve, minve, ninve, mattemp1, mtemp1, ntemp1, matsol1, msol1, nsol1);
-		
-	for(i=0;i<mtemp1;i++) free(mattemp1[i]); free(mattemp1);
-
-
-	//Preparing Full solution
-	for(i=0;i<me;i++)
-	{
-		for(j=0;j<ne;j++) inverta[i][j]=matsol1[i][j];
-		for(j=ne;j<n;j++) inverta[i][j]=matsol2[i][j-ne];
-	}
-	for(i=me;i<n;i++)
-	{
-		for(j=0;j<ne;j++) inverta[i][j]=matsol3[i-me][j];
-		for(j=ne;j<n;j++) inverta[i][j]=matinvs[i-me][j-ne];
-	}
-
-	for(i=0;i<minvs;i++) free(matinvs[i]); free(matinvs);
-	for(i=0;i<msol1;i++) free(matsol1[i]); free(matsol1);	
-	for(i=0;i<msol2;i++) free(matsol2[i]); free(matsol2);	
-	for(i=0;i<msol3;i++) free(matsol3[i]); free(matsol3);	
-						 	
 	return 1;
-	
 }
 
-int invertmatone(double** mata, double** inverta)
+int invertmatone(struct invmat *mata, struct invmat *inverta)
 {
 	int n=1;
 	double modmata;
-	modmata=mata[0][0];
+	modmata=MATEL(mata,0,0);
 	
 	if(modmata==0) 
 	{
@@ -308,18 +244,18 @@ int invertmatone(double** mata, double** inverta)
 		return 0;
 	}
 
-	inverta[0][0]=1/modmata;
+	MATEL(inverta,0,0)=1/modmata;
 	
 	return 1;
 }
 
-int invertmattwo(double** mata, double** inverta)
+int invertmattwo(struct invmat *mata, struct invmat *inverta)
 {
 	int n=2;
 
 	double modmata;
-	double a11=mata[0][0], a12=mata[0][1];
-	double a21=mata[1][0], a22=mata[1][1];
+	double a11=MATEL(mata,0,0), a12=MATEL(mata,0,1);
+	double a21=MATEL(mata,1,0), a22=MATEL(mata,1,1);
 	
 	modmata=(-(a12*a21) + a11*a22);
 	
@@ -330,22 +266,22 @@ int invertmattwo(double** mata, double** inverta)
 	}
 
 	
-	inverta[0][0]=a22/modmata;
-	inverta[0][1]=-(a12/modmata);
-	inverta[1][0]=-(a21/modmata);
-	inverta[1][1]=a11/modmata;
+	MATEL(inverta,0,0)=a22/modmata;
+	MATEL(inverta,0,1)=-(a12/modmata);
+	MATEL(inverta,1,0)=-(a21/modmata);
+	MATEL(inverta,1,1)=a11/modmata;
 	
 	return 1;
 }
 
-int invertmatthree(double** mata, double** inverta)
+int invertmatthree(struct invmat *mata, struct invmat *inverta)
 {
 	int n=3;
 
 	double modmata;
-	double a11=mata[0][0], a12=mata[0][1], a13=mata[0][2];
-	double a21=mata[1][0], a22=mata[1][1], a23=mata[1][2];
-	double a31=mata[2][0], a32=mata[2][1], a33=mata[2][2];
+	double a11=MATEL(mata,0,0), a12=MATEL(mata,0,1), a13=MATEL(mata,0,2);
+	double a21=MATEL(mata,1,0), a22=MATEL(mata,1,1), a23=MATEL(mata,1,2);
+	double a31=MATEL(mata,2,0), a32=MATEL(mata,2,1), a33=MATEL(mata,2,2);
 	
 	modmata=(-(a13*a22*a31) + a12*a23*a31 + a13*a21*a32 - a11*a23*a32 - a12*a21*a33 + a11*a22*a33);
 	
@@ -356,36 +292,36 @@ int invertmatthree(double** mata, double** inverta)
 	}
 
 	
-	inverta[0][0]=(-(a23*a32) + a22*a33)/modmata;
+	MATEL(inverta,0,0)=(-(a23*a32) + a22*a33)/modmata;
 	
-	inverta[0][1]=(a13*a32 - a12*a33)/modmata;
+	MATEL(inverta,0,1)=(a13*a32 - a12*a33)/modmata;
 	
-	inverta[0][2]=(-(a13*a22) + a12*a23)/modmata;
+	MATEL(inverta,0,2)=(-(a13*a22) + a12*a23)/modmata;
 	
-	inverta[1][0]=(a23*a31 - a21*a33)/modmata;
+	MATEL(inverta,1,0)=(a23*a31 - a21*a33)/modmata;
 	
-	inverta[1][1]=(-(a13*a31) + a11*a33)/modmata;
+	MATEL(inverta,1,1)=(-(a13*a31) + a11*a33)/modmata;
 	
-	inverta[1][2]=(a13*a21 - a11*a23)/modmata;
+	MATEL(inverta,1,2)=(a13*a21 - a11*a23)/modmata;
 	
-	inverta[2][0]=(-(a22*a31) + a21*a32)/modmata;
+	MATEL(inverta,2,0)=(-(a22*a31) + a21*a32)/modmata;
 	
-	inverta[2][1]=(a12*a31 - a11*a32)/modmata;
+	MATEL(inverta,2,1)=(a12*a31 - a11*a32)/modmata;
 	
-	inverta[2][2]=(-(a12*a21) + a11*a22)/modmata;
+	MATEL(inverta,2,2)=(-(a12*a21) + a11*a22)/modmata;
 
 	return 1;
 }
 
-int invertmatfour(double** mata, double** inverta)
+int invertmatfour(struct invmat *mata, struct invmat *inverta)
 {
 	int n=4;
 
 	double modmata;
-	double a11=mata[0][0], a12=mata[0][1], a13=mata[0][2], a14=mata[0][3];
-	double a21=mata[1][0], a22=mata[1][1], a23=mata[1][2], a24=mata[1][3];
-	double a31=mata[2][0], a32=mata[2][1], a33=mata[2][2], a34=mata[2][3];
-	double a41=mata[3][0], a42=mata[3][1], a43=mata[3][2], a44=mata[3][3];
+	double a11=MATEL(mata,0,0), a12=MATEL(mata,0,1), a13=MATEL(mata,0,2), a14=MATEL(mata,0,3);
+	double a21=MATEL(mata,1,0), a22=MATEL(mata,1,1), a23=MATEL(mata,1,2), a24=MATEL(mata,1,3);
+	double a31=MATEL(mata,2,0), a32=MATEL(mata,2,1), a33=MATEL(mata,2,2), a34=MATEL(mata,2,3);
+	double a41=MATEL(mata,3,0), a42=MATEL(mata,3,1), a43=MATEL(mata,3,2), a44=MATEL(mata,3,3);
 	
 	
 	modmata=(a14*a23*a32*a41 - a13*a24*a32*a41 - a14*a22*a33*a41 + a12*a24*a33*a41 + a13*a22*a34*a41 - a12*a23*a34*a41 - a14*a23*a31*a42 + a13*a24*a31*a42 + a14*a21*a33*a42 - a11*a24*a33*a42 - a13*a21*a34*a42 + a11*a23*a34*a42 + a14*a22*a31*a43 - a12*a24*a31*a43 - a14*a21*a32*a43 + a11*a24*a32*a43 + a12*a21*a34*a43 - a11*a22*a34*a43 - a13*a22*a31*a44 + a12*a23*a31*a44 + a13*a21*a32*a44 - a11*a23*a32*a44 - a12*a21*a33*a44 + a11*a22*a33*a44);
@@ -397,92 +333,59 @@ int invertmatfour(double** mata, double** inverta)
 	}
 
 
-	inverta[0][0]=(-(a24*a33*a42) + a23*a34*a42 + a24*a32*a43 - a22*a34*a43 - a23*a32*a44 + a22*a33*a44)/modmata;
+	MATEL(inverta,0,0)=(-(a24*a33*a42) + a23*a34*a42 + a24*a32*a43 - a22*a34*a43 - a23*a32*a44 + a22*a33*a44)/modmata;
 	
-	inverta[0][1]=(a14*a33*a42 - a13*a34*a42 - a14*a32*a43 + a12*a34*a43 + a13*a32*a44 - a12*a33*a44)/modmata;
+	MATEL(inverta,0,1)=(a14*a33*a42 - a13*a34*a42 - a14*a32*a43 + a12*a34*a43 + a13*a32*a44 - a12*a33*a44)/modmata;
 	
-	inverta[0][2]=(-(a14*a23*a42) + a13*a24*a42 + a14*a22*a43 - a12*a24*a43 - a13*a22*a44 + a12*a23*a44)/modmata;
+	MATEL(inverta,0,2)=(-(a14*a23*a42) + a13*a24*a42 + a14*a22*a43 - a12*a24*a43 - a13*a22*a44 + a12*a23*a44)/modmata;
 	
-	inverta[0][3]=(a14*a23*a32 - a13*a24*a32 - a14*a22*a33 + a12*a24*a33 + a13*a22*a34 - a12*a23*a34)/modmata;
+	MATEL(inverta,0,3)=(a14*a23*a32 - a13*a24*a32 - a14*a22*a33 + a12*a24*a33 + a13*a22*a34 - a12*a23*a34)/modmata;
 	
-	inverta[1][0]= (a24*a33*a41 - a23*a34*a41 - a24*a31*a43 + a21*a34*a43 + a23*a31*a44 - a21*a33*a44)/modmata;
+	MATEL(inverta,1,0)= (a24*a33*a41 - a23*a34*a41 - a24*a31*a43 + a21*a34*a43 + a23*a31*a44 - a21*a33*a44)/modmata;
 	
-	inverta[1][1]=(-(a14*a33*a41) + a13*a34*a41 + a14*a31*a43 - a11*a34*a43 - a13*a31*a44 + a11*a33*a44)/modmata;
+	MATEL(inverta,1,1)=(-(a14*a33*a41) + a13*a34*a41 + a14*a31*a43 - a11*a34*a43 - a13*a31*a44 + a11*a33*a44)/modmata;
 	
-	inverta[1][2]=(a14*a23*a41 - a13*a24*a41 - a14*a21*a43 + a11*a24*a43 + a13*a21*a44 - a11*a23*a44)/modmata;
+	MATEL(inverta,1,2)=(a14*a23*a41 - a13*a24*a41 - a14*a21*a43 + a11*a24*a43 + a13*a21*a44 - a11*a23*a44)/modmata;
 	
-	inverta[1][3]=(-(a14*a23*a31) + a13*a24*a31 + a14*a21*a33 - a11*a24*a33 - a13*a21*a34 + a11*a23*a34)/modmata;
+	MATEL(inverta,1,3)=(-(a14*a23*a31) + a13*a24*a31 + a14*a21*a33 - a11*a24*a33 - a13*a21*a34 + a11*a23*a34)/modmata;
 	
-	inverta[2][0]=(-(a24*a32*a41) + a22*a34*a41 + a24*a31*a42 - a21*a34*a42 - a22*a31*a44 + a21*a32*a44)/modmata;
+	MATEL(inverta,2,0)=(-(a24*a32*a41) + a22*a34*a41 + a24*a31*a42 - a21*a34*a42 - a22*a31*a44 + a21*a32*a44)/modmata;
 	
-	inverta[2][1]=(a14*a32*a41 - a12*a34*a41 - a14*a31*a42 + a11*a34*a42 + a12*a31*a44 - a11*a32*a44)/modmata;
+	MATEL(inverta,2,1)=(a14*a32*a41 - a12*a34*a41 - a14*a31*a42 + a11*a34*a42 + a12*a31*a44 - a11*a32*a44)/modmata;
 	
-	inverta[2][2]=(-(a14*a22*a41) + a12*a24*a41 + a14*a21*a42 - a11*a24*a42 - a12*a21*a44 + a11*a22*a44)/modmata;
+	MATEL(inverta,2,2)=(-(a14*a22*a41) + a12*a24*a41 + a14*a21*a42 - a11*a24*a42 - a12*a21*a44 + a11*a22*a44)/modmata;
 	
-	inverta[2][3]=(a14*a22*a31 - a12*a24*a31 - a14*a21*a32 + a11*a24*a32 + a12*a21*a34 - a11*a22*a34)/modmata;
+	MATEL(inverta,2,3)=(a14*a22*a31 - a12*a24*a31 - a14*a21*a32 + a11*a24*a32 + a12*a21*a34 - a11*a22*a34)/modmata;
 	
-	inverta[3][0]=(a23*a32*a41 - a22*a33*a41 - a23*a31*a42 + a21*a33*a42 + a22*a31*a43 - a21*a32*a43)/modmata;
+	MATEL(inverta,3,0)=(a23*a32*a41 - a22*a33*a41 - a23*a31*a42 + a21*a33*a42 + a22*a31*a43 - a21*a32*a43)/modmata;
 	
-	inverta[3][1]=(-(a13*a32*a41) + a12*a33*a41 + a13*a31*a42 - a11*a33*a42 - a12*a31*a43 + a11*a32*a43)/modmata;
+	MATEL(inverta,3,1)=(-(a13*a32*a41) + a12*a33*a41 + a13*a31*a42 - a11*a33*a42 - a12*a31*a43 + a11*a32*a43)/modmata;
 	
-	inverta[3][2]=(a13*a22*a41 - a12*a23*a41 - a13*a21*a42 + a11*a23*a42 + a12*a21*a43 - a11*a22*a43)/modmata;
+	MATEL(inverta,3,2)=(a13*a22*a41 - a12*a23*a41 - a13*a21*a42 + a11*a23*a42 + a12*a21*a43 - a11*a22*a43)/modmata;
 	
-	inverta[3][3]=(-(a13*a22*a31) + a12*a23*a31 + a13*a21*a32 - a11*a23*a32 - a12*a21*a33 + a11*a22*a33)/modmata;
+	MATEL(inverta,3,3)=(-(a13*a22*a31) + a12*a23*a31 + a13*a21*a32 - a11*a23*a32 - a12*a21*a33 + a11*a22*a33)/modmata;
 
 	return 1;
 }
-int byamatmul( double** mata, int ma, int na, double** matb, int mb, int nb, double** matres, int mc, int nc)
+int byamatmulthree(struct invmat *mata, int ma, int na, struct invmat *matb, int mb, int nb, struct invmat *matc, int mc, int nc, struct invmat *matres, int mres, int nres, struct invworkspace *ws)
 {
-	int i,j,k,l;
-	if(na!=mb) return 0;
-
-	for(i=0;i<ma;i++)
-		for(j=0;j<nb;j++)
-			for(matres[i][j]=k=0;k<na;k++)
-				matres[i][j]+=mata[i][k]*matb[k][j];
-	return 1;
-}
-
-int byamatmulthree(double** mata, int ma, int na, double** matb, int mb, int nb, double** matc, int mc, int nc, double** matres, int mres, int nres)
-{
-	int i;
-	double **tempmat;
-
-	tempmat = (double **) malloc( ma * sizeof(double *));
-	for(i=0;i<ma;i++) tempmat[i]=(double *) malloc(nb * sizeof(double));
-
-	i=byamatmul(mata, ma, na, matb, mb, nb, tempmat, ma, nb);
-	if(i==0) return 0;
-
-	i=byamatmul(tempmat, ma, nb, matc, mc, nc, matres, ma, nc);
-	if(i==0) return 0;
-
-	for(i=0;i<ma;i++) free(tempmat[i]);
-	free(tempmat);
-	return 1;
-}
-
-
-int byascalarmul(double** mata, int ma, int na, double x)
-{
-	int i,j;
-	for(i=0;i<ma;i++)
-		for(j=0;j<na;j++)
-			mata[i][j]*=x;
-	return 1;
-}
-
-
-
-int byamatsubtraction( double** mata, int ma, int na, double** matb, int mb, int nb, double** matres, int mc, int nc)
-{
-	int i,j,k,l;
-	if(ma!=mb) return 0;
-
-	for(i=0;i<ma;i++)
-		for(j=0;j<na;j++)
-				matres[i][j]=mata[i][j]-matb[i][j];
-	return 1;
+	//matres (ma * nc) := mata (ma * na) * matb (mb * nb) * matc (mc * nc), through a temporary (ma * nb) in ws.
+	int status;
+	struct invmat tempmat;
+	size_t mark, inner;
+
+	if(na!=mb || nb!=mc || mres!=ma || nres!=nc) return 0;
+	mark=invwsmark(ws);
+	if(invmatwsalloc(ws, &tempmat, ma, nb)==0) return 0;
+
+	inner=invwsmark(ws);
+	status=invgemm(ma, nb, na, 1.0, mata->data, mata->ld, matb->data, matb->ld, 0.0, tempmat.data, tempmat.ld, invwsdoubles(ws, invgemmworksize(ma, nb, na)));
+	invwsrelease(ws, inner);
+	if(status==1) status=invgemm(ma, nc, nb, 1.0, tempmat.data, tempmat.ld, matc->data, matc->ld, 0.0, matres->data, matres->ld, invwsdoubles(ws, invgemmworksize(ma, nc, nb)));
+
+	invmatfree(&tempmat);
+	invwsrelease(ws, mark);
+	return status;
 }
 
 
@@ -23,37 +23,153 @@
 
 #include<stdlib.h>
 
+#include "invertor_matrix.c"
+#include "invertor_gemm.c"
+#include "invertor_simd.c"
+#include "invertor_leaf.c"
+#include "invertor_perf.c"
+
+//With OpenMP, the A and D halves of invertblockaandd run as two concurrent tasks at every level
+//of order ADTASKCUTOFF and above.  Below it the halves run one after the other.
+#define ADTASKCUTOFF 256
+
 //int invertblocks(int n, double** mata , double** inverta);
 
-int invertinplace(int order, double** mat, int pos);
-int inplaceblocksbya(int order, double** mat, int pos);
-int inplaceblocksbyd(int order, double** mat, int pos);
-int inplaceleftmatmul(double** mat, int ordera, int aposmn, int nb, int bposm, int bposn);
-int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm, int aposn);
-int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym);
-
-int invertbyaandd(int order, double** mat, double** invertmat, int pos);
-int invertblockaandd(int order, double** mat, double** invertmat, int pos);
-int schurcompforad(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym);
-int schurad(double** mat, double** invertmat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym);
+int invertinplace(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+int inplaceblocksbya(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+int inplaceblocksbyd(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+int inplaceleftmatmul(struct invmat *mat, int ordera, int aposmn, int nb, int bposm, int bposn, struct invworkspace *ws);
+int inplacerightmatmul(struct invmat *mat, int orderb, int bposmn, int ma, int aposm, int aposn, struct invworkspace *ws);
+int schurcomplement(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws);
+
+int invertbyaandd(int order, struct invmat *mat, struct invmat *invertmat, int pos, struct invworkspace *ws);
+int invertblockaandd(int order, struct invmat *mat, struct invmat *invertmat, int pos, struct invworkspace *ws);
+int schurcompforad(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws);
+int schurad(struct invmat *mat, struct invmat *invertmat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws);
+size_t invertinplaceworkspace(int order);
+int inplaceleaf(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+size_t inplaceleafworkspace(int order);
+size_t invertbyaanddworkspace(int order);
+size_t invertmatworkspace(int n);
+size_t invertmatthreadsworkspace(int n, int threads);
+int invertmatws(int n, double** mata, double** inverta, void *work, size_t bytes);
 int invertmat(int n, double** mata, double** inverta)
 {
+	//Adapter for 2 dimensional arrays: one arena of invertmatworkspace(n) bytes is allocated
+	//for the whole inversion and handed to invertmatws.
 	int invertstatus;
-	int i,j, order;
+	size_t bytes;
+	void *work;
+	
+	if(n<=0) return 0;
+	
+	bytes=invertmatworkspace(n);
+	work=malloc(bytes);
+	if(work==NULL)
+	{
+		printf("\nUnable to allocate workspace of %zu bytes for the matrix of order = %d\n",bytes,n);
+		return 0;
+	}
+	invertstatus=invertmatws(n, mata, inverta, work, bytes);
+	free(work);
+	return invertstatus;
+}
+
+size_t invertmatworkspace(int n)
+{
+	//Bytes of the arena for invertmatws: alignment, the two contiguous copies of the matrix and the scratch of invertbyaandd
+	//for each of the invthreads() threads.  Call it with the same number of OpenMP threads as invertmatws.
+	return invertmatthreadsworkspace(n, invthreads());
+}
+
+size_t invertmatthreadsworkspace(int n, int threads)
+{
+	//As invertmatworkspace for threads OpenMP threads.
+	if(n<=0) return 0;
+	if(threads<1) threads=1;
+	return INVMATALIGN+2*invmatbytes(n, n)+invwsthreadsbytes(threads, invertbyaanddworkspace(n));
+}
+
+int invertmatws(int n, double** mata, double** inverta, void *work, size_t bytes)
+{
+	//The input is kept in one descriptor and its copy in a second descriptor is worked upon,
+	//then copied back to inverta.  Both descriptors and all scratch are carved from work.
+	//With OpenMP the recursion runs as tasks of a team of invthreads() threads, each with its own arena.
+	int invertstatus;
+	int order, threads;
+	struct invmat mat, invmat;
+	struct invworkspace ws, *arenas;
 	
 	if(n<=0) return 0;
 	
-	for(i=0;i<n;i++)
-		for(j=0;j<n;j++)
-			inverta[i][j]=mata[i][j];
 	order = n;
+	threads = invthreads();
+	invwsinit(&ws, work, bytes);
+	if(invmatwsalloc(&ws, &mat, order, order)==0) return 0;
+	if(invmatwsalloc(&ws, &invmat, order, order)==0) return 0;
+	arenas = invwsthreads(&ws, threads, invertbyaanddworkspace(order));
+	if(arenas==NULL) return 0;
+	invmatfromrows(&mat, mata);
+	invmatfromrows(&invmat, mata);
 	
 	//order=2;
 //	invertstatus = invertinplace(order, inverta, 0);
-	invertstatus = invertbyaandd(order, mata, inverta, 0);
+	#pragma omp parallel num_threads(threads) if(threads>1 && order>=ADTASKCUTOFF)
+	#pragma omp single
+	invertstatus = invertbyaandd(order, &mat, &invmat, 0, arenas);
+	invmattorows(&invmat, inverta);
 	return invertstatus;
 }
-int invertbyaandd(int order, double** mat, double** invertmat, int pos)
+
+size_t invertbyaanddworkspace(int order)
+{
+	//Bytes of scratch used by invertbyaandd for this order: the largest over the steps of every level.
+	//schurad holds the product X * Y while it multiplies by the block, the other steps only kernel buffers.
+	size_t size, step;
+	int ordera, orderd;
+	
+	if(order<=3) return 0;
+	if(order<=invleaforder()) return inplaceleafworkspace(order);
+	ordera=order/2;
+	orderd=order-ordera;
+	
+	size=invertbyaanddworkspace(ordera);
+	step=invertbyaanddworkspace(orderd);		if(step>size) size=step;
+	step=invertinplaceworkspace(ordera);		if(step>size) size=step;
+	step=invertinplaceworkspace(orderd);		if(step>size) size=step;
+	step=invwsbytes(simdleftworksize(ordera));	if(step>size) size=step;
+	step=invwsbytes(simdleftworksize(orderd));	if(step>size) size=step;
+	step=invwsbytes(simdrightworksize(ordera));	if(step>size) size=step;
+	step=invwsbytes(simdrightworksize(orderd));	if(step>size) size=step;
+	step=invmatbytes(ordera, ordera)+invwsbytes(invgemmworksize(ordera, ordera, (orderd>ordera)?orderd:ordera));	if(step>size) size=step;
+	step=invmatbytes(orderd, orderd)+invwsbytes(invgemmworksize(orderd, orderd, orderd));	if(step>size) size=step;
+	return size;
+}
+
+size_t invertinplaceworkspace(int order)
+{
+	//Bytes of scratch used by invertinplace for this order.  The kernels of a step give their buffers back
+	//at the end of the step, so this is the largest buffer of any step at any level of the recursion.
+	size_t size, step;
+	int ordera, orderd;
+	
+	if(order<=3) return 0;
+	if(order<=invleaforder()) return inplaceleafworkspace(order);
+	ordera=order/2;
+	orderd=order-ordera;
+	
+	size=invertinplaceworkspace(ordera);
+	step=invertinplaceworkspace(orderd);		if(step>size) size=step;
+	step=invwsbytes(simdleftworksize(ordera));	if(step>size) size=step;
+	step=invwsbytes(simdleftworksize(orderd));	if(step>size) size=step;
+	step=invwsbytes(simdrightworksize(ordera));	if(step>size) size=step;
+	step=invwsbytes(simdrightworksize(orderd));	if(step>size) size=step;
+	step=invwsbytes(invgemmworksize(orderd, orderd, ordera));	if(step>size) size=step;
+	step=invwsbytes(invgemmworksize(ordera, ordera, orderd));	if(step>size) size=step;
+	return size;
+}
+
+int invertbyaandd(int order, struct invmat *mat, struct invmat *invertmat, int pos, struct invworkspace *ws)
 {
 	int invertstatus;
 	double modmat, a11, a12, a13, a21, a22, a23, a31, a32, a33;
@@ -61,66 +177,66 @@ int invertbyaandd(int order, double** mat, double** invertmat, int pos)
 	switch(order)
 	{
 		case 1:
-			if (mat[pos][pos]==0) return 0;
+			if (MATEL(mat,pos,pos)==0) return 0;
 			else 
 				{
-					invertmat[pos][pos]/=(invertmat[pos][pos]*invertmat[pos][pos]);
+					MATEL(invertmat,pos,pos)/=(MATEL(invertmat,pos,pos)*MATEL(invertmat,pos,pos));
 					invertstatus=1;
 				}
 			break;
 		case 2:
 		
-			modmat=(-(invertmat[pos+0][pos+1]*invertmat[pos+1][pos+0]) + invertmat[pos+0][pos+0]*invertmat[pos+1][pos+1]);
+			modmat=(-(MATEL(invertmat,pos+0,pos+1)*MATEL(invertmat,pos+1,pos+0)) + MATEL(invertmat,pos+0,pos+0)*MATEL(invertmat,pos+1,pos+1));
 			if(modmat==0) return 0;
 	
-			invertmat[pos+1][pos+1]*=invertmat[pos+0][pos+0]/modmat;
+			MATEL(invertmat,pos+1,pos+1)*=MATEL(invertmat,pos+0,pos+0)/modmat;
 			
-			invertmat[pos+0][pos+0]=(invertmat[pos+1][pos+1]/invertmat[pos+0][pos+0]);
-			invertmat[pos+0][pos+1]/=(-1*modmat);
-			invertmat[pos+1][pos+0]/=(-1*modmat);
-			invertmat[pos+1][pos+1]/=(invertmat[pos+0][pos+0]*modmat);
+			MATEL(invertmat,pos+0,pos+0)=(MATEL(invertmat,pos+1,pos+1)/MATEL(invertmat,pos+0,pos+0));
+			MATEL(invertmat,pos+0,pos+1)/=(-1*modmat);
+			MATEL(invertmat,pos+1,pos+0)/=(-1*modmat);
+			MATEL(invertmat,pos+1,pos+1)/=(MATEL(invertmat,pos+0,pos+0)*modmat);
 			invertstatus=1;
 			break;
 		case 3:
-			a11=invertmat[pos+0][pos+0];
-			a12=invertmat[pos+0][pos+1];
-			a13=invertmat[pos+0][pos+2];
-			a21=invertmat[pos+1][pos+0];
-			a22=invertmat[pos+1][pos+1];
-			a23=invertmat[pos+1][pos+2];
-			a31=invertmat[pos+2][pos+0];
-			a32=invertmat[pos+2][pos+1];
-			a33=invertmat[pos+2][pos+2];
+			a11=MATEL(invertmat,pos+0,pos+0);
+			a12=MATEL(invertmat,pos+0,pos+1);
+			a13=MATEL(invertmat,pos+0,pos+2);
+			a21=MATEL(invertmat,pos+1,pos+0);
+			a22=MATEL(invertmat,pos+1,pos+1);
+			a23=MATEL(invertmat,pos+1,pos+2);
+			a31=MATEL(invertmat,pos+2,pos+0);
+			a32=MATEL(invertmat,pos+2,pos+1);
+			a33=MATEL(invertmat,pos+2,pos+2);
 			
 			modmat=(-(a13*a22*a31) + a12*a23*a31 + a13*a21*a32 - a11*a23*a32 - a12*a21*a33 + a11*a22*a33);
 			if(modmat==0) return 0;
 	
-			invertmat[pos+0][pos+0]=(-(a23*a32) + a22*a33)/modmat;
-			invertmat[pos+0][pos+1]=(a13*a32 - a12*a33)/modmat;			
-			invertmat[pos+0][pos+2]=(-(a13*a22) + a12*a23)/modmat;
-			invertmat[pos+1][pos+0]=(a23*a31 - a21*a33)/modmat;
-			invertmat[pos+1][pos+1]=(-(a13*a31) + a11*a33)/modmat;
-			invertmat[pos+1][pos+2]=(a13*a21 - a11*a23)/modmat;
-			invertmat[pos+2][pos+0]=(-(a22*a31) + a21*a32)/modmat;
-			invertmat[pos+2][pos+1]=(a12*a31 - a11*a32)/modmat;
-			invertmat[pos+2][pos+2]=(-(a12*a21) + a11*a22)/modmat; 
-
+			MATEL(invertmat,pos+0,pos+0)=(-(a23*a32) + a22*a33)/modmat;
+			MATEL(invertmat,pos+0,pos+1)=(a13*a32 - a12*a33)/modmat;			
+			MATEL(invertmat,pos+0,pos+2)=(-(a13*a22) + a12*a23)/modmat;
+			MATEL(invertmat,pos+1,pos+0)=(a23*a31 - a21*a33)/modmat;
+			MATEL(invertmat,pos+1,pos+1)=(-(a13*a31) + a11*a33)/modmat;
+			MATEL(invertmat,pos+1,pos+2)=(a13*a21 - a11*a23)/modmat;
+			MATEL(invertmat,pos+2,pos+0)=(-(a22*a31) + a21*a32)/modmat;
+			MATEL(invertmat,pos+2,pos+1)=(a12*a31 - a11*a32)/modmat;
+			MATEL(invertmat,pos+2,pos+2)=(-(a12*a21) + a11*a22)/modmat; 
+			invertstatus=1;
 			break;
 		default:
-			//printf("\ncalling block function");
-			invertstatus=invertblockaandd(order, mat, invertmat, pos);
+			//invertmat holds a copy of the block here, so the leaf inverts it in place.
+			if(order<=invleaforder()) invertstatus=inplaceleaf(order, invertmat, pos, ws);
+			else invertstatus=invertblockaandd(order, mat, invertmat, pos, ws);
 			break;
 	}
 	return invertstatus;
 }
 
-int invertblockaandd(int order, double** mat, double** invertmat, int pos)
+int invertblockaandd(int order, struct invmat *mat, struct invmat *invertmat, int pos, struct invworkspace *ws)
 {
 	//By simultaneous inverse of A and D:
 	
-	int invertstatus;
+	int invertstatus, statusa, statusd;
 
-	int i,j;
 	int ordera, orderd, mb, nb, mc, nc;
 	int bposm, bposn, cposm, cposn;
 	
@@ -139,84 +255,90 @@ int invertblockaandd(int order, double** mat, double** invertmat, int pos)
 	cposm=pos+ordera;
 	cposn=pos;
 	
-	//step-2: Calculating A^-1 and D^-1
-	invertstatus=invertbyaandd(ordera, mat, invertmat, pos);
-	invertstatus=invertbyaandd(orderd, mat, invertmat, pos+ordera);
-
+	//The A half and the D half of each stage are independent: with OpenMP the A half runs as a task
+	//while the encountering thread does the D half, and the stages are separated by taskwait.
+	//Only B and C are shared by the halves: written in steps 3 and 7, read by both halves in step 5.
 	
+	//step-2: Calculating A^-1 and D^-1
 	//step-3: Calculating -1*A^-1*B and -1*D^-1*C
-//int inplaceleftmatmul(double** mat, int ordera, int aposmn, int nb, int bposm, int bposn)
-	invertstatus=inplaceleftmatmul(invertmat, ordera, pos, nb, bposm, bposn);
-	invertstatus=inplaceleftmatmul(invertmat, orderd, pos+ordera, nc, cposm, cposn);
+//int inplaceleftmatmul(struct invmat *mat, int ordera, int aposmn, int nb, int bposm, int bposn, struct invworkspace *ws)
+	#pragma omp task shared(statusa) if(order>=ADTASKCUTOFF)
+	{
+		statusa=invertbyaandd(ordera, mat, invertmat, pos, ws);
+		inplaceleftmatmul(invertmat, ordera, pos, nb, bposm, bposn, ws);
+	}
+	statusd=invertbyaandd(orderd, mat, invertmat, pos+ordera, ws);
+	inplaceleftmatmul(invertmat, orderd, pos+ordera, nc, cposm, cposn, ws);
+	#pragma omp taskwait
+	if(statusa==0 || statusd==0) return 0;
 
 	//step-4: Calculating A^-1B * D^-1C for A and D^-1C * A^-1B for D
 	
 	
 	//step-4: Replacing A and D in place of A^-1 and D^-1
-//	for(i=0;i<ordera;i++) for(j=0;j<ordera;j++) invertmat[pos+i][pos+j]=mat[pos+i][pos+j];
-//	for(i=0;i<orderd;i++) for(j=0;j<orderd;j++) invertmat[pos+ordera+i][pos+ordera+j]=mat[pos+ordera+i][pos+ordera+j];
+//	for(i=0;i<ordera;i++) for(j=0;j<ordera;j++) MATEL(invertmat,pos+i,pos+j)=MATEL(mat,pos+i,pos+j);
+//	for(i=0;i<orderd;i++) for(j=0;j<orderd;j++) MATEL(invertmat,pos+ordera+i,pos+ordera+j)=MATEL(mat,pos+ordera+i,pos+ordera+j);
 
 
 	//step-5 Calculating Schur Complements
-//schurcompforad(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
+//schurcompforad(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
 	//schurcompforad(invertmat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc);
 	//schurcompforad(invertmat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb);
-	schurad(mat,invertmat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc);
-	schurad(mat,invertmat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb);
-	
-	
 	//step-6 Calculating Inverse of Schur Complements
 	///invertstatus=invertbyaandd(ordera, mat, invertmat, pos);
 	///invertstatus=invertbyaandd(orderd, mat, invertmat, pos+ordera);
-	
-	invertstatus=invertinplace(ordera,  invertmat, pos);
-	invertstatus=invertinplace(orderd,  invertmat, pos+ordera);
+	#pragma omp task shared(statusa) if(order>=ADTASKCUTOFF)
+	{
+		schurad(mat,invertmat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc, ws);
+		statusa=invertinplace(ordera,  invertmat, pos, ws);
+	}
+	schurad(mat,invertmat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb, ws);
+	statusd=invertinplace(orderd,  invertmat, pos+ordera, ws);
+	#pragma omp taskwait
+	if(statusa==0 || statusd==0) return 0;
 
 	//step-7 Multiplying location of B and C with inverted schur complements at locations D and A.
-	invertstatus=inplacerightmatmul(invertmat, orderd, pos+ordera, mb, bposm, bposn);
-	invertstatus=inplacerightmatmul(invertmat, ordera, pos, mc, cposm, cposn); 	
+	#pragma omp task if(order>=ADTASKCUTOFF)
+	inplacerightmatmul(invertmat, orderd, pos+ordera, mb, bposm, bposn, ws);
+	invertstatus=inplacerightmatmul(invertmat, ordera, pos, mc, cposm, cposn, ws);
+	#pragma omp taskwait
 	
 	//printf("\ninverse computed =======\n");	
 	return invertstatus;
 }
 
-int schurad(double** mat, double** invertmat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
+int schurad(struct invmat *mat, struct invmat *invertmat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws)
 {
-	int i,j,k;
-	double *temp;
-	
-	temp = (double *) malloc(order*sizeof(double));
+	//The term at the place of the block is  M - M * (X * Y),  with M the block of mat and X, Y in invertmat.
+	//X * Y is formed in temp, M is copied to the place of the block and the product with M is subtracted from it.
+	//temp and the packing buffers come from the workspace (if any) and are given back on return.
+	int i, status;
+	struct invmat temp;
+	double *mi;
+	size_t mark, inner;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	if(invmatwsalloc(ws, &temp, order, order)==0) return 0;
+	
+	inner=invwsmark(ws);
+	status=invgemm(order, order, xn, 1.0, MATROW(invertmat,xposm)+xposn, invertmat->ld, MATROW(invertmat,yposm)+yposn, invertmat->ld, 0.0, temp.data, temp.ld, invwsdoubles(ws, invgemmworksize(order, order, xn)));  //xn = ym
+	invwsrelease(ws, inner);
 	
-	for(i=0;i<order;i++)
-		for(j=0;j<order;j++)
-		{
-			for(invertmat[matpos+i][matpos+j]=k=0;k<xn;k++)  //xn = ym
-			invertmat[matpos+i][matpos+j]+=invertmat[xposm+i][xposn+k]*invertmat[yposm+k][yposn+j];
-		}
-		
 	for(i=0;i<order;i++)
 	{
-		for(j=0;j<order;j++) temp[j]=invertmat[matpos+j][matpos+i];
-		
-		
-		for(j=0;j<order;j++)
-		{
-			for(invertmat[matpos+j][matpos+i]=k=0;k<order;k++)
-			{
-				invertmat[matpos+j][matpos+i]+=mat[matpos+j][matpos+k] * temp[k];//invertmat[matpos+k][matpos+j];
-			}
-		}
+		mi=MATROW(mat,matpos+i)+matpos;
+		memcpy(MATROW(invertmat,matpos+i)+matpos, mi, order*sizeof(double));
 	}
+	
+	if(status==1) status=invgemm(order, order, order, -1.0, MATROW(mat,matpos)+matpos, mat->ld, temp.data, temp.ld, 1.0, MATROW(invertmat,matpos)+matpos, invertmat->ld, invwsdoubles(ws, invgemmworksize(order, order, order)));
 
-	for(i=0;i<order;i++)
-		for(j=0;j<order;j++)
-			invertmat[matpos+i][matpos+j]=(mat[matpos+i][matpos+j]-invertmat[matpos+i][matpos+j]);
-
-	free(temp);
-	return 1;
+	invmatfree(&temp);
+	invwsrelease(ws, mark);
+	return status;
 }
 
-int schurcompforad(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
+int schurcompforad(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws)
 {
 	//At the place A: The term will be A - A * (A^-1B) * (D^-1C)
 	//At the place D: The term will be D - D * (D^-1C) * (A^-1B)
@@ -224,14 +346,24 @@ int schurcompforad(double** mat, int order, int matpos, int xposm, int xposn, in
 	int i,j,k, im, in;
 
 	double *temp, *atemp, mulres;
-	temp =(double *) malloc(order*sizeof(double));
-	atemp=(double *)malloc(order*sizeof(double));
+	size_t mark;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	temp=invwsdoubles(ws, order);
+	atemp=invwsdoubles(ws, order);
+	if(ws==NULL)
+	{
+		temp =(double *) malloc(order*sizeof(double));
+		atemp=(double *)malloc(order*sizeof(double));
+	}
+	if(temp==NULL || atemp==NULL) return 0;
 	
 	//for(j=0;j<order; j++) temp[j]=0;
 	
 	for(im=0;im<order;im++)
 	{
-		for(in=0;in<order;in++) atemp[in]=mat[matpos+in][matpos+im];
+		for(in=0;in<order;in++) atemp[in]=MATEL(mat,matpos+in,matpos+im);
 		
 		for(in=0;in<order;in++)
 		{
@@ -242,7 +374,7 @@ int schurcompforad(double** mat, int order, int matpos, int xposm, int xposn, in
 					temp[j]=0;
 					for(k=0; k<xn ; k++)  //xn = ym
 					{
-						temp[j]+=mat[xposm+j][xposn+k] * mat[yposm+k][yposn+in] ;
+						temp[j]+=MATEL(mat,xposm+j,xposn+k) * MATEL(mat,yposm+k,yposn+in) ;
 					}
 					// Now the temp array contains the i'th column in the multiplication x * y;
 					//if(in==j) temp[j]=1-temp[j];
@@ -257,17 +389,21 @@ int schurcompforad(double** mat, int order, int matpos, int xposm, int xposn, in
 			{	
 				mulres+=atemp[k]*temp[k];
 			}
-			mat[matpos+im][matpos+in]-=mulres;
+			MATEL(mat,matpos+im,matpos+in)-=mulres;
 		}
 	}
 
-	free(temp);
-	free(atemp);
+	if(ws==NULL)
+	{
+		free(temp);
+		free(atemp);
+	}
+	invwsrelease(ws, mark);
 	
 	return 1;
 }
 
-int invertinplace(int order, double** mat, int pos)
+int invertinplace(int order, struct invmat *mat, int pos, struct invworkspace *ws)
 {
 	int invertstatus;
 	double modmat, a11, a12, a13, a21, a22, a23, a31, a32, a33;
@@ -275,59 +411,87 @@ int invertinplace(int order, double** mat, int pos)
 	switch(order)
 	{
 		case 1:
-			if (mat[pos][pos]==0) return 0;
+			if (MATEL(mat,pos,pos)==0) return 0;
 			else 
 				{
-					mat[pos][pos]/=(mat[pos][pos]*mat[pos][pos]);
+					MATEL(mat,pos,pos)/=(MATEL(mat,pos,pos)*MATEL(mat,pos,pos));
 					invertstatus=1;
 				}
 			break;
 		case 2:
 		
-			modmat=(-(mat[pos+0][pos+1]*mat[pos+1][pos+0]) + mat[pos+0][pos+0]*mat[pos+1][pos+1]);
+			modmat=(-(MATEL(mat,pos+0,pos+1)*MATEL(mat,pos+1,pos+0)) + MATEL(mat,pos+0,pos+0)*MATEL(mat,pos+1,pos+1));
 			if(modmat==0) return 0;
 	
-			mat[pos+1][pos+1]*=mat[pos+0][pos+0]/modmat;
+			MATEL(mat,pos+1,pos+1)*=MATEL(mat,pos+0,pos+0)/modmat;
 			
-			mat[pos+0][pos+0]=(mat[pos+1][pos+1]/mat[pos+0][pos+0]);
-			mat[pos+0][pos+1]/=(-1*modmat);
-			mat[pos+1][pos+0]/=(-1*modmat);
-			mat[pos+1][pos+1]/=(mat[pos+0][pos+0]*modmat);
+			MATEL(mat,pos+0,pos+0)=(MATEL(mat,pos+1,pos+1)/MATEL(mat,pos+0,pos+0));
+			MATEL(mat,pos+0,pos+1)/=(-1*modmat);
+			MATEL(mat,pos+1,pos+0)/=(-1*modmat);
+			MATEL(mat,pos+1,pos+1)/=(MATEL(mat,pos+0,pos+0)*modmat);
 			invertstatus=1;
 			break;
 		case 3:
-			a11=mat[pos+0][pos+0];
-			a12=mat[pos+0][pos+1];
-			a13=mat[pos+0][pos+2];
-			a21=mat[pos+1][pos+0];
-			a22=mat[pos+1][pos+1];
-			a23=mat[pos+1][pos+2];
-			a31=mat[pos+2][pos+0];
-			a32=mat[pos+2][pos+1];
-			a33=mat[pos+2][pos+2];
+			a11=MATEL(mat,pos+0,pos+0);
+			a12=MATEL(mat,pos+0,pos+1);
+			a13=MATEL(mat,pos+0,pos+2);
+			a21=MATEL(mat,pos+1,pos+0);
+			a22=MATEL(mat,pos+1,pos+1);
+			a23=MATEL(mat,pos+1,pos+2);
+			a31=MATEL(mat,pos+2,pos+0);
+			a32=MATEL(mat,pos+2,pos+1);
+			a33=MATEL(mat,pos+2,pos+2);
 			
 			modmat=(-(a13*a22*a31) + a12*a23*a31 + a13*a21*a32 - a11*a23*a32 - a12*a21*a33 + a11*a22*a33);
 			if(modmat==0) return 0;
 	
-			mat[pos+0][pos+0]=(-(a23*a32) + a22*a33)/modmat;
-			mat[pos+0][pos+1]=(a13*a32 - a12*a33)/modmat;			
-			mat[pos+0][pos+2]=(-(a13*a22) + a12*a23)/modmat;
-			mat[pos+1][pos+0]=(a23*a31 - a21*a33)/modmat;
-			mat[pos+1][pos+1]=(-(a13*a31) + a11*a33)/modmat;
-			mat[pos+1][pos+2]=(a13*a21 - a11*a23)/modmat;
-			mat[pos+2][pos+0]=(-(a22*a31) + a21*a32)/modmat;
-			mat[pos+2][pos+1]=(a12*a31 - a11*a32)/modmat;
-			mat[pos+2][pos+2]=(-(a12*a21) + a11*a22)/modmat; 
-
+			MATEL(mat,pos+0,pos+0)=(-(a23*a32) + a22*a33)/modmat;
+			MATEL(mat,pos+0,pos+1)=(a13*a32 - a12*a33)/modmat;			
+			MATEL(mat,pos+0,pos+2)=(-(a13*a22) + a12*a23)/modmat;
+			MATEL(mat,pos+1,pos+0)=(a23*a31 - a21*a33)/modmat;
+			MATEL(mat,pos+1,pos+1)=(-(a13*a31) + a11*a33)/modmat;
+			MATEL(mat,pos+1,pos+2)=(a13*a21 - a11*a23)/modmat;
+			MATEL(mat,pos+2,pos+0)=(-(a22*a31) + a21*a32)/modmat;
+			MATEL(mat,pos+2,pos+1)=(a12*a31 - a11*a32)/modmat;
+			MATEL(mat,pos+2,pos+2)=(-(a12*a21) + a11*a22)/modmat; 
+			invertstatus=1;
 			break;
 		default:
-			//printf("\ncalling block function");
-			invertstatus=inplaceblocksbyd(order, mat, pos);
+			//Below the cutoff the Gauss-Jordan leaf is used instead of the recursion.
+			if(order<=invleaforder()) invertstatus=inplaceleaf(order, mat, pos, ws);
+			else invertstatus=inplaceblocksbyd(order, mat, pos, ws);
 			break;
 	}
 	return invertstatus;
 }
-int inplaceblocksbya(int order, double** mat, int pos)
+
+int inplaceleaf(int order, struct invmat *mat, int pos, struct invworkspace *ws)
+{
+	//The block of order (order * order) at (pos,pos) is inverted in place by the Gauss-Jordan leaf of `invertor_leaf.c',
+	//with its pivots and panel buffers taken from the workspace of the calling thread.
+	int status;
+	size_t mark;
+	int *pivot;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	pivot=(ws==NULL)?NULL:(int *) invwsalloc(ws, order*sizeof(int));
+	PERFBEGIN(INVPERFLEAF);
+	status=invleafgj(order, MATROW(mat,pos)+pos, mat->ld, pivot, invwsdoubles(ws, invleafworksize(order)));
+	PERFEND(INVPERFLEAF);
+	invwsrelease(ws, mark);
+	if(status==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",order);
+	}
+	return status;
+}
+
+size_t inplaceleafworkspace(int order)
+{
+	return invwsbytes((order*sizeof(int)+sizeof(double)-1)/sizeof(double))+invwsbytes(invleafworksize(order));
+}
+int inplaceblocksbya(int order, struct invmat *mat, int pos, struct invworkspace *ws)
 {
 	int invertstatus;
 
@@ -351,36 +515,46 @@ int inplaceblocksbya(int order, double** mat, int pos)
 	cposn=pos;
 	
 	//step-2: Calculating A^-1
-	invertstatus=invertinplace(ordera, mat, pos);
+	invertstatus=invertinplace(ordera, mat, pos, ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",ordera);
+		return 0;
+	}
 	
 	//step-3: Calculating -1*A^-1*B
-//int inplaceleftmatmul(double** mat, int ordera, int aposmn, int nb, int bposm, int bposn)
-	invertstatus=inplaceleftmatmul(mat, ordera, pos, nb, bposm, bposn);
+//int inplaceleftmatmul(struct invmat *mat, int ordera, int aposmn, int nb, int bposm, int bposn, struct invworkspace *ws)
+	invertstatus=inplaceleftmatmul(mat, ordera, pos, nb, bposm, bposn, ws);
 	
 	//step-4: Calculating Schur complement S = D - C A^-1B
-//int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
-	invertstatus=schurcomplement(mat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb);
+//int schurcomplement(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws)
+	invertstatus=schurcomplement(mat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb, ws);
 	
 	//step-5: Calculating C * A^-1
-//int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm, int aposn)
-	invertstatus=inplacerightmatmul(mat, ordera, pos, mc, cposm, cposn);
+//int inplacerightmatmul(struct invmat *mat, int orderb, int bposmn, int ma, int aposm, int aposn, struct invworkspace *ws)
+	invertstatus=inplacerightmatmul(mat, ordera, pos, mc, cposm, cposn, ws);
 	
 	//step-6: Calculating S^-1 
-	invertstatus=invertinplace(orderd, mat, pos+ordera);
+	invertstatus=invertinplace(orderd, mat, pos+ordera, ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",orderd);
+		return 0;
+	}
 	
 	//step-7: Calculatin S^-1 * CA^-1
-	invertstatus=inplaceleftmatmul(mat, orderd, pos+ordera, nc, cposm, cposn);
+	invertstatus=inplaceleftmatmul(mat, orderd, pos+ordera, nc, cposm, cposn, ws);
 	
 	//step-8: Calculating Schur completed at A: A^-1 + A^-1B * S^-1CA^-1
-	invertstatus=schurcomplement(mat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc);
+	invertstatus=schurcomplement(mat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc, ws);
 	
 	//step-9: Calculating -A^-1B * S^-1
-	invertstatus=inplacerightmatmul(mat, orderd, pos+ordera, mb, bposm, bposn);
+	invertstatus=inplacerightmatmul(mat, orderd, pos+ordera, mb, bposm, bposn, ws);
 
 	return invertstatus;
 }
 
-int inplaceblocksbyd(int order, double** mat, int pos)
+int inplaceblocksbyd(int order, struct invmat *mat, int pos, struct invworkspace *ws)
 {
 	//This function is based on invertability of d
 	int invertstatus;
@@ -405,71 +579,69 @@ int inplaceblocksbyd(int order, double** mat, int pos)
 	cposn=pos;
 	
 	//step-2: Calculating D^-1
-	invertstatus=invertinplace(orderd, mat, pos+ordera);
+	invertstatus=invertinplace(orderd, mat, pos+ordera, ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",orderd);
+		return 0;
+	}
 	
 	//step-3: Calculating -1*D^-1*C
-//int inplaceleftmatmul(double** mat, int ordera, int aposmn, int nb, int bposm, int bposn)
-	invertstatus=inplaceleftmatmul(mat, orderd, pos+ordera, nc, cposm, cposn);
+//int inplaceleftmatmul(struct invmat *mat, int ordera, int aposmn, int nb, int bposm, int bposn, struct invworkspace *ws)
+	invertstatus=inplaceleftmatmul(mat, orderd, pos+ordera, nc, cposm, cposn, ws);
 	
 	//step-4: Calculating Schur complement S = D - B * D^-1C
-//int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
-	invertstatus=schurcomplement(mat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc);
+//int schurcomplement(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws)
+	invertstatus=schurcomplement(mat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc, ws);
 	
 	//step-5: Calculating B * D^-1
-//int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm, int aposn)
-	invertstatus=inplacerightmatmul(mat, orderd, pos+ordera, mb, bposm, bposn);
+//int inplacerightmatmul(struct invmat *mat, int orderb, int bposmn, int ma, int aposm, int aposn, struct invworkspace *ws)
+	invertstatus=inplacerightmatmul(mat, orderd, pos+ordera, mb, bposm, bposn, ws);
 	
 	//step-6: Calculating S^-1 
-	invertstatus=invertinplace(ordera, mat, pos);
+	invertstatus=invertinplace(ordera, mat, pos, ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",ordera);
+		return 0;
+	}
 	
 	//step-7: Calculatin S^-1 * BD^-1
-	invertstatus=inplaceleftmatmul(mat, ordera, pos, nb, bposm, bposn);
+	invertstatus=inplaceleftmatmul(mat, ordera, pos, nb, bposm, bposn, ws);
 	
 	//step-8: Calculating Schur completed at D: D^-1 + D^-1C * S^-1BD^-1
-	invertstatus=schurcomplement(mat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb);
+	invertstatus=schurcomplement(mat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb, ws);
 	
 	//step-9: Calculating -D^-1C * S^-1
-	invertstatus=inplacerightmatmul(mat, ordera, pos, mc, cposm, cposn);
+	invertstatus=inplacerightmatmul(mat, ordera, pos, mc, cposm, cposn, ws);
 
 	return invertstatus;
 }
 
 
-int inplaceleftmatmul(double** mat, int ordera, int aposmn, int nb, int bposm, int bposn)
+int inplaceleftmatmul(struct invmat *mat, int ordera, int aposmn, int nb, int bposm, int bposn, struct invworkspace *ws)
 {
 	//This computes -1*mat A * mat B and stores it in mat B.
 	//mat A is square matrix of order (ordera * ordera).
 	//mat B is not square matrix.  It is of order (ordera * nb).
 	//The result matrix will be stored at mat B's location with order (ordera * nb).
 	//Since the required multiplications for block inversion are with sqare matrix, we use minimum variables.
-	
-	int i,j,k;
-
-	double *btemp;
-	btemp =(double *) malloc(ordera*sizeof(double));
-
-	for(j=0;j<nb;j++)
-		{
-			//printf("-------");
-			for(k=0; k<ordera; k++) 
-			{
-				btemp[k]=mat[bposm+k][bposn+j];  //printf("\n%lf",btemp[k]);
-				//mat[bposm+i][bposn+k]=0;
-			}
-		
-		for(i=0;i<ordera;i++) 
-			{ 
-				mat[bposm+i][bposn+j]=0;
-				for(k=0; k<ordera; k++)
-				mat[bposm+i][bposn+j]+=mat[aposmn+i][aposmn+k]*btemp[k];
-				mat[bposm+i][bposn+j]*=-1;
-			}
-		}	
-	free(btemp);
-	return 1;
+	//Column panels of B are copied and multiplied by the vector kernel of `invertor_simd.c', which folds in the sign.
+	
+	//The panel is taken from the workspace (if any) and given back on return.
+	int status;
+	size_t mark;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	PERFBEGIN(INVPERFLEFT);
+	status=simdleftmatmul(ordera, nb, MATROW(mat,aposmn)+aposmn, mat->ld, MATROW(mat,bposm)+bposn, mat->ld, invwsdoubles(ws, simdleftworksize(ordera)));
+	PERFEND(INVPERFLEFT);
+	invwsrelease(ws, mark);
+	return status;
 }
 
-int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm, int aposn)
+int inplacerightmatmul(struct invmat *mat, int orderb, int bposmn, int ma, int aposm, int aposn, struct invworkspace *ws)
 {
 	//Left Multiplication we track -ve sign.  For Right Multiplication we track +ve sign.
 	//This computes mat A * mat B and stores it in mat A.
@@ -477,34 +649,21 @@ int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm,
 	//mat B is square matrix of order (orderb * orderb).
 	//The result matrix will be stored at mat A's location with order (ma * orderb).
 	//Since the required multiplications for block inversion are with sqare matrix, we use minimum variables.
-	
-	int i,j,k;
-
-	double *atemp;
-	atemp =(double *) malloc(orderb*sizeof(double));
-
-	for(i=0;i<ma;i++)
-		{
-			//printf("-------");
-			for(k=0; k<orderb; k++) 
-			{
-				atemp[k]=mat[aposm+i][aposn+k];  //printf("\n%lf",atemp[k]);
-				//mat[bposm+i][bposn+k]=0;
-			}
-		
-		for(j=0;j<orderb;j++) 
-			{ 
-				mat[aposm+i][aposn+j]=0;
-				for(k=0; k<orderb; k++)
-				mat[aposm+i][aposn+j]+=atemp[k]*mat[bposmn+k][bposmn+j];
-				//mat[aposm+i][aposn+j]*=-1;
-			}
-		}	
-	free(atemp);
-	return 1;
+	//Rows of A are copied a few at a time and multiplied by the vector kernel of `invertor_simd.c'.
+	
+	int status;
+	size_t mark;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	PERFBEGIN(INVPERFRIGHT);
+	status=simdrightmatmul(ma, orderb, MATROW(mat,aposm)+aposn, mat->ld, MATROW(mat,bposmn)+bposmn, mat->ld, invwsdoubles(ws, simdrightworksize(orderb)));
+	PERFEND(INVPERFRIGHT);
+	invwsrelease(ws, mark);
+	return status;
 }
 
-int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
+int schurcomplement(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws)
 {
 	//If block D is invertible, then Schur complement of the block D is
 	//	M / D := A − B D^{-1} C 
@@ -528,15 +687,17 @@ int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, i
 	//y matrix is at the location (yposm, yposn) with order (order * yn).
 	//Here we calculate, mat = mat + xmatrix*ymatrix and stores at the location of mat.
 	
-	int i,j,k;
-	
-	for(i=0;i<order;i++)
-		for(j=0;j<order;j++)
-			for(k=0;k<xn;k++)  //xn == ym
-			{
-				mat[matpos+i][matpos+j]+=mat[xposm+i][xposn+k]*mat[yposm+k][yposn+j];
-			}
-	return 1;
+	//The product is done by the blocked multiplication of `invertor_gemm.c'.  The three blocks do not overlap.
+	int status;
+	size_t mark;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	PERFBEGIN(INVPERFSCHUR);
+	status=invgemm(order, order, xn, 1.0, MATROW(mat,xposm)+xposn, mat->ld, MATROW(mat,yposm)+yposn, mat->ld, 1.0, MATROW(mat,matpos)+matpos, mat->ld, invwsdoubles(ws, invgemmworksize(order, order, xn)));  //xn == ym
+	PERFEND(INVPERFSCHUR);
+	invwsrelease(ws, mark);
+	return status;
 }
 
 
@@ -26,8 +26,27 @@
 #include<math.h>
 #include <omp.h>
 #include<unistd.h>
-
+#include<string.h>
+
+#include "invertor_matrix.c"
+#include "invertor_leaf.c"
+#include "invertor_trace.c"
+#include "invertor_perf.c"
+
+//Default order of the diagonal blocks: invertmat partitions the matrix into blocks of about this order,
+//which are inverted by the dense leaf kernel.  invertmatpartition takes any other partition.
+//The key prll_block of the configuration (`invertor_config.c') overrides it at run time, and prll_chunk sets the
+//chunk of the static schedules of the block products (0, the default, gives every thread one equal share).
+#ifndef PRLLBLOCKORDER
+#define PRLLBLOCKORDER 128
+#endif
+
+void prllconfig(void) __attribute__((constructor));
 int invertmat(int n, double** mata, double** inverta);
+int invertmatpartition(int n, double** mata, double** inverta, int nblocks, int *blockorders);
+size_t invertmatworkspace(int n);
+size_t invertmatthreadsworkspace(int n, int threads);
+int invertleaf(int n, int apos, double** a, int invapos, double** inverta, double *work, int *pivot);
 int invertcases(int n, int apos, double** a, int invapos, double** inverta);
 
 int invertmatone(int pos, double** a, int ipos, double** inverta);
@@ -39,13 +58,15 @@ int invertmatfour(int pos, double** a, int ipos, double** inverta);
 //int invertfunction(int loopidloc, int* loopid, int blocksize, int* blocks, int* blockspos, double** mata, double*** mirrormat, double** inverta);
 //int schurfunction(int loopidloc, int* loopid, int blocksize, int* blocks, int* blockspos, double** mata, double*** mirrormat, double** inverta);
 
-int invertblocks(int order, double** mata, double** inverta);
+int invertblocks(int order, double** mata, double** inverta, int nblocks, int *blockorders);
+void prllmuladd(int m, int n, int k, double alpha, double **x, int xi, int xj, double **y, int yi, int yj, double **c);
 
 struct block
 {
 	int blkm;
 	int blkn;
-	double **blkelement;
+	double **blkelement; //row pointers into tile
+	double *tile; //blkm rows of blkn elements, contiguous and aligned to a cache line
 };
 
 struct blockmat
@@ -65,6 +86,12 @@ struct mirrorstruct
 	struct blockmat *rpartnerblocks; // one right partner block
 };
 
+size_t mirrorslab(char *slab, int blocksize, int *blocks, int mirrorsize);
+void prllblockcopy(double **a, int ai, int aj, struct block *b);
+void prllblockzero(struct block *b);
+void mirrorblockmat(char *slab, size_t *used, struct blockmat *bm, int morder, int *rowblocks, int *colblocks);
+void *mirrorslabtake(char *slab, size_t *used, size_t bytes, size_t align);
+
 //typedef double **block;
 //typedef block **blockmat;
 //We are setting the precision here
@@ -135,23 +162,126 @@ int printer(int order, double** mata, double** inverta, int sizeofmirror, struct
 	return 1;
 }
 */
+static int prllblock=PRLLBLOCKORDER, prllchunk=0;
+
+void prllconfig(void)
+{
+	int v;
+
+	v=invconfigint("prll_block", PRLLBLOCKORDER);
+	if(v>=1) prllblock=v;
+	v=invconfigint("prll_chunk", 0);
+	if(v>=0) prllchunk=v;
+}
+
 int invertmat(int n, double** mata, double** inverta)
 {
+	//The matrix is partitioned into blocks of about prllblock (PRLLBLOCKORDER), whose orders differ at most by one.
 	int invertstatus=0;
-	int i,j;
-	//for(n=5;n<=125;n=n+5)
-	//{
+	int i, nblocks, *orders;
+
 	if(n<=0) return 0;
-	if(n<=4) 
-	{	
-		//for(i=0;i<n;i++) for(j=0;j<n;j++) inverta[i][j]=mata[i][j];
-		invertstatus = invertcases(n, 0, mata, 0, inverta);
+	nblocks=(n+prllblock-1)/prllblock;
+	orders=(int *) malloc(nblocks*sizeof(int));
+	if(orders==NULL)
+	{
+		printf("\nUnable to allocate the partition of %d blocks\n", nblocks);
+		return 0;
 	}
-	else invertstatus = invertblocks(n, mata, inverta);
-	//}
+	for(i=0;i<nblocks;i++) orders[i]=n/nblocks+((i<n%nblocks)?1:0);
+	invertstatus = invertmatpartition(n, mata, inverta, nblocks, orders);
+	free(orders);
 	return invertstatus;
 }
 
+size_t invertmatworkspace(int n)
+{
+	//Bytes allocated by invertmat for order n: the slab of the mirrors and the leaf workspace of each of the
+	//invthreads() threads (the small index arrays are left out).  Nothing is allocated here apart from the partition.
+	return invertmatthreadsworkspace(n, invthreads());
+}
+
+size_t invertmatthreadsworkspace(int n, int threads)
+{
+	//As invertmatworkspace for threads OpenMP threads.
+	int i, nblocks, blocksize, mirrorsize, maxblock, *blocks;
+	size_t bytes;
+
+	if(n<=0) return 0;
+	if(threads<1) threads=1;
+	nblocks=(n+prllblock-1)/prllblock;
+	maxblock=(n+nblocks-1)/nblocks;
+	if(nblocks==1) return ((size_t)n*n+invleafworksize(n))*sizeof(double)+n*sizeof(int);
+
+	for(blocksize=2;blocksize<nblocks;blocksize*=2);
+	for(mirrorsize=0;(1<<mirrorsize)<blocksize;mirrorsize++);
+	blocks=(int *) calloc(blocksize, sizeof(int));
+	if(blocks==NULL) return 0;
+	for(i=0;i<nblocks;i++) blocks[i]=n/nblocks+((i<n%nblocks)?1:0);
+	bytes=mirrorslab(NULL, blocksize, blocks, mirrorsize);
+	bytes+=(size_t)threads*(((size_t)maxblock*maxblock+invleafworksize(maxblock))*sizeof(double)+maxblock*sizeof(int));
+	free(blocks);
+	return bytes;
+}
+
+int invertmatpartition(int n, double** mata, double** inverta, int nblocks, int *blockorders)
+{
+	//Inversion with the matrix partitioned into nblocks diagonal blocks of orders blockorders[0], blockorders[1], ...
+	//which add up to n.  Any number of blocks and any orders can be given.
+	int invertstatus=0;
+	int i, total;
+	double *work;
+	int *pivot;
+
+	if(n<=0 || nblocks<=0) return 0;
+	for(total=0,i=0;i<nblocks;i++)
+	{
+		if(blockorders[i]<=0)
+		{
+			printf("\nUnable to use the partition: block %d has order %d\n", i, blockorders[i]);
+			return 0;
+		}
+		total+=blockorders[i];
+	}
+	if(total!=n)
+	{
+		printf("\nUnable to use the partition: the orders of the blocks add up to %d instead of %d\n", total, n);
+		return 0;
+	}
+	if(nblocks>1) return invertblocks(n, mata, inverta, nblocks, blockorders);
+
+	work=(double *) malloc(((size_t)n*n+invleafworksize(n))*sizeof(double));
+	pivot=(int *) malloc(n*sizeof(int));
+	if(work==NULL || pivot==NULL)
+		printf("\nUnable to allocate the leaf workspace for order %d\n", n);
+	else
+		invertstatus = invertleaf(n, 0, mata, 0, inverta, work, pivot);
+	free(work);
+	free(pivot);
+	return invertstatus;
+}
+
+int invertleaf(int n, int apos, double** a, int invapos, double** inverta, double *work, int *pivot)
+{
+	//Inverse of the diagonal block of order n at (apos,apos) of a, stored at (invapos,invapos) of inverta.
+	//Up to order 4 the cofactor formulas are used; larger blocks are copied to work (n * n + invleafworksize(n) doubles,
+	//pivot n integers) and inverted by Gauss-Jordan elimination, unrolled up to order 16.  Blocks of order zero are the padding of invertblocks.
+	int i, status;
+
+	if(n==0) return 1;
+	if(n>4 && work==NULL) return 0;
+	PERFBEGIN(INVPERFLEAF);
+	if(n<=4) status=invertcases(n, apos, a, invapos, inverta);
+	else
+	{
+		for(i=0;i<n;i++) memcpy(work+(size_t)i*n, a[apos+i]+apos, n*sizeof(double));
+		status=invleafgj(n, work, n, pivot, work+(size_t)n*n);
+		if(status==1) for(i=0;i<n;i++) memcpy(inverta[invapos+i]+invapos, work+(size_t)i*n, n*sizeof(double));
+	}
+	PERFEND(INVPERFLEAF);
+	return status;
+}
+
 int invertcases(int n, int apos, double** a, int invapos, double** inverta)
 {
 	int invertstatus;
@@ -371,46 +501,50 @@ int invertmatfour(int pos, double** a, int ipos, double** inverta)
 
 
 
-int invertblocks(int order, double** mata, double** inverta)
+int invertblocks(int order, double** mata, double** inverta, int nblocks, int *blockorders)
 {
 
 	int i,j,k,l,m,n;
 	int mcid, msid, ud, udmc, msiditr;
 	int nloop, threadid;
 	int **loopid, loopidsize, noofloops;
-	int *blocks, *blockspos, blocksize;
+	int *blocks, *blockspos, blocksize, maxblock;
+	int invertstatus=1;
+	double *leafwork;
+	int *leafpivot;
 
-	int ii, jj, kk, iblk, itr, blkchoice, itrn;
+	int ii, jj, kk, iblk, itr, blkchoice, nud, p, a0, d0, ra, rd;
+	struct blockmat *sq;
 
 	//struct mirrorstruct mirror[((int)log2(pow(2,(int)log2(order)-1)))];
 	struct mirrorstruct *mirror;
 	int mirrorsize;
 
 	int *morder, *mblocksize;
+	char *slab;
+	size_t slabbytes;
 
-	double temp, temp1, temp2, temp3, temp4;
+	double temp;
+	struct block *partner;
+	double *dst, *src;
 	double wtime;
-
-	blocksize = (int) log2(order);
-	blocksize = pow(2,(int)log2(order)-1);
+#ifdef _OPENMP
+	omp_sched_t callerschedule;
+	int callerchunk;
+#endif
+
+	//The mirrors pair the blocks level by level, so the number of blocks is rounded up to a power of two
+	//with blocks of order zero at the end.  They drop out of every product and their inverse is empty.
+	for(blocksize=2;blocksize<nblocks;blocksize*=2);
 	blocks=(int *) malloc(blocksize*sizeof(int));
 	blockspos=(int *) malloc(blocksize*sizeof(int));
-	
-	////printf("\n order = %d, blocksize = %d", order, blocksize);
-
-        for(i=0;i<blocksize;i++)
-        {       
-                n=(int)log2(order)-1;
-                if(order<((int)pow(2,n)*3)) blocks[i]=(i<((int)pow(2,n)- order%((int)pow(2,n))))?2:3;
-                else blocks[i]=(i<((int)pow(2,n)- order%((int)pow(2,n))))?3:4;
-        }
-
-        for(blockspos[0]=0,i=1;i<blocksize; i++) blockspos[i]=blockspos[i-1]+blocks[i-1];
-
-        ////printf("\nPrinting the blocks array and blockspos array of size %d\n",blocksize);
-        /////for(i=0;i<blocksize;i++)
-        ////printf("%d\t%d\n",blocks[i],blockspos[i]);
+	for(maxblock=0,i=0;i<blocksize;i++)
+	{
+		blocks[i]=(i<nblocks)?blockorders[i]:0;
+		if(blocks[i]>maxblock) maxblock=blocks[i];
+	}
 
+	for(blockspos[0]=0,i=1;i<blocksize; i++) blockspos[i]=blockspos[i-1]+blocks[i-1];
 
 	loopidsize = (int)log2(blocksize)+1;
 	noofloops=blocksize*2;
@@ -437,94 +571,57 @@ int invertblocks(int order, double** mata, double** inverta)
 	}
 
 	//Decleration of mirrors
-	
-	mirror=(struct mirrorstruct *)malloc(((int)log2(pow(2,(int)log2(order)-1))) * sizeof(struct mirrorstruct));
-	//printf("Mirrors count = %d  \n",sizeof(mirror)/sizeof(mirror[0]));
-	//printf("Mirrors count = %d  \n",((int)log2(pow(2,(int)log2(order)-1))));
-	mirrorsize=(int)log2(pow(2,(int)log2(order)-1));
-	//for(i=0;i<(sizeof(mirror)/sizeof(mirror[0]));i++)
-        morder=(int *)calloc(mirrorsize,sizeof(int));
-        mblocksize=(int *)calloc(mirrorsize,sizeof(int));
-
+	//The mirrors with all their square and partner blocks are laid out in one slab by mirrorslab.
+	for(mirrorsize=0;(1<<mirrorsize)<blocksize;mirrorsize++);
+	morder=(int *)calloc(mirrorsize,sizeof(int));
+	mblocksize=(int *)calloc(mirrorsize,sizeof(int));
 	for(i=0;i<mirrorsize;i++)
-	//for(i=0;i<(sizeof(mirror)/sizeof(mirror[0]));i++)
 	{
-                morder[i]=(int)pow(2,i);
-                mblocksize[i]=(int)(blocksize/morder[i]);//blocksize interms of number of blocks comparing blocks array
+		morder[i]=1<<i;
+		mblocksize[i]=blocksize/morder[i];//blocksize interms of number of blocks comparing blocks array
+	}
 
-		mirror[i].morder=(int)pow(2,i);
-		mirror[i].mblocksize=(int)(blocksize/mirror[i].morder);//blocksize interms of number of blocks comparing blocks array
-		//mirror[i].mblocks=(int *)malloc(((int)blocksize/mirror[i].morder)*sizeof(int));
-		//mirror[i].mblockspos=(int *)malloc(((int)blocksize/mirror[i].morder)*sizeof(int));
-		
-		mirror[i].sqrblocks=(struct blockmat *)calloc(mirror[i].mblocksize , sizeof(struct block));
-		//mirror[i].sqrblocks=(struct block *)malloc(mirror[i].mblocksize * sizeof(struct block));
-		mirror[i].lpartnerblocks=(struct blockmat *)calloc((int)(mirror[i].mblocksize/2) , sizeof(struct block));
-		mirror[i].rpartnerblocks=(struct blockmat *)calloc((int)(mirror[i].mblocksize/2) , sizeof(struct block));
-		for(j=0; j<mirror[i].mblocksize; j++)
-		{
-			mirror[i].sqrblocks[j].brows=mirror[i].morder;
-			mirror[i].sqrblocks[j].bcols=mirror[i].morder;
-			mirror[i].sqrblocks[j].blk=(struct block **)calloc(mirror[i].sqrblocks[j].brows,sizeof(struct block *));
-			for(k=0; k< mirror[i].sqrblocks[j].brows;k++)
-			{
-				mirror[i].sqrblocks[j].blk[k]=(struct block *)calloc(mirror[i].sqrblocks[j].bcols,sizeof(struct block));
-				for(l=0;l<mirror[i].sqrblocks[j].bcols;l++)
-				{
-						mirror[i].sqrblocks[j].blk[k][l].blkm=blocks[k+(j*mirror[i].morder)];
-						mirror[i].sqrblocks[j].blk[k][l].blkn=blocks[l+(j*mirror[i].morder)];
-						mirror[i].sqrblocks[j].blk[k][l].blkelement=(double **)calloc(mirror[i].sqrblocks[j].blk[k][l].blkm,sizeof(double *));
-						for(m=0;m<(mirror[i].sqrblocks[j].blk[k][l].blkm);m++)
-							mirror[i].sqrblocks[j].blk[k][l].blkelement[m]=(double *)calloc(mirror[i].sqrblocks[j].blk[k][l].blkn,sizeof(double));
-				}
-			}
-			if((j%2)==0)
-			{
-				mirror[i].rpartnerblocks[(int)j/2].brows=mirror[i].morder;
-				mirror[i].rpartnerblocks[(int)j/2].bcols=mirror[i].morder;
-				mirror[i].rpartnerblocks[(int)j/2].blk=(struct block **)calloc(mirror[i].rpartnerblocks[(int)j/2].brows,sizeof(struct block *));
-				for(k=0; k< mirror[i].rpartnerblocks[(int)j/2].brows;k++)
-				{
-					mirror[i].rpartnerblocks[(int)j/2].blk[k]=(struct block *)calloc(mirror[i].rpartnerblocks[(int)j/2].bcols,sizeof(struct block));
-					for(l=0;l<mirror[i].rpartnerblocks[(int)j/2].bcols;l++)
-					{
-						mirror[i].rpartnerblocks[(int)j/2].blk[k][l].blkm=blocks[k+(j*mirror[i].morder)];
-						mirror[i].rpartnerblocks[(int)j/2].blk[k][l].blkn=blocks[l+((j+1)*mirror[i].morder)];
-						mirror[i].rpartnerblocks[(int)j/2].blk[k][l].blkelement=(double **)calloc(mirror[i].rpartnerblocks[(int)j/2].blk[k][l].blkm,sizeof(double *));
-						for(m=0;m<(mirror[i].rpartnerblocks[(int)j/2].blk[k][l].blkm);m++)
-							mirror[i].rpartnerblocks[(int)j/2].blk[k][l].blkelement[m]=(double *)calloc(mirror[i].rpartnerblocks[(int)j/2].blk[k][l].blkn,sizeof(double));
-					}
-				}
-			}
-			else
-			{
-				mirror[i].lpartnerblocks[(int)j/2].brows=mirror[i].morder;
-				mirror[i].lpartnerblocks[(int)j/2].bcols=mirror[i].morder;
-				mirror[i].lpartnerblocks[(int)j/2].blk=(struct block **)calloc(mirror[i].lpartnerblocks[(int)j/2].brows,sizeof(struct block *));
-				for(k=0; k< mirror[i].lpartnerblocks[(int)j/2].brows;k++)
-				{
-					mirror[i].lpartnerblocks[(int)j/2].blk[k]=(struct block *)calloc(mirror[i].lpartnerblocks[(int)j/2].bcols,sizeof(struct block));
-					for(l=0;l<mirror[i].lpartnerblocks[(int)j/2].bcols;l++)
-					{
-						mirror[i].lpartnerblocks[(int)j/2].blk[k][l].blkm=blocks[k+(j*mirror[i].morder)];
-						mirror[i].lpartnerblocks[(int)j/2].blk[k][l].blkn=blocks[l+((j-1)*mirror[i].morder)];
-						mirror[i].lpartnerblocks[(int)j/2].blk[k][l].blkelement=(double **)calloc(mirror[i].lpartnerblocks[(int)j/2].blk[k][l].blkm,sizeof(double *));
-						for(m=0;m<(mirror[i].lpartnerblocks[(int)j/2].blk[k][l].blkm);m++)
-							mirror[i].lpartnerblocks[(int)j/2].blk[k][l].blkelement[m]=(double *)calloc(mirror[i].lpartnerblocks[(int)j/2].blk[k][l].blkn,sizeof(double));
-					}
-				}
-			}
-		}
-		////printf("\n Mirror %d creation : morder = %d , mblocksize = %d",i, mirror[i].morder, mirror[i].mblocksize);
+	slabbytes=mirrorslab(NULL, blocksize, blocks, mirrorsize);
+	slab=(char *) aligned_alloc(INVMATALIGN, slabbytes);
+	if(slab==NULL)
+	{
+		printf("\nUnable to allocate %zu bytes for the mirrors of order %d\n", slabbytes, order);
+		for(i=0;i<noofloops;i++) free(loopid[i]);
+		free(loopid);
+		free(morder);
+		free(mblocksize);
+		free(blocks);
+		free(blockspos);
+		return 0;
 	}
+	memset(slab, 0, slabbytes);
+	mirrorslab(slab, blocksize, blocks, mirrorsize);
+	mirror=(struct mirrorstruct *)slab;
 
 	//int printer(int order, double** mata, double** inverta, int sizeofmirror, struct mirrorstruct *mptr)
 	//printer(order, mata, inverta, (int)(sizeof(mirror)/sizeof(mirror[0])), mirror);
 	//printf("\ninversion with omp parallel, PREC = %d\n",PREC);	
 
-	#pragma omp parallel private(wtime, i,j,nloop,blkchoice, msid, mcid, udmc) shared(order, noofloops, PRECP, blocks, blockspos, morder, mblocksize, mirror, mata, inverta)
+	//The products are scheduled statically with chunks of prllchunk; the schedule of the caller is restored after.
+#ifdef _OPENMP
+	omp_get_schedule(&callerschedule, &callerchunk);
+	omp_set_schedule(omp_sched_static, prllchunk);
+#endif
+	//Every stage ends with an explicit barrier in place of the implicit one of its omp for (nowait), so that
+	//with -DINVERTORTRACE the wait of each thread there is recorded (`invertor_trace.c').
+	TRACESTART(invthreads());
+	#pragma omp parallel num_threads(invthreads()) private(wtime, i,j,nloop,blkchoice, msid, mcid, udmc, leafwork, leafpivot) shared(order, noofloops, blocks, blockspos, morder, mblocksize, mirror, mata, inverta, invertstatus)
 	//for(i=1;i<noofloops;i++)
 	{	i=1; //nloop=0;
+		//Every thread inverts its diagonal blocks in its own leaf workspace.
+		leafwork=(double *) malloc(((size_t)maxblock*maxblock+invleafworksize(maxblock))*sizeof(double));
+		leafpivot=(int *) malloc(maxblock*sizeof(int));
+		if(leafwork==NULL || leafpivot==NULL)
+		{
+			printf("\nUnable to allocate the leaf workspace for blocks of order %d\n", maxblock);
+			#pragma omp atomic write
+			invertstatus=0;
+		}
 		//wtime = omp_get_wtime();
 		do
 		{
@@ -532,234 +629,71 @@ int invertblocks(int order, double** mata, double** inverta)
 			//for(j=0;j<loopidsize;j++) printf("\t%d",loopid[i][j]); printf("\n--------------\n");
 			//Here we perform the operation for given loopid:
 			//Finding the loopid location for which the operation has to be done.
-			for(j=loopidsize-1;(j>=0)&&(loopid[i][j]==0);j--);
-			#pragma omp barrier	
+			for(j=loopidsize-1;(j>=0)&&(loopid[i][j]==0);j--)
+			{}
+			TRACEBARRIER(i)
 			if(j==0)
 			{
 				if(loopid[i][0]==1)
 				{
 					//Inversion using A
-					#pragma omp for private(k) schedule(dynamic)
+					TRACEBEGIN("diagonal inversion", i);
+					#pragma omp for private(k) schedule(dynamic) nowait
 					for(k=0;k<blocksize;k++)
 					{
-						invertcases(blocks[k], blockspos[k], mata, blockspos[k], inverta);
+						if(invertleaf(blocks[k], blockspos[k], mata, blockspos[k], inverta, leafwork, leafpivot)==0)
+						{
+							#pragma omp atomic write
+							invertstatus=0;
+						}
 					}
+					TRACEEND();
+					TRACEBARRIER(i)
 				}
 				else
 				{
 					//mirrorchoiceid is mata //mirrorstoreid is zero.
 					msid = loopid[i][0]-2;
+					//The units (k,jj,kk) compute the block (jj,kk) of the partner and square blocks of the pair k over all the blocks p
+					//of the product, so every block of the mirror is written by one thread only.
 					//1. Calculation of -A^-1B and -D^-1C using A (for B and D) and storing at Mirror (id=loopid[0]-2) 
-					#pragma omp for collapse(3) private(k,ii,jj,l,m) schedule(static,8)
-					for(k=0;k<(mblocksize[msid]/2);k++)
-					//for(k=0;k<(mirror[msid].mblocksize/2);k++)
-					{
-						for(ii=0; ii<morder[msid]; ii++)
-						//for(ii=0; ii<mirror[msid].morder; ii++)
-						{
-							for(jj=0; jj<morder[msid]; jj++)
-							//for(jj=0; jj<mirror[msid].morder; jj++)
-							{
-								//for(l=0; l<rpartblkm[msid][k][ii][jj]; l++)
-								for(l=0; l<mirror[msid].rpartnerblocks[k].blk[ii][jj].blkm; l++)
-									//for(m=0; m<rpartblkn[msid][k][ii][jj]; m++)
-									for(m=0; m<mirror[msid].rpartnerblocks[k].blk[ii][jj].blkn; m++)
-										//mrpartner[msid][k][ii][jj][l][m]=0.0;
-										#pragma omp atomic write
-										mirror[msid].rpartnerblocks[k].blk[ii][jj].blkelement[l][m]=0.0;
-							}
-						}
-					}
-					#pragma omp for collapse(3) private(k,ii,jj,l,m) schedule(static,8)
-					for(k=0;k<(mblocksize[msid]/2);k++)
-					//for(k=0;k<(mirror[msid].mblocksize/2);k++)
-					{
-						for(ii=0; ii<morder[msid]; ii++)
-						//for(ii=0; ii<mirror[msid].morder; ii++)
-						{
-							for(jj=0; jj<morder[msid]; jj++)
-							//for(jj=0; jj<mirror[msid].morder; jj++)
-							{
-								//for(l=0; l<lpartblkm[msid][k][ii][jj]; l++)
-								for(l=0; l<mirror[msid].lpartnerblocks[k].blk[ii][jj].blkm; l++)
-									//for(m=0; m<lpartblkn[msid][k][ii][jj]; m++)
-									for(m=0; m<mirror[msid].lpartnerblocks[k].blk[ii][jj].blkn; m++)
-										#pragma omp atomic write
-										//mlpartner[msid][k][ii][jj][l][m]=0.0;
-										mirror[msid].lpartnerblocks[k].blk[ii][jj].blkelement[l][m]=0.0;
-							}
-						}
-					}
-					#pragma omp for collapse(4) private(k,ii,jj,kk,l,m,n) reduction(+:temp) schedule(static)
-					for(k=0;k<(mblocksize[msid]/2);k++)
-					//for(k=0;k<(mirror[msid].mblocksize/2);k++)
-					{
-						for(ii=0; ii<morder[msid]; ii++)
-						//for(ii=0; ii<mirror[msid].morder; ii++)
-						{
-							for(jj=0; jj<morder[msid]; jj++)
-							//for(jj=0; jj<mirror[msid].morder; jj++)
-							{
-								for(kk=0; kk<morder[msid]; kk++)
-								{
-									//printf("\nmsid=%d, k=%d, ii=%d, jj=%d kk=%d\n",msid,k,ii,jj,kk);
-									//for(l=0; l<rpartblkm[msid][k][jj][kk]; l++)
-									for(l=0; l<mirror[msid].rpartnerblocks[k].blk[jj][kk].blkm; l++)
-										//for(m=0; m<rpartblkn[msid][k][jj][kk]; m++)
-										//	for(n=0;n<blocks[(k*2*morder[msid])+(jj+ii)%morder[msid]];n++)
-										for(m=0; m<mirror[msid].rpartnerblocks[k].blk[jj][kk].blkn; m++)
-									//for(l=0; l<mirror[msid].rpartnerblocks[k].blk[jj][kk].blkm; l++)
-											{
-											//for(n=0; n<mirror[msid].rpartnerblocks[k].blk[jj][kk].blkm; n++)
-											//for(n=0;n<blocks[(k*2*mirror[msid].morder)+(jj+ii)%mirror[msid].morder];n++)
-											//for(n=0, temp=mrpartner[msid][k][jj][kk][l][m];n<blocks[(k*2*morder[msid])+(jj+ii)%morder[msid]];n++)
-											//temp=mrpartner[msid][k][jj][kk][l][m];
-											temp=0.0;//mrpartner[msid][k][jj][kk][l][m];
-											for(n=0;n<blocks[(k*2*morder[msid])+(jj+ii)%morder[msid]];n++)
-											//mrpartner[msid][k][jj][kk][l][m]+=floor(PRECP*(inverta[blockspos[(k*2*morder[msid])+jj]+l][blockspos[(k*2*morder[msid])+(jj+ii)%morder[msid]]+n]*mata[blockspos[(k*2*morder[msid])+(jj+ii)%morder[msid]]+n][blockspos[((k*2+1)* morder[msid])+kk]+m]*(-1.0)))/PRECP;
-											temp +=(inverta[blockspos[(k*2*morder[msid])+jj]+l][blockspos[(k*2*morder[msid])+(jj+ii)%morder[msid]]+n]*mata[blockspos[(k*2*morder[msid])+(jj+ii)%morder[msid]]+n][blockspos[((k*2+1)* morder[msid])+kk]+m]*(-1.0));
-											//mirror[msid].rpartnerblocks[k].blk[jj][kk].blkelement[l][m]+=floor(PRECP*(inverta[blockspos[(k*2*morder[msid])+jj]+l][blockspos[(k*2*morder[msid])+(jj+ii)%morder[msid]]+n]*mata[blockspos[(k*2*morder[msid])+(jj+ii)%morder[msid]]+n][blockspos[((k*2+1)* morder[msid])+kk]+m]*(-1.0)))/PRECP;
-										        #pragma omp atomic update
-											mirror[msid].rpartnerblocks[k].blk[jj][kk].blkelement[l][m]+=temp;
-											//printf("\n\t Test k %d ii %d\tjj %d\tkk %d\t l %d m %d temp %lf\n",k,ii,jj,kk,l,m,temp);
-											}
-											
-									
-								//mirror[msid].mirrormat[mirror[msid].mblockspos[k]+l][mirror[msid].mblockspos[k+1]+m]+=floor(PRECP*(-1.0*inverta[mirror[msid].mblockspos[k]+l][mirror[msid].mblockspos[k]+n]*mata[mirror[msid].mblockspos[k]+n][mirror[msid].mblockspos[k+1]+m]))/PRECP;
-								//}
-								//for(kk=0; kk<morder[msid]; kk++)
-								//{
-									//printf("\nmsid=%d, k=%d, ii=%d, jj=%d kk=%d\n",msid,k,ii,jj,kk);
-								}
-							}
-						}
-					}
-					#pragma omp for collapse(4) private(k,ii,jj,kk,l,m,n) reduction(+:temp)
+					TRACEBEGIN("-A^-1B, -D^-1C", i);
+					#pragma omp for collapse(3) private(k,jj,kk,p,a0,d0) schedule(runtime) nowait
 					for(k=0;k<(mblocksize[msid]/2);k++)
-					//for(k=0;k<(mirror[msid].mblocksize/2);k++)
-					{
-						for(ii=0; ii<morder[msid]; ii++)
-						//for(ii=0; ii<mirror[msid].morder; ii++)
-						{
-							for(jj=0; jj<morder[msid]; jj++)
-							//for(jj=0; jj<mirror[msid].morder; jj++)
+						for(jj=0; jj<morder[msid]; jj++)
+							for(kk=0; kk<morder[msid]; kk++)
 							{
-								for(kk=0; kk<morder[msid]; kk++)
+								a0=2*k*morder[msid];
+								d0=(2*k+1)*morder[msid];
+								prllblockzero(&mirror[msid].rpartnerblocks[k].blk[jj][kk]);
+								prllblockzero(&mirror[msid].lpartnerblocks[k].blk[jj][kk]);
+								for(p=0; p<morder[msid]; p++)
 								{
-									//printf("\nmsid=%d, k=%d, ii=%d, jj=%d kk=%d\n",msid,k,ii,jj,kk);
-									//for(l=0; l<lpartblkm[msid][k][jj][kk]; l++)
-									for(l=0; l<mirror[msid].lpartnerblocks[k].blk[jj][kk].blkm; l++)
-										//for(m=0; m<lpartblkn[msid][k][jj][kk]; m++)
-										for(m=0; m<mirror[msid].lpartnerblocks[k].blk[jj][kk].blkn; m++)
-											{
-											//temp=mlpartner[msid][k][jj][kk][l][m];
-											temp=0.0;//=mlpartner[msid][k][jj][kk][l][m];
-											//for(n=0; n<mirror[msid].lpartnerblocks[k].blk[jj][kk].blkm; n++)
-											//for(n=0, temp=mlpartner[msid][k][jj][kk][l][m];n<blocks[((k*2+1)*morder[msid])+(jj+ii)%morder[msid]];n++)
-											for(n=0;n<blocks[((k*2+1)*morder[msid])+(jj+ii)%morder[msid]];n++)
-											//mlpartner[msid][k][jj][kk][l][m]+=floor(PRECP*(inverta[blockspos[((k*2+1)*morder[msid])+jj]+l][blockspos[((k*2+1)*morder[msid])+(jj+ii)%morder[msid]]+n]*mata[blockspos[((k*2+1)*morder[msid])+(jj+ii)%morder[msid]]+n][blockspos[((2*k)*morder[msid])+kk]+m]*(-1.0)))/PRECP;
-											temp+=(inverta[blockspos[((k*2+1)*morder[msid])+jj]+l][blockspos[((k*2+1)*morder[msid])+(jj+ii)%morder[msid]]+n]*mata[blockspos[((k*2+1)*morder[msid])+(jj+ii)%morder[msid]]+n][blockspos[((2*k)*morder[msid])+kk]+m]*(-1.0));
-										        #pragma omp atomic update
-											mirror[msid].lpartnerblocks[k].blk[jj][kk].blkelement[l][m]+=temp;
-											//mlpartner[msid][k][jj][kk][l][m]+=temp;
-											//printf("\n\t Test k %d ii %d\tjj %d\tkk %d\t l %d m %d temp %lf\n",k,ii,jj,kk,l,m,temp);
-											}
-								//mirror[msid].mirrormat[mirror[msid].mblockspos[k]+l][mirror[msid].mblockspos[k+1]+m]+=floor(PRECP*(-1.0*inverta[mirror[msid].mblockspos[k]+l][mirror[msid].mblockspos[k]+n]*mata[mirror[msid].mblockspos[k]+n][mirror[msid].mblockspos[k+1]+m]))/PRECP;
+									prllmuladd(blocks[a0+jj], blocks[d0+kk], blocks[a0+p], -1.0, inverta, blockspos[a0+jj], blockspos[a0+p], mata, blockspos[a0+p], blockspos[d0+kk], mirror[msid].rpartnerblocks[k].blk[jj][kk].blkelement);
+									prllmuladd(blocks[d0+jj], blocks[a0+kk], blocks[d0+p], -1.0, inverta, blockspos[d0+jj], blockspos[d0+p], mata, blockspos[d0+p], blockspos[a0+kk], mirror[msid].lpartnerblocks[k].blk[jj][kk].blkelement);
 								}
 							}
-						}
-					}
-					//#pragma omp barrier
+					TRACEEND();
+					TRACEBARRIER(i)
 					//2. Calculation of S_A and S_D using A at the location Mirror (id=loopid[0]-2) which is msid
-					#pragma omp for collapse(3) private(k,ii,jj,l,m)
-					for(k=0;k<(mblocksize[msid]);k++)
-					//for(k=0;k<(mirror[msid].mblocksize);k++)
-					{
-						for(ii=0; ii<morder[msid]; ii++)
-						//for(ii=0; ii<mirror[msid].morder; ii++)
-						{
-							for(jj=0; jj<morder[msid]; jj++)
-							//for(jj=0; jj<mirror[msid].morder; jj++)
-							{
-								//for(l=0; l<sqrblkm[msid][k][ii][jj]; l++)
-								for(l=0; l<mirror[msid].sqrblocks[k].blk[ii][jj].blkm; l++)
-								//for(l=0; l<mirror[msid].sqrblocks[k].blk[ii][jj].blkm; l++)
-									//for(m=0; m<sqrblkn[msid][k][ii][jj]; m++)
-									for(m=0; m<mirror[msid].sqrblocks[k].blk[ii][jj].blkn; m++)
-									//for(m=0; m<mirror[msid].sqrblocks[k].blk[ii][jj].blkn; m++)
-										#pragma omp atomic write
-										mirror[msid].sqrblocks[k].blk[ii][jj].blkelement[l][m]=mata[blockspos[k*morder[msid]+ii]+l][blockspos[k*morder[msid]+jj]+m];
-										//msquare[msid][k][ii][jj][l][m]=mata[blockspos[k*morder[msid]+ii]+l][blockspos[k*morder[msid]+jj]+m];
-										//mirror[msid].sqrblocks[k].blk[ii][jj].blkelement[l][m]=mata[blockspos[k*mirror[msid].morder+ii]+l][blockspos[k*mirror[msid].morder+jj]+m];
-							}
-						}
-					}
-					#pragma omp for collapse(4) private(k,ii,jj,kk,l,m,n) reduction(+:temp)
+					TRACEBEGIN("Schur complements", i);
+					#pragma omp for collapse(3) private(k,jj,kk,p,a0,d0) schedule(runtime) nowait
 					for(k=0;k<(mblocksize[msid]/2);k++)
-					{
-						//for(ii=0; ii<mirror[msid].rpartnerblocks[k].brows; ii++)
-						for(ii=0; ii<morder[msid]; ii++)
-						{
-							//for(jj=0; jj<mirror[msid].rpartnerblocks[k].bcols; jj++)
-							for(jj=0; jj<morder[msid]; jj++)
+						for(jj=0; jj<morder[msid]; jj++)
+							for(kk=0; kk<morder[msid]; kk++)
 							{
-								for(kk=0; kk<morder[msid]; kk++)
+								a0=2*k*morder[msid];
+								d0=(2*k+1)*morder[msid];
+								prllblockcopy(mata, blockspos[a0+jj], blockspos[a0+kk], &mirror[msid].sqrblocks[2*k].blk[jj][kk]);
+								prllblockcopy(mata, blockspos[d0+jj], blockspos[d0+kk], &mirror[msid].sqrblocks[2*k+1].blk[jj][kk]);
+								for(p=0; p<morder[msid]; p++)
 								{
-									//printf("\nmsid=%d, k=%d, ii=%d, jj=%d kk=%d\n",msid,k,ii,jj,kk);
-									//for(l=0; l<sqrblkm[msid][2*k][jj][kk]; l++)
-									for(l=0; l<mirror[msid].sqrblocks[2*k].blk[jj][kk].blkm; l++)
-										//for(m=0; m<sqrblkn[msid][2*k][jj][kk]; m++)
-										for(m=0; m<mirror[msid].sqrblocks[2*k].blk[jj][kk].blkn; m++)
-											{
-											//temp=msquare[msid][2*k][jj][kk][l][m];
-											temp=0.0;//msquare[msid][2*k][jj][kk][l][m];
-											//for(n=0; n<lpartblkm[msid][k][(jj+ii)% morder[msid]][kk]; n++)
-											for(n=0; n<mirror[msid].lpartnerblocks[k].blk[(jj+ii)% morder[msid]][kk].blkm; n++)
-											//for(n=0; n<mirror[msid].lpartnerblocks[k].blk[(jj+ii)%mirror[msid].morder][kk].blkm; n++)
-											//temp+=floor(PRECP*(mata[blockspos[(k*2*morder[msid])+jj]+l][blockspos[((k*2+1)*morder[msid])+(jj+ii)% morder[msid]]+n] * mlpartner[msid][k][(jj+ii) % morder[msid]][kk][n][m]))/PRECP;
-											temp+=(mata[blockspos[(k*2*morder[msid])+jj]+l][blockspos[((k*2+1)*morder[msid])+(jj+ii)% morder[msid]]+n] * mirror[msid].lpartnerblocks[k].blk[(jj+ii) % morder[msid]][kk].blkelement[n][m]);
-										        #pragma omp atomic update
-											mirror[msid].sqrblocks[2*k].blk[jj][kk].blkelement[l][m]+=temp;
-											//msquare[msid][2*k][jj][kk][l][m]+=temp;
-											}
-											//mirror[msid].sqrblocks[2*k].blk[jj][kk].blkelement[l][m]+=floor(PRECP*(mata[blockspos[(k*2*mirror[msid].morder)+jj]+l][blockspos[((k*2+1)*mirror[msid].morder)+(jj+ii)%mirror[msid].morder]+n] * mirror[msid].lpartnerblocks[k].blk[(jj+ii)%mirror[msid].morder][kk].blkelement[n][m]))/PRECP;
-								//mirror[msid].mirrormat[mirror[msid].mblockspos[k]+l][mirror[msid].mblockspos[k+1]+m]+=floor(PRECP*(-1.0*inverta[mirror[msid].mblockspos[k]+l][mirror[msid].mblockspos[k]+n]*mata[mirror[msid].mblockspos[k]+n][mirror[msid].mblockspos[k+1]+m]))/PRECP;
+									prllmuladd(blocks[a0+jj], blocks[a0+kk], blocks[d0+p], 1.0, mata, blockspos[a0+jj], blockspos[d0+p], mirror[msid].lpartnerblocks[k].blk[p][kk].blkelement, 0, 0, mirror[msid].sqrblocks[2*k].blk[jj][kk].blkelement);
+									prllmuladd(blocks[d0+jj], blocks[d0+kk], blocks[a0+p], 1.0, mata, blockspos[d0+jj], blockspos[a0+p], mirror[msid].rpartnerblocks[k].blk[p][kk].blkelement, 0, 0, mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkelement);
 								}
 							}
-						}
-					}
-					#pragma omp for collapse(4) private(k,ii,jj,kk,l,m,n) reduction(+:temp)
-					for(k=0;k<(mblocksize[msid]/2);k++)
-					{
-						//for(ii=0; ii<mirror[msid].rpartnerblocks[k].brows; ii++)
-						for(ii=0; ii<morder[msid]; ii++)
-						{
-							//for(jj=0; jj<mirror[msid].rpartnerblocks[k].bcols; jj++)
-							for(jj=0; jj<morder[msid]; jj++)
-							{
-								for(kk=0; kk<morder[msid]; kk++)
-								{
-									//for(l=0; l<sqrblkm[msid][2*k+1][jj][kk]; l++)
-									for(l=0; l<mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkm; l++)
-										//for(m=0; m < sqrblkn[msid][2*k+1][jj][kk]; m++)
-										for(m=0; m < mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkn; m++)
-											{
-											//temp=msquare[msid][2*k+1][jj][kk][l][m];
-											temp=0.0;//msquare[msid][2*k+1][jj][kk][l][m];
-											//for(n=0; n < rpartblkm[msid][k][(jj+ii)%morder[msid]][kk]; n++)
-											for(n=0; n < mirror[msid].rpartnerblocks[k].blk[(jj+ii)%morder[msid]][kk].blkm; n++)
-											//for(n=0; n<mirror[msid].rpartnerblocks[k].blk[(jj+ii)%mirror[msid].morder][kk].blkm; n++)
-											//temp+=floor(PRECP*(mata[blockspos[((k*2+1)* morder[msid])+jj]+l][blockspos[((k*2)* morder[msid])+(jj+ii)% morder[msid]]+n] * mrpartner[msid][k][(jj+ii)% morder[msid]][kk][n][m]))/PRECP;
-											temp+=(mata[blockspos[((k*2+1)* morder[msid])+jj]+l][blockspos[((k*2)* morder[msid])+(jj+ii)% morder[msid]]+n] * mirror[msid].rpartnerblocks[k].blk[(jj+ii)% morder[msid]][kk].blkelement[n][m]);
-										        #pragma omp atomic update
-											mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkelement[l][m]+=temp;
-											//msquare[msid][2*k+1][jj][kk][l][m]+=temp;
-											}
-											//mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkelement[l][m]+=floor(PRECP*(mata[blockspos[((k*2+1)*mirror[msid].morder)+jj]+l][blockspos[((k*2)*mirror[msid].morder)+(jj+ii)%mirror[msid].morder]+n] * mirror[msid].rpartnerblocks[k].blk[(jj+ii)%mirror[msid].morder][kk].blkelement[n][m]))/PRECP;
-								}
-							}
-						}
-					}
+					TRACEEND();
+					TRACEBARRIER(i)
 				}
 
 			} //end of j==0 condition  
@@ -778,7 +712,8 @@ int invertblocks(int order, double** mata, double** inverta)
 					//}
 					//#pragma omp for collapse(2) private(k,ii)
 					//#pragma omp for private(k,ii)
-					#pragma omp for collapse(2) private(k,ii)
+					TRACEBEGIN("Schur inversion", i);
+					#pragma omp for collapse(2) private(k,ii) nowait
 					for(k=0;k<(mblocksize[mcid]);k++)
 					{
 						for(ii=0; ii<morder[mcid]; ii++)
@@ -786,9 +721,15 @@ int invertblocks(int order, double** mata, double** inverta)
 							//printf("invertmirror: \tmcid=%d\tk=%d\tii=%d\tmirror[mcid].morder=%d\tk*mirror[mcid].morder+ii=%d\tblocks=%d\tblockspos=%d\n",mcid,k,ii,mirror[mcid].morder, k*mirror[mcid].morder+ii,blocks[k*mirror[mcid].morder+ii],blockspos[k*mirror[mcid].morder+ii]);
 							
 							//invertcases(blocks[k*morder[mcid]+ii], 0, msquare[mcid][k][ii][ii], blockspos[k * morder[mcid]+ii], inverta);
-							invertcases(blocks[k*morder[mcid]+ii], 0, mirror[mcid].sqrblocks[k].blk[ii][ii].blkelement, blockspos[k * morder[mcid]+ii], inverta);
+							if(invertleaf(blocks[k*morder[mcid]+ii], 0, mirror[mcid].sqrblocks[k].blk[ii][ii].blkelement, blockspos[k * morder[mcid]+ii], inverta, leafwork, leafpivot)==0)
+							{
+								#pragma omp atomic write
+								invertstatus=0;
+							}
 						}
 					} 
+					TRACEEND();
+					TRACEBARRIER(i)
 					//#pragma omp for private(k)
 					///for(k=0;k<blocksize;k++)
 					///invertcases(blocks[k], blockspos[k], mirror[mcid].mirrormat, inverta);
@@ -811,208 +752,74 @@ int invertblocks(int order, double** mata, double** inverta)
 					
 					if(mcid>=0)
 					{
-					#pragma omp for private(k,ii,jj,kk,msiditr,l,m,n,ud, itr,itrn) reduction(+:temp1,temp2,temp3,temp4)
+					//Every iteration k owns the block-column k of inverta: it reads the blocks already computed in that column
+					//and writes the others, so no two threads touch the same element and no atomics are needed.
+					//The columns cost about the same, hence the static schedule.
+					TRACEBEGIN("up/down arrow", i);
+					#pragma omp for private(k,ii,jj,kk,msiditr,l,m,n,ud,nud,itr,temp,partner,dst,src) schedule(runtime) nowait
 					for(k=0;k<blocksize;k++)
-					//for(k=(mcid>=0)?0:blocksize;k<blocksize;k++)
-					//for(k=(mcid>=0)?0:order;k<blocksize;k++)
 					{
-						//printf("\n We are performing up down arrow upto mcid=%d with k=%d", mcid,k);
-						//loop for number of iterations: 2^mcid.  i.e. if mcid=0,1,2,3,... then no of iterations=1,2,4,8,...
+						//loop for number of iterations: mcid+1.
 						for(itr=0;itr<=mcid;itr++)
-						//for(itr=0;itr<((int)pow(2,mcid));itr++)
 						{
-							//printf("column k=%d\titeration count itr = %d\tmcid=%d\n",k,itr,mcid);
-							//printf("mcid=%d\tk=%d\tii=%d\tjj=%d\n",mcid,k,ii,jj);
-							if(itr==0) 
+							//jj is the first block of column k computed before this iteration, and jj+ud runs over the nud blocks computed.
+							if(itr==0)
+							{
 								jj=k;
-							else 
-							{ //itrn=itr-1;
-                                                                if(((int)(k/morder[itr-1]))%2==0)
-                                                                        jj=((int)(k/morder[itr-1]))*morder[itr-1]+morder[itr-1];
-                                                                else
-                                                                        jj=((int)(k/morder[itr-1]))*morder[itr-1]-morder[itr-1];
-                                                       
-							//	printf("\n in itr=%d testing morder of itr =%d",itr, morder[itr-1]);
+								nud=1;
+							}
+							else
+							{
+								if((k/morder[itr-1])%2==0)
+									jj=(k/morder[itr-1])*morder[itr-1]+morder[itr-1];
+								else
+									jj=(k/morder[itr-1])*morder[itr-1]-morder[itr-1];
+								nud=morder[itr-1];
 							}
 
-
-						//	printf("column k=%d\titeration count itr = %d\tmcid=%d\tmorder[itr-1]=%d\tjj=%d\n",k,itr,mcid,morder[itr-1],jj);
-									//jj=(((int)((int)(k/((int)pow(2,itr-1)))*((int)pow(2,itr-1)))%2)==0)?((int)(k/((int)pow(2,itr-1)))*((int)pow(2,itr-1)))+((int)pow(2,itr-1))+(k%((int)pow(2,itr-1))):((int)(k/((int)pow(2,itr-1)))*((int)pow(2,itr-1)))-((int)pow(2,itr-1))+(k%((int)pow(2,itr-1)));
-
-							//for(msid=itr;msid<=mcid;msid++)
-
-
-							//selection I block which has to be multiplied.
-							//we are keeping the information at kk.  So, (kk,k) is the location of I block
-							if(itr==0) 
-							{	//jj=k;
-									for(msiditr=itr;msiditr<=mcid;msiditr++) //only number of blocks in each column
+							for(ud=0;ud<nud;ud++)
+							{
+								for(msiditr=itr;msiditr<=mcid;msiditr++) //only number of blocks in each column
+								{
+									//(ii+kk,k) are the blocks of inverta to store, kk running over the order of the mirror msiditr.
+									if((k/morder[msiditr])%2==0)
+										ii=(k/morder[msiditr])*morder[msiditr]+morder[msiditr];
+									else
+										ii=(k/morder[msiditr])*morder[msiditr]-morder[msiditr];
+									if(itr==0)
 									{
-										//(ii,k)is the place in inverta to store.
-										//ii=((k/((int)pow(2,msid)))%2==0)?k+((int)pow(2,msid))-(k%((int)pow(2,msid))):k-((int)pow(2,msid))-(k%((int)pow(2,msid)));
-										//ii=((k/((int)pow(2,msid)))%2==0)?k+((int)pow(2,msid))-(k%((int)pow(2,msid))):k-((int)pow(2,msid))-(k%((int)pow(2,msid)));
-										if(((int)(k/morder[msiditr]))%2==0)
-											ii=((int)(k/morder[msiditr]))*morder[msiditr]+morder[msiditr];
-										else
-											ii=((int)(k/morder[msiditr]))*morder[msiditr]-morder[msiditr];
-										//ii=k+(int)pow(2,msid);
-										//ii is block selection at k th column.  ii itself is the row information based on ii and k.
-										//so, Storing at the block (ii,k).  ii has to be looped to order of msid.
-										for(kk=0;kk<(morder[msiditr]);kk++)
-												for(l=0;l<blocks[ii+kk];l++)
-												for(m=0;m<blocks[k];m++)
-													#pragma omp atomic update
-													inverta[blockspos[ii+kk]+l][blockspos[k]+m]*=0.0;
 										for(kk=0;kk<morder[msiditr];kk++)
-										{
-											//mirror column is I block location%msid order
-											//mirror row is looped to msid order
-											//storing: ii+kk, k.  kk is blk row.
-											//if((k/((int)pow(2,msid)))%2==1)
-											if(ii<jj)
-											{
-												//printf("\nBlock choice is rpartner blk=%d for k=%d, msid=%d\n",(int)k/((int)pow(2,msid+1)),k,msid);
-												//blkchoice=(int)k/((int)pow(2,msid+1));
-												//blkchoice=(int)k/(morder[msid]*2);
-												//printf("\nBlock choice is rpartner blk=%d for k=%d, msid=%d\n",blkchoice,k,msid);
-												//for(l=0;l< rpartblkm[msid][(int)k/((int)pow(2,msid+1))][kk][jj%((int)pow(2,msid))];l++)
-												for(l=0;l<blocks[ii+kk];l++)
-												//for(l=0;l<mirror[msid].rpartnerblocks[k/((int)pow(2,msid+1))].blk[0][0].blkm;l++)//.blk[kk][jj%((int)pow(2,msid))].blkm;l++)
-												//for(l=0;l<mirror[msid].rpartnerblocks[blkchoice].blk[kk][jj%((int)pow(2,msid))].blkm;l++)
+											for(l=0;l<blocks[ii+kk];l++)
 												for(m=0;m<blocks[k];m++)
-												{
-													temp1=0.0;
-													//inverta[blockspos[ii+kk]+l][blockspos[k]+m]=0.0;
-												for(n=0;n<blocks[jj];n++)
-												//for(n=0;n< rpartblkn[msid][(int)k/((int)pow(2,msid+1))][kk][jj%((int)pow(2,msid))];n++)
-												{
-													///inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=floor(PRECP*(mrpartner[msiditr][(int)k/((int)pow(2,msiditr+1))][kk][jj%((int)pow(2,msiditr))][l][n] * inverta[blockspos[jj]+n][blockspos[k]+m]))/PRECP;
-													//temp1+=floor(PRECP*(mrpartner[msiditr][(int)k/((int)pow(2,msiditr+1))][kk][jj%((int)pow(2,msiditr))][l][n] * inverta[blockspos[jj]+n][blockspos[k]+m]))/PRECP;
-													temp1+=(mirror[msiditr].rpartnerblocks[(int)k/((int)pow(2,msiditr+1))].blk[kk][jj%((int)pow(2,msiditr))].blkelement[l][n] * inverta[blockspos[jj]+n][blockspos[k]+m]);
-													//printf("\n Check mult: mirror msid=%d rpartner=%d blk(%d,%d) blkelement=%lf, \tinverta location=(%d,%d)\tvalue=%lf\tstoring:inva(%d,%d)", msid,(int)k/((int)pow(2,msid+1)),kk,jj%((int)pow(2,msid)),mirror[msid].rpartnerblocks[(int)k/((int)pow(2,msid+1))].blk[kk][jj%((int)pow(2,msid))].blkelement[l][n],blockspos[jj]+n,blockspos[k]+m,inverta[blockspos[jj]+n][blockspos[k]+m],blockspos[ii+kk]+l,blockspos[k]+m);
-												}
-													#pragma omp atomic update
-													inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=temp1;
-												}
-											}
-											else
-											{
-												//for(l=0;l < lpartblkm[msid][(int)k/((int)pow(2,msid+1))][kk][jj%((int)pow(2,msid))];l++)
-												for(l=0;l<blocks[ii+kk];l++)
-												//for(l=0;l<mirror[msid].rpartnerblocks[k/((int)pow(2,msid+1))].blk[0][0].blkm;l++)//.blk[kk][jj%((int)pow(2,msid))].blkm;l++)
-												//for(l=0;l<mirror[msid].rpartnerblocks[blkchoice].blk[kk][jj%((int)pow(2,msid))].blkm;l++)
-												for(m=0;m < blocks[k];m++)
-												{
-													temp2=0.0;
-													//inverta[blockspos[ii+kk]+l][blockspos[k]+m]=0.0;
-												//for(n=0;n<blocks[jj];n++)
-												for(n=0;n<blocks[jj];n++)
-												//for(n=0;n < lpartblkn[msid][(int)k/((int)pow(2,msid+1))][kk][jj%((int)pow(2,msid))];n++)
-												{
-													///inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=floor(PRECP*( mlpartner[msiditr][(int)k/((int)pow(2,msiditr+1))][kk][jj%((int)pow(2,msiditr))][l][n] * inverta[blockspos[jj]+n][blockspos[k]+m]))/PRECP;
-													//temp2+=floor(PRECP*( mlpartner[msiditr][(int)k/((int)pow(2,msiditr+1))][kk][jj%((int)pow(2,msiditr))][l][n] * inverta[blockspos[jj]+n][blockspos[k]+m]))/PRECP;
-													temp2+=( mirror[msiditr].lpartnerblocks[(int)k/((int)pow(2,msiditr+1))].blk[kk][jj%((int)pow(2,msiditr))].blkelement[l][n] * inverta[blockspos[jj]+n][blockspos[k]+m]);
-													//printf("\n Check mult: mirror msid=%d lpartner=%d blk(%d,%d) blkelement=%lf, \tinverta location=(%d,%d)\tvalue=%lf\tstoring:inva(%d,%d)", msid,(int)k/((int)pow(2,msid+1)),kk,jj%((int)pow(2,msid)),mirror[msid].lpartnerblocks[(int)k/((int)pow(2,msid+1))].blk[kk][jj%((int)pow(2,msid))].blkelement[l][n],blockspos[jj]+n,blockspos[k]+m,inverta[blockspos[jj]+n][blockspos[k]+m],blockspos[ii+kk]+l,blockspos[k]+m);
-												//for(l=0;l<mirror[msid].lpartnerblocks[(int)k/((int)pow(2,msid+1))].blk[kk][jj%((int)pow(2,msid))].blkm;l++)
-												//for(m=0;m<blocks[k];m++)
-												//{
-												//	inverta[blockspos[ii+kk]+l][blockspos[k]+m]=0.0;
-												//for(n=0;n<blocks[jj];n++)
-												//{
-												//	inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=mirror[msid].lpartnerblocks[(int)k/((int)pow(2,msid+1))].blk[kk][jj%((int)pow(2,msid))].blkelement[l][n]*inverta[blockspos[jj]+n][blockspos[k]+m];
-												}
-													#pragma omp atomic update
-													inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=temp2;
-												}
-												//for(l=0;mirror[msid].lpartnerblock[].blk[][].blkm;l++)
-											}
-										}	
-									//printf("\t check in itr=0 k=%d loop mcid=%d\t msid =%d\t jj=%d\tii=%d\t\n",k, mcid,msid,jj,ii);
-									//selection of I block to get multiplied. Based on k and itr
-	
-									//column for mirrors is row of I in the virtual block.
+													inverta[blockspos[ii+kk]+l][blockspos[k]+m]=0.0;
 									}
-							}
-							else 
-							{
-								//jj=((int)(k/((int)pow(2,itr-1)))%2==0)?k+((int)pow(2,itr-1))-(k%((int)pow(2,itr-1))):k-((int)pow(2,itr-1))-(k%((int)pow(2,itr-1)));
-								//jj=(((int)((int)(k/((int)pow(2,itr-1)))*((int)pow(2,itr-1)))%2)==0)?((int)(k/((int)pow(2,itr-1)))*((int)pow(2,itr-1)))+((int)pow(2,itr-1))+(k%((int)pow(2,itr-1))):((int)(k/((int)pow(2,itr-1)))*((int)pow(2,itr-1)))-((int)pow(2,itr-1))+(k%((int)pow(2,itr-1)));
-								for(ud=0; ud<((int)pow(2,itr-1));ud++)
-								{
-									//kk= ((k%((int)pow(2,itr)))%2==0)?k+((int)pow(2,itr))-(((int)pow(2,itr))):k-((int)pow(2,itr))-(((int)pow(2,itr)));
-									//jj+=ud;   ///rts we cannot change jj inthis place. it gives segmentation.
-									//for(ii=0;ii<((int)(pow(2,mcid)*2));ii++) //only number of blocks in each column
-									for(msiditr=itr;msiditr<=mcid;msiditr++) //only number of blocks in each column
+									for(kk=0;kk<morder[msiditr];kk++)
 									{
-										//(ii,k)is the place in inverta to store.
-										////ii=((k/((int)pow(2,msid)))%2==0)?k+((int)pow(2,msid))-(k%((int)pow(2,msid))):k-((int)pow(2,msid))-(k%((int)pow(2,msid)));
-										if(((int)(k/morder[msiditr]))%2==0)
-											ii=((int)(k/morder[msiditr]))*morder[msiditr]+morder[msiditr];
+										//mirror column is I block location%msid order, mirror row is kk.
+										if(ii<jj)
+											partner=&mirror[msiditr].rpartnerblocks[k/(2*morder[msiditr])].blk[kk][(jj+ud)%morder[msiditr]];
 										else
-											ii=((int)(k/morder[msiditr]))*morder[msiditr]-morder[msiditr];
-										//ii is block selection at k th column.  ii itself is the row information based on ii and k.
-										//so, Storing at the block (ii,k).  ii has to be looped to order of msid.
-										for(kk=0;kk<((int)pow(2,msiditr));kk++)
+											partner=&mirror[msiditr].lpartnerblocks[k/(2*morder[msiditr])].blk[kk][(jj+ud)%morder[msiditr]];
+										//Row by row: the partner tile is read in order and the rows of column k are streamed.
+										for(l=0;l<partner->blkm;l++)
 										{
-											//mirror column is I block location%msid order
-											//mirror row is looped to msid order
-											if(ii<jj)
-											{
-												//for(l=0;l < rpartblkm[msid][(int)k/((int)pow(2,msid+1))][kk][jj%((int)pow(2,msid))];l++)
-												for(l=0;l < blocks[ii+kk];l++)
-												for(m=0;m<blocks[k];m++)
-												{
-													temp3=0.0;
-												//for(n=0;n<blocks[jj];n++)
-												//for(n=0;n < rpartblkn[msiditr][(int)k/((int)pow(2,msiditr+1))][kk][(jj+ud)%((int)pow(2,msiditr))];n++)
-												for(n=0;n < mirror[msiditr].rpartnerblocks[(int)k/((int)pow(2,msiditr+1))].blk[kk][(jj+ud)%((int)pow(2,msiditr))].blkn;n++)
-												{
-													//inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=floor(PRECP*( mrpartner[msid][(int)k/((int)pow(2,msid+1))][kk][jj%((int)pow(2,msid))][l][n] * inverta[blockspos[jj]+n][blockspos[k]+m]))/PRECP;
-													///inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=floor(PRECP*( mrpartner[msiditr][(int)(k/((int)pow(2,msiditr+1)))][kk][(int)((jj+ud)%((int)pow(2,msiditr)))][l][n] * inverta[blockspos[jj+ud]+n][blockspos[k]+m]))/PRECP;
-													//temp3+=floor(PRECP*( mrpartner[msiditr][(int)(k/((int)pow(2,msiditr+1)))][kk][(int)((jj+ud)%((int)pow(2,msiditr)))][l][n] * inverta[blockspos[jj+ud]+n][blockspos[k]+m]))/PRECP;
-													temp3+=( mirror[msiditr].rpartnerblocks[(int)(k/((int)pow(2,msiditr+1)))].blk[kk][(int)((jj+ud)%((int)pow(2,msiditr)))].blkelement[l][n] * inverta[blockspos[jj+ud]+n][blockspos[k]+m]);
-													//printf("\n Testing: %d %d %d %d %d %d", blockspos[ii+kk], blockspos[k], (int)(k/((int)pow(2,msid+1))),(int)(jj%((int)pow(2,msid))),blockspos[jj],blockspos[k]);
-													//printf("\n Testing: %lf", mrpartner[msid][(int)(k/((int)pow(2,msid+1)))][kk][(int)(jj%((int)pow(2,msid)))][l][n]);// * inverta[blockspos[jj]+n][blockspos[k]+m]))/PRECP;
-													//printf("\n Testing: %lf \t %d\t%d", inverta[blockspos[jj]+n][blockspos[k]+m], blockspos[jj]+n,blockspos[k]+m);
-													//printf("\n Testing: jj+ud=%d blockspos[jj+ud]=%d \t %d\t%d", jj+ud,blockspos[jj+ud], blockspos[jj+ud]+n,blockspos[k]+m);
-												}
-													#pragma omp atomic update
-													inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=temp3;
-												}
-											}
-											else
+											dst=inverta[blockspos[ii+kk]+l]+blockspos[k];
+											for(n=0;n<partner->blkn;n++)
 											{
-												//for(l=0;l< lpartblkm[msid][(int)k/((int)pow(2,msid+1))][kk][jj%((int)pow(2,msid))];l++)
-												for(l=0;l< blocks[ii+kk];l++)
+												temp=partner->tile[l*partner->blkn+n];
+												src=inverta[blockspos[jj+ud]+n]+blockspos[k];
 												for(m=0;m<blocks[k];m++)
-												{
-													temp4=0.0;
-												//for(n=0;n<blocks[jj];n++)
-												//for(n=0;n< lpartblkn[msiditr][(int)k/((int)pow(2,msiditr+1))][kk][(jj+ud)%((int)pow(2,msiditr))];n++)
-												for(n=0;n< mirror[msiditr].lpartnerblocks[(int)k/((int)pow(2,msiditr+1))].blk[kk][(jj+ud)%((int)pow(2,msiditr))].blkn;n++)
-												{
-													//inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=floor(PRECP*(mlpartner[msid][(int)k/((int)pow(2,msid+1))][kk][jj%((int)pow(2,msid))][l][n] * inverta[blockspos[jj]+n][blockspos[k]+m]))/PRECP;
-													///inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=floor(PRECP*(mlpartner[msiditr][(int)(k/((int)pow(2,msiditr+1)))][kk][(int)((jj+ud)%((int)pow(2,msiditr)))][l][n] * inverta[blockspos[jj+ud]+n][blockspos[k]+m]))/PRECP;
-													//temp4+=floor(PRECP*(mlpartner[msiditr][(int)(k/((int)pow(2,msiditr+1)))][kk][(int)((jj+ud)%((int)pow(2,msiditr)))][l][n] * inverta[blockspos[jj+ud]+n][blockspos[k]+m]))/PRECP;
-													temp4+=(mirror[msiditr].lpartnerblocks[(int)(k/((int)pow(2,msiditr+1)))].blk[kk][(int)((jj+ud)%((int)pow(2,msiditr)))].blkelement[l][n] * inverta[blockspos[jj+ud]+n][blockspos[k]+m]);
-												}
-													//inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=floor(PRECP*(mirror[msid].lpartnerblocks[(int)k/((int)pow(2,msid+1))].blk[kk][jj%((int)pow(2,msid))].blkelement[l][n]*inverta[blockspos[jj]+n][blockspos[k]+m]))/PRECP;
-												//for(l=0;mirror[msid].lpartnerblock[].blk[][].blkm;l++)
-													#pragma omp atomic update
-													inverta[blockspos[ii+kk]+l][blockspos[k]+m]+=temp4;
-													
-												}
+													dst[m]+=temp*src[m];
 											}
-										}	
-									//printf("\t in ii loop mcid=%d\tk=%d\tii=%d\tjj=%d\n",mcid,k,ii,jj);
-									//selection of I block to get multiplied. Based on k and itr
-	
-									//column for mirrors is row of I in the virtual block.
+										}
 									}
 								}
 							}
 						}
-					 }  } 
+					}
+					TRACEEND();
+					TRACEBARRIER(i)
+					}
 				} 
 				else
 				{
@@ -1027,274 +834,192 @@ int invertblocks(int order, double** mata, double** inverta)
 					msid = loopid[i][j]-2;
 					//}
 					//#pragma omp barrier
-					#pragma omp for collapse(3) private(k,ii,jj,l,m)
-					for(k=0;k<(mblocksize[msid]/2);k++)
-					{
-						for(ii=0; ii<morder[msid]; ii++)
-						{
-							for(jj=0; jj<morder[msid]; jj++)
-							{
-								//for(l=0; l< rpartblkm[msid][k][ii][jj]; l++)
-								for(l=0; l< mirror[msid].rpartnerblocks[k].blk[ii][jj].blkm; l++)
-									//for(m=0; m< rpartblkn[msid][k][ii][jj]; m++)
-									for(m=0; m< mirror[msid].rpartnerblocks[k].blk[ii][jj].blkn; m++)
-										//mrpartner[msid][k][ii][jj][l][m]=0.0;
-										mirror[msid].rpartnerblocks[k].blk[ii][jj].blkelement[l][m]=0.0;
-							}
-						}
-					}
-					#pragma omp for collapse(3) private(k,ii,jj,l,m)
+					//The pair k of the mirror msid lies in the square block (2k*morder[msid])/morder[mcid] of the mirror mcid:
+					//its A half starts at the block ra of that square block and its D half at rd.
+					//1. -A^-1B and -D^-1C
+					TRACEBEGIN("-A^-1B, -D^-1C", i);
+					#pragma omp for collapse(3) private(k,jj,kk,p,a0,d0,ra,rd,sq) schedule(runtime) nowait
 					for(k=0;k<(mblocksize[msid]/2);k++)
-					{
-						for(ii=0; ii<morder[msid]; ii++)
-						{
-							for(jj=0; jj<morder[msid]; jj++)
-							{
-								//for(l=0; l< lpartblkm[msid][k][ii][jj]; l++)
-								for(l=0; l< mirror[msid].lpartnerblocks[k].blk[ii][jj].blkm; l++)
-									//for(m=0; m< lpartblkn[msid][k][ii][jj]; m++)
-									for(m=0; m< mirror[msid].lpartnerblocks[k].blk[ii][jj].blkn; m++)
-										//mlpartner[msid][k][ii][jj][l][m]=0.0;
-										mirror[msid].lpartnerblocks[k].blk[ii][jj].blkelement[l][m]=0.0;
-							}
-						}
-					}
-					#pragma omp for collapse(4) private(k,ii,jj,kk,l,m,n) reduction(+:temp)
-					for(k=0;k<(mblocksize[msid]/2);k++)
-					{
-						//for(ii=0; ii<mirror[msid].rpartnerblocks[k].brows; ii++)
-						for(ii=0; ii<morder[msid]; ii++)
-						{
-							//for(jj=0; jj<mirror[msid].rpartnerblocks[k].bcols; jj++)
-							for(jj=0; jj<morder[msid]; jj++)
+						for(jj=0; jj<morder[msid]; jj++)
+							for(kk=0; kk<morder[msid]; kk++)
 							{
-								for(kk=0; kk< morder[msid]; kk++)
+								a0=2*k*morder[msid];
+								d0=(2*k+1)*morder[msid];
+								sq=&mirror[mcid].sqrblocks[a0/morder[mcid]];
+								ra=a0%morder[mcid];
+								rd=ra+morder[msid];
+								prllblockzero(&mirror[msid].rpartnerblocks[k].blk[jj][kk]);
+								prllblockzero(&mirror[msid].lpartnerblocks[k].blk[jj][kk]);
+								for(p=0; p<morder[msid]; p++)
 								{
-									//printf("\nmsid=%d, k=%d, ii=%d, jj=%d kk=%d\n",msid,k,ii,jj,kk);
-									//for(l=0; l< rpartblkm[msid][k][jj][kk]; l++)
-									for(l=0; l< mirror[msid].rpartnerblocks[k].blk[jj][kk].blkm; l++)
-										//for(m=0; m<mirror[msid].rpartnerblocks[k].blk[jj][kk].blkn; m++)
-											//for(n=0; n<mirror[msid].rpartnerblocks[k].blk[jj][kk].blkm; n++)
-											//for(n=0; n<blocks[((k*2)*mirror[msid].morder)+(jj+ii)%mirror[msid].morder];n++)
-											//for(m=0;m< sqrblkn[mcid][(int)((2*k*morder[msid])/morder[mcid])][((2*k*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k)* morder[msid])% morder[mcid])+ morder[msid]+kk];m++)
-											for(m=0;m< mirror[mcid].sqrblocks[(int)((2*k*morder[msid])/morder[mcid])].blk[((2*k*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k)* morder[msid])% morder[mcid])+ morder[msid]+kk].blkn;m++)
-											{
-											temp=0.0;
-											//for(m=0;m<mirror[mcid].sqrblocks[(int)((2*k*mirror[msid].morder)/mirror[mcid].morder)].blk[((2*k*mirror[msid].morder)%mirror[mcid].morder)+(jj+ii)%mirror[msid].morder][(((2*k)*mirror[msid].morder)%mirror[mcid].morder)+mirror[msid].morder+kk].blkn;m++)
-											//for(n=0;n< sqrblkm[mcid][(int)((2*k*morder[msid])/morder[mcid])][((2*k*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k)*morder[msid])% morder[mcid])+ morder[msid]+kk];n++)
-											for(n=0;n< mirror[mcid].sqrblocks[(int)((2*k*morder[msid])/morder[mcid])].blk[((2*k*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k)*morder[msid])% morder[mcid])+ morder[msid]+kk].blkm;n++)
-											//for(n=0;n<mirror[mcid].sqrblocks[(int)((2*k*mirror[msid].morder)/mirror[mcid].morder)].blk[((2*k*mirror[msid].morder)%mirror[mcid].morder)+(jj+ii)%mirror[msid].morder][(((2*k)*mirror[msid].morder)%mirror[mcid].morder)+mirror[msid].morder+kk].blkm;n++)
-											///mrpartner[msid][k][jj][kk][l][m]+=floor(PRECP*(inverta[blockspos[(k*2* morder[msid])+jj]+l][blockspos[(k*2*morder[msid])+(jj+ii)% morder[msid]]+n]* msquare[mcid][(int)((2*k*morder[msid])/morder[mcid])][((2*k*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][((2*k*morder[msid])%morder[mcid])+morder[msid]+kk][n][m]*(-1.0)))/PRECP; ///rrrts change k to k+1.
-											//temp+=floor(PRECP*(inverta[blockspos[(k*2* morder[msid])+jj]+l][blockspos[(k*2*morder[msid])+(jj+ii)% morder[msid]]+n]* msquare[mcid][(int)((2*k*morder[msid])/morder[mcid])][((2*k*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][((2*k*morder[msid])%morder[mcid])+morder[msid]+kk][n][m]*(-1.0)))/PRECP; ///rrrts change k to k+1.
-											temp+=(inverta[blockspos[(k*2* morder[msid])+jj]+l][blockspos[(k*2*morder[msid])+(jj+ii)% morder[msid]]+n]* mirror[mcid].sqrblocks[(int)((2*k*morder[msid])/morder[mcid])].blk[((2*k*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][((2*k*morder[msid])%morder[mcid])+morder[msid]+kk].blkelement[n][m]*(-1.0)); ///rrrts change k to k+1.
-											//mirror[msid].rpartnerblocks[k].blk[jj][kk].blkelement[l][m]+=floor(PRECP*(inverta[blockspos[(k*2*mirror[msid].morder)+jj]+l][blockspos[(k*2*mirror[msid].morder)+(jj+ii)%mirror[msid].morder]+n]*mirror[mcid].sqrblocks[(int)((2*k*mirror[msid].morder)/mirror[mcid].morder)].blk[((2*k*mirror[msid].morder)%mirror[mcid].morder)+(jj+ii)%mirror[msid].morder][(((2*k+1)*mirror[msid].morder)%mirror[mcid].morder)+kk].blkelement[n][m]*(-1.0)))/PRECP; ///rrrts change k to k+1.
-//.blk[(k%mirror[mcid].morder)*mirror[msid].morder][(k%mirror[mcid].morder+1)*mirror[msid].morder].blkelement[n][m]*(-1.0);
-								// *mata[blockspos[(k*2*mirror[msid].morder)+(jj+ii)%mirror[msid].morder]+n][blockspos[((k*2+1)*mirror[msid].morder)+kk]+m]*(-1.0);
-											#pragma omp atomic update
-											mirror[msid].rpartnerblocks[k].blk[jj][kk].blkelement[l][m]+=temp;
-											//mrpartner[msid][k][jj][kk][l][m]+=temp;
-								 			}
+									prllmuladd(blocks[a0+jj], blocks[d0+kk], blocks[a0+p], -1.0, inverta, blockspos[a0+jj], blockspos[a0+p], sq->blk[ra+p][rd+kk].blkelement, 0, 0, mirror[msid].rpartnerblocks[k].blk[jj][kk].blkelement);
+									prllmuladd(blocks[d0+jj], blocks[a0+kk], blocks[d0+p], -1.0, inverta, blockspos[d0+jj], blockspos[d0+p], sq->blk[rd+p][ra+kk].blkelement, 0, 0, mirror[msid].lpartnerblocks[k].blk[jj][kk].blkelement);
 								}
 							}
-						}
-					}
-					#pragma omp for collapse(4) private(k,ii,jj,kk,l,m,n) reduction(+:temp)
-					for(k=0;k<(mblocksize[msid]/2);k++)
-					{
-						//for(ii=0; ii<mirror[msid].rpartnerblocks[k].brows; ii++)
-						for(ii=0; ii<morder[msid]; ii++)
-						{
-							//for(jj=0; jj<mirror[msid].rpartnerblocks[k].bcols; jj++)
-							for(jj=0; jj<morder[msid]; jj++)
-							{
-								for(kk=0; kk< morder[msid]; kk++)
-								{
-									//printf("\nmsid=%d, k=%d, ii=%d, jj=%d kk=%d\n",msid,k,ii,jj,kk);
-									//for(l=0; l< lpartblkm[msid][k][jj][kk]; l++)
-									for(l=0; l< mirror[msid].lpartnerblocks[k].blk[jj][kk].blkm; l++)
-										//for(m=0; m<mirror[msid].lpartnerblocks[k].blk[jj][kk].blkn; m++)
-											//for(n=0; n<mirror[msid].lpartnerblocks[k].blk[jj][kk].blkm; n++)
-											//for(n=0; n<blocks[((k*2+1)*mirror[msid].morder)+(jj+ii)%mirror[msid].morder];n++)
-											//for(m=0;m< sqrblkn[mcid][(int)(((2*k)*morder[msid])/morder[mcid])][(((2*k+1)*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k+1)*morder[msid])%morder[mcid])-morder[msid]+kk];m++)
-											for(m=0;m< mirror[mcid].sqrblocks[(int)(((2*k)*morder[msid])/morder[mcid])].blk[(((2*k+1)*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k+1)*morder[msid])%morder[mcid])-morder[msid]+kk].blkn;m++)
-											//for(m=0;m<mirror[mcid].sqrblocks[(int)(((2*k)*mirror[msid].morder)/mirror[mcid].morder)].blk[(((2*k+1)*mirror[msid].morder)%mirror[mcid].morder)+(jj+ii)%mirror[msid].morder][(((2*k+1)*mirror[msid].morder)%mirror[mcid].morder)-mirror[msid].morder+kk].blkn;m++)
-											{
-											temp=0.0;
-											//for(n=0;n< sqrblkm[mcid][(int)((2*k*morder[msid])/morder[mcid])][(((2*k+1)*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k+1)* morder[msid])%morder[mcid])-morder[msid]+kk];n++)
-											for(n=0;n< mirror[mcid].sqrblocks[(int)((2*k*morder[msid])/morder[mcid])].blk[(((2*k+1)*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k+1)* morder[msid])%morder[mcid])-morder[msid]+kk].blkm;n++)
-											//for(n=0;n<mirror[mcid].sqrblocks[(int)((2*k*mirror[msid].morder)/mirror[mcid].morder)].blk[(((2*k+1)*mirror[msid].morder)%mirror[mcid].morder)+(jj+ii)%mirror[msid].morder][(((2*k+1)*mirror[msid].morder)%mirror[mcid].morder)-mirror[msid].morder+kk].blkm;n++)
-											///mlpartner[msid][k][jj][kk][l][m]+=floor(PRECP*(inverta[blockspos[((k*2+1)*morder[msid])+jj]+l][blockspos[((k*2+1)*morder[msid])+(jj+ii)% morder[msid]]+n]* msquare[mcid][(int)(((2*k)*morder[msid])/morder[mcid])][(((2*k+1)*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k+1)*morder[msid])%morder[mcid])-morder[msid]+kk][n][m]*(-1.0)))/PRECP;
-											//temp+=floor(PRECP*(inverta[blockspos[((k*2+1)*morder[msid])+jj]+l][blockspos[((k*2+1)*morder[msid])+(jj+ii)% morder[msid]]+n]* msquare[mcid][(int)(((2*k)*morder[msid])/morder[mcid])][(((2*k+1)*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k+1)*morder[msid])%morder[mcid])-morder[msid]+kk][n][m]*(-1.0)))/PRECP;
-											temp+=(inverta[blockspos[((k*2+1)*morder[msid])+jj]+l][blockspos[((k*2+1)*morder[msid])+(jj+ii)% morder[msid]]+n]* mirror[mcid].sqrblocks[(int)(((2*k)*morder[msid])/morder[mcid])].blk[(((2*k+1)*morder[msid])%morder[mcid])+(jj+ii)%morder[msid]][(((2*k+1)*morder[msid])%morder[mcid])-morder[msid]+kk].blkelement[n][m]*(-1.0));
-											//mirror[msid].lpartnerblocks[k].blk[jj][kk].blkelement[l][m]+=floor(PRECP*(inverta[blockspos[((k*2+1)*mirror[msid].morder)+jj]+l][blockspos[((k*2+1)*mirror[msid].morder)+(jj+ii)%mirror[msid].morder]+n]*mirror[mcid].sqrblocks[(int)((2*k*mirror[msid].morder)/mirror[mcid].morder)].blk[(((2*k+1)*mirror[msid].morder)%mirror[mcid].morder)+(jj+ii)%mirror[msid].morder][(((2*k)*mirror[msid].morder)%mirror[mcid].morder)+kk].blkelement[n][m]*(-1.0)))/PRECP;///rrrts change 2k+1 to 2k.
-//.blk[(k%mirror[mcid].morder)*mirror[msid].morder][(k%mirror[mcid].morder+1)*mirror[msid].morder].blkelement[n][m]*(-1.0);
-								// *mata[blockspos[(k*2*mirror[msid].morder)+(jj+ii)%mirror[msid].morder]+n][blockspos[((k*2+1)*mirror[msid].morder)+kk]+m]*(-1.0);
-											//mirror[msid].lpartnerblocks[k].blk[jj][kk].blkelement[l][m]+=inverta[blockspos[((k*2+1)*mirror[msid].morder)+jj]+l][blockspos[((k*2+1)*mirror[msid].morder)+(jj+ii)%mirror[msid].morder]+n]*mata[blockspos[((k*2+1)*mirror[msid].morder)+(jj+ii)%mirror[msid].morder]+n][blockspos[((k*2)*mirror[msid].morder)+kk]+m]*(-1.0);
-											#pragma omp atomic update
-											mirror[msid].lpartnerblocks[k].blk[jj][kk].blkelement[l][m]+=temp;
-											//mlpartner[msid][k][jj][kk][l][m]+=temp;
-											}
-								}
-							}
-						}
-					}
-					
-					//#pragma omp barrier
+					TRACEEND();
+					TRACEBARRIER(i)
 					//2. Calculation of S_A and S_D for the mirror (id=loopid[j-1]-2)  at the location Mirror (id=loopid[j]-2)
-					#pragma omp for collapse(3) private(k,ii,jj,l,m)
-					for(k=0;k<(mblocksize[msid]);k++)
-					{
-						for(ii=0; ii<morder[msid]; ii++)
-						{
-							for(jj=0; jj<morder[msid]; jj++)
-							{
-								//for(l=0; l< sqrblkm[msid][k][ii][jj]; l++)
-								for(l=0; l< mirror[msid].sqrblocks[k].blk[ii][jj].blkm; l++)
-									//for(m=0; m< sqrblkn[msid][k][ii][jj]; m++)
-									for(m=0; m< mirror[msid].sqrblocks[k].blk[ii][jj].blkn; m++)
-										//msquare[msid][k][ii][jj][l][m]= msquare[mcid][(int)((k*morder[msid])/morder[mcid])][(((k)*morder[msid])%morder[mcid])+ii][(int)((k)*morder[msid])%morder[mcid]+jj][l][m];
-										mirror[msid].sqrblocks[k].blk[ii][jj].blkelement[l][m]= mirror[mcid].sqrblocks[(int)((k*morder[msid])/morder[mcid])].blk[(((k)*morder[msid])%morder[mcid])+ii][(int)((k)*morder[msid])%morder[mcid]+jj].blkelement[l][m];
-							}
-						}
-					}
-					#pragma omp for collapse(4) private(k,ii,jj,kk,l,m,n) reduction(+:temp)
-					for(k=0;k<(mblocksize[msid]/2);k++)
-					{
-						//for(ii=0; ii<mirror[msid].rpartnerblocks[k].brows; ii++)
-						for(ii=0; ii< morder[msid]; ii++)
-						{
-							//for(jj=0; jj<mirror[msid].rpartnerblocks[k].bcols; jj++)
-							for(jj=0; jj< morder[msid]; jj++)
-							{
-								for(kk=0; kk<morder[msid]; kk++)
-								{
-									//printf("\nmsid=%d, k=%d, ii=%d, jj=%d kk=%d\n",msid,k,ii,jj,kk);
-									//for(l=0; l< sqrblkm[msid][2*k][jj][kk]; l++)
-									for(l=0; l<mirror[msid].sqrblocks[2*k].blk[jj][kk].blkm; l++)
-										//for(m=0; m<mirror[msid].sqrblocks[2*k].blk[jj][kk].blkn; m++)
-										//for(m=0; m< lpartblkn[msid][k][(jj+ii)% morder[msid]][kk]; m++)
-										for(m=0; m<mirror[msid].lpartnerblocks[k].blk[(jj+ii)%morder[msid]][kk].blkn; m++)
-										{
-											temp=0.0;
-											//for(n=0; n< lpartblkm[msid][k][(jj+ii)%morder[msid]][kk]; n++)
-											for(n=0; n<mirror[msid].lpartnerblocks[k].blk[(jj+ii)%morder[msid]][kk].blkm; n++)
-											//for(n=0;n<mirror[mcid].sqrblocks[(int)(((2*k)*mirror[msid].morder)/mirror[mcid].morder)].blk[(((2*k)*mirror[msid].morder)%mirror[mcid].morder)+(jj)][((2*k)*mirror[msid].morder)%mirror[mcid].morder+mirror[msid].morder+(jj+ii)%mirror[msid].morder].blkn;n++)
-											//mirror[msid].sqrblocks[2*k].blk[jj][kk].blkelement[l][m]+= floor(PRECP*(mirror[mcid].sqrblocks[(int)((2*k*mirror[msid].morder)/mirror[mcid].morder)].blk[(((2*k)*mirror[msid].morder)%mirror[mcid].morder)+(jj)][(((2*k)*mirror[msid].morder)%mirror[mcid].morder)+mirror[msid].morder+(jj+ii)%mirror[msid].morder].blkelement[l][n] * mirror[msid].lpartnerblocks[k].blk[(jj+ii)%mirror[msid].morder][kk].blkelement[n][m]))/PRECP;
-											///msquare[msid][2*k][jj][kk][l][m]+= floor(PRECP*( msquare[mcid][(int)(((2*k)*morder[msid])/morder[mcid])][(((2*k)*morder[msid])%morder[mcid])+(jj)][((2*k)*morder[msid])%morder[mcid]+morder[msid]+(jj+ii)%morder[msid]][l][n] * mlpartner[msid][k][(jj+ii)%morder[msid]][kk][n][m]))/PRECP;
-											//temp+= floor(PRECP*( msquare[mcid][(int)(((2*k)*morder[msid])/morder[mcid])][(((2*k)*morder[msid])%morder[mcid])+(jj)][((2*k)*morder[msid])%morder[mcid]+morder[msid]+(jj+ii)%morder[msid]][l][n] * mlpartner[msid][k][(jj+ii)%morder[msid]][kk][n][m]))/PRECP;
-											temp+= ( mirror[mcid].sqrblocks[(int)(((2*k)*morder[msid])/morder[mcid])].blk[(((2*k)*morder[msid])%morder[mcid])+(jj)][((2*k)*morder[msid])%morder[mcid]+morder[msid]+(jj+ii)%morder[msid]].blkelement[l][n] * mirror[msid].lpartnerblocks[k].blk[(jj+ii)%morder[msid]][kk].blkelement[n][m]);
-								//mirror[msid].mirrormat[mirror[msid].mblockspos[k]+l][mirror[msid].mblockspos[k+1]+m]+=floor(PRECP*(-1.0*inverta[mirror[msid].mblockspos[k]+l][mirror[msid].mblockspos[k]+n]*mata[mirror[msid].mblockspos[k]+n][mirror[msid].mblockspos[k+1]+m]))/PRECP;
-											#pragma omp atomic update
-											mirror[msid].sqrblocks[2*k].blk[jj][kk].blkelement[l][m]+=temp;
-											//msquare[msid][2*k][jj][kk][l][m]+=temp;
-										}
-								}
-							}
-						}
-					}
-					#pragma omp for collapse(4) private(k,ii,jj,kk,l,m,n) reduction(+:temp)
+					TRACEBEGIN("Schur complements", i);
+					#pragma omp for collapse(3) private(k,jj,kk,p,a0,d0,ra,rd,sq) schedule(runtime) nowait
 					for(k=0;k<(mblocksize[msid]/2);k++)
-					{
-						//for(ii=0; ii<mirror[msid].rpartnerblocks[k].brows; ii++)
-						for(ii=0; ii< morder[msid]; ii++)
-						{
-							//for(jj=0; jj<mirror[msid].rpartnerblocks[k].bcols; jj++)
-							for(jj=0; jj< morder[msid]; jj++)
+						for(jj=0; jj<morder[msid]; jj++)
+							for(kk=0; kk<morder[msid]; kk++)
 							{
-								for(kk=0; kk<morder[msid]; kk++)
+								a0=2*k*morder[msid];
+								d0=(2*k+1)*morder[msid];
+								sq=&mirror[mcid].sqrblocks[a0/morder[mcid]];
+								ra=a0%morder[mcid];
+								rd=ra+morder[msid];
+								prllblockcopy(sq->blk[ra+jj][ra+kk].blkelement, 0, 0, &mirror[msid].sqrblocks[2*k].blk[jj][kk]);
+								prllblockcopy(sq->blk[rd+jj][rd+kk].blkelement, 0, 0, &mirror[msid].sqrblocks[2*k+1].blk[jj][kk]);
+								for(p=0; p<morder[msid]; p++)
 								{
-									//printf("\nmsid=%d, k=%d, ii=%d, jj=%d kk=%d\n",msid,k,ii,jj,kk);
-									//for(l=0; l< sqrblkm[msid][2*k+1][jj][kk]; l++) //rrrtschange added +1 with 2*k
-									for(l=0; l< mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkm; l++) //rrrtschange added +1 with 2*k
-									//for(l=0; l<mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkm; l++) //rrrtschange added +1 with 2*k
-										//for(m=0; m<mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkn; m++) //rrrtschange
-										//for(m=0; m< rpartblkn[msid][k][(jj+ii)%morder[msid]][kk]; m++)
-										for(m=0; m< mirror[msid].rpartnerblocks[k].blk[(jj+ii)%morder[msid]][kk].blkn; m++)
-										//for(m=0; m<mirror[msid].rpartnerblocks[k].blk[(jj+ii)%mirror[msid].morder][kk].blkn; m++)
-										{
-											temp=0.0;
-											//for(n=0; n<mirror[msid].rpartnerblocks[k].blk[(jj+ii)%mirror[msid].morder][kk].blkm; n++)
-											//for(n=0;n<(sqrblkn[mcid][(int)(((2*k+1)*morder[msid])/morder[mcid])][(((2*k+1)*morder[msid])%morder[mcid])+(jj)][((2*k+1)*morder[msid])%morder[mcid]-morder[msid]+(jj+ii)%morder[msid]]);n++)
-											for(n=0;n<(mirror[mcid].sqrblocks[(int)(((2*k+1)*morder[msid])/morder[mcid])].blk[(((2*k+1)*morder[msid])%morder[mcid])+(jj)][((2*k+1)*morder[msid])%morder[mcid]-morder[msid]+(jj+ii)%morder[msid]].blkn);n++)
-											//for(n=0;n<(mirror[mcid].sqrblocks[(int)(((2*k+1)*mirror[msid].morder)/mirror[mcid].morder)].blk[(((2*k+1)*mirror[msid].morder)%mirror[mcid].morder)+(jj)][((2*k+1)*mirror[msid].morder)%mirror[mcid].morder-mirror[msid].morder+(jj+ii)%mirror[msid].morder].blkn);n++)
-											///msquare[msid][2*k+1][jj][kk][l][m] += floor(PRECP*( msquare[mcid][(int)(((2*k+1)*morder[msid])/morder[mcid])][(((2*k+1)*morder[msid])%morder[mcid])+(jj)][((2*k+1)*morder[msid])%morder[mcid]-morder[msid]+(jj+ii)%morder[msid]][l][n] * mrpartner[msid][k][(jj+ii)% morder[msid]][kk][n][m]))/PRECP;
-											//temp+= floor(PRECP*( msquare[mcid][(int)(((2*k+1)*morder[msid])/morder[mcid])][(((2*k+1)*morder[msid])%morder[mcid])+(jj)][((2*k+1)*morder[msid])%morder[mcid]-morder[msid]+(jj+ii)%morder[msid]][l][n] * mrpartner[msid][k][(jj+ii)% morder[msid]][kk][n][m]))/PRECP;
-											temp+= ( mirror[mcid].sqrblocks[(int)(((2*k+1)*morder[msid])/morder[mcid])].blk[(((2*k+1)*morder[msid])%morder[mcid])+(jj)][((2*k+1)*morder[msid])%morder[mcid]-morder[msid]+(jj+ii)%morder[msid]].blkelement[l][n] * mirror[msid].rpartnerblocks[k].blk[(jj+ii)% morder[msid]][kk].blkelement[n][m]);
-											//mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkelement[l][m]+= floor(PRECP*(mirror[mcid].sqrblocks[(int)(((2*k+1)*mirror[msid].morder)/mirror[mcid].morder)].blk[(((2*k+1)*mirror[msid].morder)%mirror[mcid].morder)+(jj)][((2*k+1)*mirror[msid].morder)%mirror[mcid].morder-mirror[msid].morder+(jj+ii)%mirror[msid].morder].blkelement[l][n] * mirror[msid].rpartnerblocks[k].blk[(jj+ii)%mirror[msid].morder][kk].blkelement[n][m]))/PRECP;
-											#pragma omp atomic update
-											mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkelement[l][m]+=temp;
-											//msquare[msid][2*k+1][jj][kk][l][m]+=temp;
-										}
+									prllmuladd(blocks[a0+jj], blocks[a0+kk], blocks[d0+p], 1.0, sq->blk[ra+jj][rd+p].blkelement, 0, 0, mirror[msid].lpartnerblocks[k].blk[p][kk].blkelement, 0, 0, mirror[msid].sqrblocks[2*k].blk[jj][kk].blkelement);
+									prllmuladd(blocks[d0+jj], blocks[d0+kk], blocks[a0+p], 1.0, sq->blk[rd+jj][ra+p].blkelement, 0, 0, mirror[msid].rpartnerblocks[k].blk[p][kk].blkelement, 0, 0, mirror[msid].sqrblocks[2*k+1].blk[jj][kk].blkelement);
 								}
 							}
-						}
-					}
+					TRACEEND();
+					TRACEBARRIER(i)
 				} 
 			} //end of j!=0 condition 
 			
 			i++;
 		} while(i<noofloops);
 		
+		free(leafwork);
+		free(leafpivot);
 		//wtime = omp_get_wtime() - wtime;
 		//printf( "Time taken by thread %d is %f\n", omp_get_thread_num(), wtime );
 		//End of operation		
 	}
 	//printer(order, mata, inverta, (int)(sizeof(mirror)/sizeof(mirror[0])), mirror);
+#ifdef _OPENMP
+	omp_set_schedule(callerschedule, callerchunk);
+#endif
+	TRACESTOP(order);
 
+	free(slab);
+	free(morder);
+	free(mblocksize);
+
+	for(i=0;i<noofloops;i++) free(loopid[i]);
+
+	free(loopid);
+	free(blocks);
+	free(blockspos);
+	return invertstatus;
+}
+
+size_t mirrorslab(char *slab, int blocksize, int *blocks, int mirrorsize)
+{
+	//Lays out the mirrors in slab and returns the bytes used.  With slab NULL, only the bytes are counted.
+	//The mirror structs come first, then for each mirror its square blocks and its partner blocks,
+	//each block being a dense tile with its row pointers just before it.
+	int i,j,o,b;
+	size_t used=0;
+	struct mirrorstruct *mirror;
+	struct blockmat *sqr, *lpartner, *rpartner;
+
+	mirror=(struct mirrorstruct *)mirrorslabtake(slab, &used, mirrorsize*sizeof(struct mirrorstruct), sizeof(void *));
 	for(i=0;i<mirrorsize;i++)
 	{
-		for(j=0; j<mirror[i].mblocksize; j++)
+		o=1<<i;
+		b=blocksize/o;
+		sqr=(struct blockmat *)mirrorslabtake(slab, &used, b*sizeof(struct blockmat), sizeof(void *));
+		lpartner=(struct blockmat *)mirrorslabtake(slab, &used, (b/2)*sizeof(struct blockmat), sizeof(void *));
+		rpartner=(struct blockmat *)mirrorslabtake(slab, &used, (b/2)*sizeof(struct blockmat), sizeof(void *));
+		if(slab!=NULL)
 		{
-			for(k=0; k< mirror[i].sqrblocks[j].brows;k++)
-			{
-				for(l=0;l<mirror[i].sqrblocks[j].bcols;l++)
-				{
-					for(m=0;m<(mirror[i].sqrblocks[j].blk[k][l].blkm);m++) free(mirror[i].sqrblocks[j].blk[k][l].blkelement[m]);
-					free(mirror[i].sqrblocks[j].blk[k][l].blkelement);
-				}	
-				free(mirror[i].sqrblocks[j].blk[k]);
-			}
-			free(mirror[i].sqrblocks[j].blk);
+			mirror[i].morder=o;
+			mirror[i].mblocksize=b;
+			mirror[i].sqrblocks=sqr;
+			mirror[i].lpartnerblocks=lpartner;
+			mirror[i].rpartnerblocks=rpartner;
 		}
-		free(mirror[i].sqrblocks);
-		for(j=0; j<(mirror[i].mblocksize/2); j++)
+		for(j=0;j<b;j++)
 		{
-			for(k=0; k< mirror[i].rpartnerblocks[j].brows;k++)
-			{
-				for(l=0;l<mirror[i].rpartnerblocks[j].bcols;l++)
-				{
-					for(m=0;m<(mirror[i].rpartnerblocks[j].blk[k][l].blkm);m++) free(mirror[i].rpartnerblocks[j].blk[k][l].blkelement[m]);
-					free(mirror[i].rpartnerblocks[j].blk[k][l].blkelement);
-				}	
-				free(mirror[i].rpartnerblocks[j].blk[k]);
-			}
-			free(mirror[i].rpartnerblocks[j].blk);
+			mirrorblockmat(slab, &used, (slab!=NULL)?sqr+j:NULL, o, blocks+j*o, blocks+j*o);
+			if((j%2)==0)
+				mirrorblockmat(slab, &used, (slab!=NULL)?rpartner+j/2:NULL, o, blocks+j*o, blocks+(j+1)*o);
+			else
+				mirrorblockmat(slab, &used, (slab!=NULL)?lpartner+j/2:NULL, o, blocks+j*o, blocks+(j-1)*o);
 		}
-		free(mirror[i].rpartnerblocks);
-		for(j=0; j<(mirror[i].mblocksize/2); j++)
+	}
+	return ((used+INVMATALIGN-1)/INVMATALIGN)*INVMATALIGN;
+}
+
+void mirrorblockmat(char *slab, size_t *used, struct blockmat *bm, int morder, int *rowblocks, int *colblocks)
+{
+	//morder * morder blocks; the block (k,l) has rowblocks[k] rows and colblocks[l] columns.
+	int k,l,m;
+	struct block **blk, *row;
+	double **rows, *tile;
+
+	blk=(struct block **)mirrorslabtake(slab, used, morder*sizeof(struct block *), sizeof(void *));
+	if(bm!=NULL)
+	{
+		bm->brows=morder;
+		bm->bcols=morder;
+		bm->blk=blk;
+	}
+	for(k=0;k<morder;k++)
+	{
+		row=(struct block *)mirrorslabtake(slab, used, morder*sizeof(struct block), sizeof(void *));
+		if(bm!=NULL) blk[k]=row;
+		for(l=0;l<morder;l++)
 		{
-			for(k=0; k< mirror[i].lpartnerblocks[j].brows;k++)
-			{
-				for(l=0;l<mirror[i].lpartnerblocks[j].bcols;l++)
-				{
-					for(m=0;m<(mirror[i].lpartnerblocks[j].blk[k][l].blkm);m++) free(mirror[i].lpartnerblocks[j].blk[k][l].blkelement[m]);
-					free(mirror[i].lpartnerblocks[j].blk[k][l].blkelement);
-				}	
-				free(mirror[i].lpartnerblocks[j].blk[k]);
-			}
-			free(mirror[i].lpartnerblocks[j].blk);
+			rows=(double **)mirrorslabtake(slab, used, rowblocks[k]*sizeof(double *), sizeof(void *));
+			tile=(double *)mirrorslabtake(slab, used, rowblocks[k]*colblocks[l]*sizeof(double), INVMATALIGN);
+			if(bm==NULL) continue;
+			row[l].blkm=rowblocks[k];
+			row[l].blkn=colblocks[l];
+			row[l].tile=tile;
+			row[l].blkelement=rows;
+			for(m=0;m<rowblocks[k];m++) rows[m]=tile+m*colblocks[l];
 		}
-		free(mirror[i].lpartnerblocks);
 	}
-	free(mirror);
+}
 
-	for(i=0;i<noofloops;i++) free(loopid[i]);
+void *mirrorslabtake(char *slab, size_t *used, size_t bytes, size_t align)
+{
+	//Takes the next bytes of the slab starting at a multiple of align.  Returns NULL when only counting.
+	size_t start;
 
-	free(loopid);
-	free(blocks);
-	free(blockspos);
-	return 1;
+	start=((*used+align-1)/align)*align;
+	*used=start+bytes;
+	return (slab!=NULL)?(void *)(slab+start):NULL;
+}
+
+void prllmuladd(int m, int n, int k, double alpha, double **x, int xi, int xj, double **y, int yi, int yj, double **c)
+{
+	//c (m * n) += alpha * x (m * k at xi,xj) * y (k * n at yi,yj), row by row so that the rows of y and c are streamed.
+	int i,j,p;
+	double a, *ci, *yp;
+
+	for(i=0;i<m;i++)
+	{
+		ci=c[i];
+		for(p=0;p<k;p++)
+		{
+			a=alpha*x[xi+i][xj+p];
+			yp=y[yi+p]+yj;
+			for(j=0;j<n;j++) ci[j]+=a*yp[j];
+		}
+	}
 }
 
+void prllblockcopy(double **a, int ai, int aj, struct block *b)
+{
+	//b := the block of a at (ai,aj) with the order of b.
+	int l;
+
+	PERFBEGIN(INVPERFMIRROR);
+	for(l=0;l<b->blkm;l++) memcpy(b->blkelement[l], a[ai+l]+aj, b->blkn*sizeof(double));
+	PERFEND(INVPERFMIRROR);
+}
 
+void prllblockzero(struct block *b)
+{
+	memset(b->tile, 0, (size_t)b->blkm*b->blkn*sizeof(double));
+}
 
@@ -0,0 +1,142 @@
+// Machine configuration of the invertor files: values found by `autotune.c' for this machine, read from a text file
+// once, when the program starts.  The file has one "key = value" per line; # starts a comment.  Every module asks for
+// its own keys with invconfigint or invconfigdouble and keeps its compiled default when the file or the key is absent:
+//	leaf				order at and below which the recursion stops (`invertor_leaf.c', INVLEAFORDER)
+//	gemm_mc, gemm_kc, gemm_nc	cache blocks of invgemm (`invertor_gemm.c', GEMMMC, GEMMKC, GEMMNC)
+//	prll_block			order of the diagonal blocks of `invertor_by_prll.c' (PRLLBLOCKORDER)
+//	prll_chunk			chunk of its static OpenMP schedules (0: equal shares)
+//	threads				OpenMP threads of the engines (0: the OpenMP default)
+//	rate_<engine>			sequential rate of an engine, used by `invertor_dispatch.c'
+// The file is INVERTOR_CONFIG when set, else $HOME/.invertor.conf.  The environment variable INVERTOR_LEAF still
+// overrides the file.  The modules read their keys from constructors, before main, so no thread ever sees them change.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_CONFIG_C
+#define INVERTOR_CONFIG_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<ctype.h>
+
+#define INVCONFIGKEYS 64
+#define INVCONFIGKEY 32
+#define INVCONFIGVALUE 64
+
+struct invconfigentry
+{
+	char key[INVCONFIGKEY];
+	char value[INVCONFIGVALUE];
+};
+
+static struct invconfigentry invconfigtable[INVCONFIGKEYS];
+static int invconfigcount=-1;	//-1 until the file has been read
+
+const char *invconfigpath(char *path, size_t size);
+int invconfigload(void);
+const char *invconfigvalue(const char *key);
+int invconfigint(const char *key, int def);
+double invconfigdouble(const char *key, double def);
+
+const char *invconfigpath(char *path, size_t size)
+{
+	//INVERTOR_CONFIG, else $HOME/.invertor.conf, else .invertor.conf in the working directory.
+	const char *env;
+
+	env=getenv("INVERTOR_CONFIG");
+	if(env!=NULL && *env) snprintf(path, size, "%s", env);
+	else if((env=getenv("HOME"))!=NULL && *env) snprintf(path, size, "%s/.invertor.conf", env);
+	else snprintf(path, size, ".invertor.conf");
+	return path;
+}
+
+int invconfigload(void)
+{
+	//Reads the file once; returns the number of keys (0 without a file).  A malformed line is reported and skipped.
+	FILE *f;
+	char path[4096], line[256], *key, *value, *end;
+	int lineno;
+
+	if(invconfigcount>=0) return invconfigcount;
+	invconfigcount=0;
+	f=fopen(invconfigpath(path, sizeof(path)), "r");
+	if(f==NULL) return 0;
+	for(lineno=1;fgets(line, sizeof(line), f)!=NULL;lineno++)
+	{
+		if((end=strchr(line, '#'))!=NULL) *end=0;
+		for(key=line;isspace((unsigned char) *key);key++);
+		if(*key==0) continue;
+		value=strchr(key, '=');
+		if(value!=NULL)
+		{
+			for(end=value;end>key && isspace((unsigned char) end[-1]);end--);
+			*end=0;
+			for(value++;isspace((unsigned char) *value);value++);
+			for(end=value+strlen(value);end>value && isspace((unsigned char) end[-1]);end--);
+			*end=0;
+		}
+		//A key or value too long for the table would be cut and could read as another key: such lines are skipped too.
+		if(value==NULL || invconfigcount==INVCONFIGKEYS || strlen(key)>=INVCONFIGKEY || strlen(value)>=INVCONFIGVALUE)
+		{
+			printf("\nIgnoring line %d of the configuration %s\n",lineno,path);
+			continue;
+		}
+		memcpy(invconfigtable[invconfigcount].key, key, strlen(key)+1);
+		memcpy(invconfigtable[invconfigcount].value, value, strlen(value)+1);
+		invconfigcount++;
+	}
+	fclose(f);
+	return invconfigcount;
+}
+
+const char *invconfigvalue(const char *key)
+{
+	//Value of key as written in the file, NULL if absent.  The last line of a repeated key wins.
+	int i;
+	const char *value=NULL;
+
+	invconfigload();
+	for(i=0;i<invconfigcount;i++)
+		if(strcmp(invconfigtable[i].key, key)==0) value=invconfigtable[i].value;
+	return value;
+}
+
+int invconfigint(const char *key, int def)
+{
+	const char *value=invconfigvalue(key);
+	char *end;
+	long v;
+
+	if(value==NULL) return def;
+	v=strtol(value, &end, 10);
+	if(end==value || *end!=0) return def;
+	return (int) v;
+}
+
+double invconfigdouble(const char *key, double def)
+{
+	const char *value=invconfigvalue(key);
+	char *end;
+	double v;
+
+	if(value==NULL) return def;
+	v=strtod(value, &end);
+	if(end==value || *end!=0) return def;
+	return v;
+}
+
+#endif
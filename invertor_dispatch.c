@@ -0,0 +1,438 @@
+// One front end for all the engines.  The four engines define the same invertmat (and some helpers of the same name),
+// so each is included here with its colliding names renamed, giving distinct symbols in one translation unit:
+//	invertmatinplace (invertor_inplace_by_a.c), invertmatbya (invertor_by_a.c), invertmatbyad (invertor_by_ad.c),
+//	invertmatprll (invertor_by_prll.c), with their ...workspace(n) (and ...threadsworkspace(n, threads)) functions,
+// together with invertmatspd and invertmatpivot of `invertor_inplace_by_a.c'.  This file then defines invertmat itself,
+// which picks the engine at run time, so that it replaces the single engine included by a user program or is
+// compiled once into a library:
+//	gcc -O3 -march=native -fopenmp -c invertor_dispatch.c && ar rcs libinvertor.a invertor_dispatch.o
+
+// The choice (invertorchoose) is made by a cost model from the order n, the number of threads, a memory budget and
+// the structure of the matrix:
+//	structure: INVSTRUCTBLOCKS (leading blocks and their Schur complements invertible, as the engines assume),
+//		INVSTRUCTSPD (symmetric positive definite) or INVSTRUCTGENERAL (only nonsingular: block pivoting only, its
+//		result checked by dispatchresidual and redone by Gauss-Jordan with partial pivoting, invertmatgj, if the
+//		residual is over DISPATCHRESIDUAL);
+//	memory: the bytes the engine allocates besides the matrix and its inverse, from its workspace function for the
+//		threads of the estimate, must be
+//		within the budget (0 for no budget), so the out-of-place engines, which hold two copies, are used only when
+//		they fit;
+//	time: work W = 2 n^3 operations and span S (the critical path: the recursion of the engine down to its serial
+//		blocks), at the sequential rate of the engine, max(W / threads, S) / rate.
+// For small n no engine forks, the model is the rate alone and the serial in-place engine wins; for large n on many
+// threads the in-place engine is bound by its span, and the much shorter span of the blocks of invertor_by_prll.c
+// makes up for its lower rate when the threads are many enough.  The rates (dispatchrate) were measured by
+// `benchinvertor.c' on one core and are estimates only; `autotune.c' measures them for a machine.
+// Explain mode: with INVERTOR_EXPLAIN set (or invertorexplain(1)), every call of invertmat prints the estimates of every
+// engine and why the chosen one was taken.  INVERTOR_MEMORY sets the budget of invertmat in MB.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_DISPATCH_C
+#define INVERTOR_DISPATCH_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
+
+//invertor_inplace_by_a.c keeps the names of its helpers; only its entry points are renamed.
+#define invertmat invertmatinplace
+#define invertmatworkspace invertmatinplaceworkspace
+#define invertmatthreadsworkspace invertmatinplacethreadsworkspace
+#define invertmatws invertmatinplacews
+#include "invertor_inplace_by_a.c"
+#undef invertmat
+#undef invertmatworkspace
+#undef invertmatthreadsworkspace
+#undef invertmatws
+
+#define invertmat invertmatbya
+#define invertmatworkspace invertmatbyaworkspace
+#define invertmatws invertmatbyaws
+#define invertblocks byainvertblocks
+#define invertmatone byainvertmatone
+#define invertmattwo byainvertmattwo
+#define invertmatthree byainvertmatthree
+#define invertmatfour byainvertmatfour
+#include "invertor_by_a.c"
+#undef invertmat
+#undef invertmatworkspace
+#undef invertmatws
+#undef invertblocks
+#undef invertmatone
+#undef invertmattwo
+#undef invertmatthree
+#undef invertmatfour
+
+#define invertmat invertmatbyad
+#define invertmatworkspace invertmatbyadworkspace
+#define invertmatthreadsworkspace invertmatbyadthreadsworkspace
+#define invertmatws invertmatbyadws
+#define inplaceblocksbya adinplaceblocksbya
+#define inplaceblocksbyd adinplaceblocksbyd
+#define inplaceleaf adinplaceleaf
+#define inplaceleafworkspace adinplaceleafworkspace
+#define inplaceleftmatmul adinplaceleftmatmul
+#define inplacerightmatmul adinplacerightmatmul
+#define invertinplace adinvertinplace
+#define invertinplaceworkspace adinvertinplaceworkspace
+#define schurcomplement adschurcomplement
+#include "invertor_by_ad.c"
+#undef invertmat
+#undef invertmatworkspace
+#undef invertmatthreadsworkspace
+#undef invertmatws
+#undef inplaceblocksbya
+#undef inplaceblocksbyd
+#undef inplaceleaf
+#undef inplaceleafworkspace
+#undef inplaceleftmatmul
+#undef inplacerightmatmul
+#undef invertinplace
+#undef invertinplaceworkspace
+#undef schurcomplement
+
+#define invertmat invertmatprll
+#define invertmatworkspace invertmatprllworkspace
+#define invertmatthreadsworkspace invertmatprllthreadsworkspace
+#define invertblocks prllinvertblocks
+#define invertmatone prllinvertmatone
+#define invertmattwo prllinvertmattwo
+#define invertmatthree prllinvertmatthree
+#define invertmatfour prllinvertmatfour
+#include "invertor_by_prll.c"
+#undef invertmat
+#undef invertmatworkspace
+#undef invertmatthreadsworkspace
+#undef invertblocks
+#undef invertmatone
+#undef invertmattwo
+#undef invertmatthree
+#undef invertmatfour
+
+#define INVENGINEINPLACE 0
+#define INVENGINEBYA 1
+#define INVENGINEBYAD 2
+#define INVENGINEPRLL 3
+#define INVENGINESPD 4
+#define INVENGINEPIVOT 5
+#define INVENGINES 6
+
+#define INVSTRUCTBLOCKS 0	//leading blocks and their Schur complements invertible (diagonally dominant, ...)
+#define INVSTRUCTSPD 1		//symmetric positive definite
+#define INVSTRUCTGENERAL 2	//nonsingular, nothing more known
+
+#define DISPATCHREASON 2048
+
+//Largest residual |A x - b| / (|A| |x| + |b|) (infinity norms, x = A^-1 b for one vector b) accepted from invertmatpivot
+//for a general matrix; Gauss-Jordan with partial pivoting gives about n times the rounding error of a double.
+#ifndef DISPATCHRESIDUAL
+#define DISPATCHRESIDUAL 1e-10
+#endif
+
+struct invchoice
+{
+	int engine;			//chosen engine, -1 if none can be used
+	int threads;
+	double seconds[INVENGINES];	//estimated time, 0 for an engine that was excluded
+	size_t bytes[INVENGINES];	//bytes allocated by the engine besides the matrix and its inverse
+	char reason[DISPATCHREASON];	//the estimates and the choice, one line per engine
+};
+
+//Sequential rates in operations per second, counted as 2 n^3 for every engine (so invertmatspd, whose recursive block
+//inversion of the lower triangle needs about half the multiplications, shows as a higher rate), measured for orders 500 to 1500.  The keys rate_<engine> of the configuration, in GFLOP/s
+//(written by `autotune.c'), replace them at startup.
+static double dispatchrate[INVENGINES]={28e9, 25e9, 12e9, 5e9, 50e9, 28e9};
+static int dispatchexplain=-1;
+
+void dispatchconfig(void) __attribute__((constructor));
+const char *invertorname(int engine);
+void invertorexplain(int on);
+size_t invertorbudget(void);
+double dispatchspan(int engine, int n);
+size_t dispatchbytes(int engine, int n, int threads);
+double dispatchresidual(int n, double** mata, double** inverta);
+int invertmatgj(int n, double** mata, double** inverta);
+int invertorchoose(int n, int threads, size_t memory, int structure, struct invchoice *choice);
+int invertmatengine(int engine, int n, double** mata, double** inverta);
+int invertmatauto(int n, double** mata, double** inverta, size_t memory, int structure);
+int invertmat(int n, double** mata, double** inverta);
+
+const char *invertorname(int engine)
+{
+	//Names as printed by `benchinvertor.c'.
+	static const char *names[INVENGINES]={"inplace_by_a", "by_a", "by_ad", "by_prll", "spd", "pivot"};
+	if(engine<0 || engine>=INVENGINES) return "none";
+	return names[engine];
+}
+
+void dispatchconfig(void)
+{
+	int e;
+	char key[64];
+	double rate;
+
+	for(e=0;e<INVENGINES;e++)
+	{
+		snprintf(key, sizeof(key), "rate_%s", invertorname(e));
+		rate=invconfigdouble(key, 0);
+		if(rate>0) dispatchrate[e]=rate*1e9;
+	}
+}
+
+void invertorexplain(int on)
+{
+	dispatchexplain=on;
+}
+
+size_t invertorbudget(void)
+{
+	//Budget of invertmat from INVERTOR_MEMORY (MB), read once; 0 is no budget.
+	static int read=0;
+	static size_t budget=0;
+	const char *s;
+
+	if(read==0)
+	{
+		s=getenv("INVERTOR_MEMORY");
+		if(s!=NULL && atof(s)>0) budget=(size_t)(atof(s)*1048576.0);
+		read=1;
+	}
+	return budget;
+}
+
+double dispatchspan(int engine, int n)
+{
+	//Operations on the critical path of the engine for order n.
+	//inplace_by_a: blocks below INPLACETASKCUTOFF are serial; above it the two halves are inverted one after the other
+	//and the four products between them are split into tiles of INPLACETASKTILE, one tile being on the path.
+	//by_ad: the A and D halves run side by side.  by_prll: each level of the mirrors costs a few products of blocks.
+	//The others do not fork.
+	double dn=n, b;
+	int nblocks, levels;
+
+	switch(engine)
+	{
+		case INVENGINEINPLACE:
+			if(n<INPLACETASKCUTOFF) return 2*dn*dn*dn;
+			return dispatchspan(engine, n/2)+dispatchspan(engine, n-n/2)+4.0*INPLACETASKTILE*INPLACETASKTILE*dn;
+		case INVENGINEBYAD:
+			return (n<ADTASKCUTOFF)?2*dn*dn*dn:dn*dn*dn;
+		case INVENGINEPRLL:
+			nblocks=(n+prllblock-1)/prllblock;
+			if(nblocks==1) return 2*dn*dn*dn;
+			b=(n+nblocks-1)/nblocks;
+			for(levels=1;(1<<(levels-1))<nblocks;levels++);
+			return levels*8*b*b*b;
+	}
+	return 2*dn*dn*dn;
+}
+
+size_t dispatchbytes(int engine, int n, int threads)
+{
+	//Bytes allocated by the engine for order n with threads OpenMP threads; the serial engines ignore threads.
+	//For invertmatpivot the copy of invertmatgj, taken should its residual be too large, is counted too.
+	size_t pivot, gj;
+
+	switch(engine)
+	{
+		case INVENGINEINPLACE: return invertmatinplacethreadsworkspace(n, threads);
+		case INVENGINEBYA: return invertmatbyaworkspace(n);
+		case INVENGINEBYAD: return invertmatbyadthreadsworkspace(n, threads);
+		case INVENGINEPRLL: return invertmatprllthreadsworkspace(n, threads);
+		case INVENGINESPD: return invertmatspdworkspace(n);
+		case INVENGINEPIVOT:
+			pivot=invertmatpivotworkspace(n);
+			gj=(n<=0)?0:((size_t)n*n+invleafworksize(n))*sizeof(double)+n*sizeof(int);
+			return (pivot>gj)?pivot:gj;
+	}
+	return 0;
+}
+
+int invertorchoose(int n, int threads, size_t memory, int structure, struct invchoice *choice)
+{
+	//Estimates every engine and chooses the fastest that may be used; returns 0 if none may be used.
+	//threads 0 is invthreads(), memory 0 is no budget.
+	int e, usable, len;
+	double work, span, s;
+	const char *excluded;
+	char budget[64];
+
+	if(threads<=0) threads=invthreads();
+	memset(choice, 0, sizeof(*choice));
+	choice->engine=-1;
+	choice->threads=threads;
+	if(n<=0) return 0;
+
+	work=2.0*n*(double)n*n;
+	if(memory>0) snprintf(budget, sizeof(budget), "memory budget %.1f MB", memory/1048576.0);
+	else snprintf(budget, sizeof(budget), "no memory budget");
+	len=snprintf(choice->reason, DISPATCHREASON, "order %d, %d threads, %s, %s matrix:\n", n, threads, budget,
+		(structure==INVSTRUCTSPD)?"SPD":(structure==INVSTRUCTGENERAL)?"general":"block invertible");
+	for(e=0;e<INVENGINES;e++)
+	{
+		choice->bytes[e]=dispatchbytes(e, n, threads);
+
+		//The block engines need invertible leading blocks, which an SPD matrix has; invertmatspd needs SPD.
+		excluded=NULL;
+		if(structure==INVSTRUCTGENERAL && e!=INVENGINEPIVOT) excluded="needs invertible leading blocks";
+		else if(structure!=INVSTRUCTSPD && e==INVENGINESPD) excluded="needs a symmetric positive definite matrix";
+		else if(memory>0 && choice->bytes[e]>memory) excluded="over the memory budget";
+		usable=(excluded==NULL);
+
+		span=dispatchspan(e, n);
+		s=(work/threads>span)?work/threads:span;
+		s/=dispatchrate[e];
+		if(usable) choice->seconds[e]=s;
+		if(usable && (choice->engine<0 || s<choice->seconds[choice->engine])) choice->engine=e;
+
+		if(len<DISPATCHREASON)
+			len+=snprintf(choice->reason+len, DISPATCHREASON-len, "  %-12s %9.4g s  (parallelism %.1f, %.1f GFLOP/s sequential), %.1f MB%s%s\n",
+				invertorname(e), s, work/span, dispatchrate[e]*1e-9, choice->bytes[e]/1048576.0, usable?"":": excluded, ", usable?"":excluded);
+	}
+	if(len<DISPATCHREASON)
+	{
+		if(choice->engine<0) snprintf(choice->reason+len, DISPATCHREASON-len, "  no engine can be used%s\n",
+			(structure!=INVSTRUCTGENERAL)?"; for a matrix larger than the memory see invertfile of `invertor_ooc.c'":"");
+		else snprintf(choice->reason+len, DISPATCHREASON-len, "  chosen: %s, the least estimated time\n", invertorname(choice->engine));
+	}
+	return (choice->engine>=0);
+}
+
+int invertmatengine(int engine, int n, double** mata, double** inverta)
+{
+	switch(engine)
+	{
+		case INVENGINEINPLACE: return invertmatinplace(n, mata, inverta);
+		case INVENGINEBYA: return invertmatbya(n, mata, inverta);
+		case INVENGINEBYAD: return invertmatbyad(n, mata, inverta);
+		case INVENGINEPRLL: return invertmatprll(n, mata, inverta);
+		case INVENGINESPD: return invertmatspd(n, mata, inverta);
+		case INVENGINEPIVOT: return invertmatpivot(n, mata, inverta, NULL);
+	}
+	printf("\nUnable to invert: no engine %d\n",engine);
+	return 0;
+}
+
+int invertmatauto(int n, double** mata, double** inverta, size_t memory, int structure)
+{
+	//invertmat with an explicit memory budget (bytes, 0 for none) and structure (INVSTRUCT...).
+	struct invchoice choice;
+	int status;
+	double residual;
+
+	if(dispatchexplain<0) dispatchexplain=(getenv("INVERTOR_EXPLAIN")!=NULL);
+	status=invertorchoose(n, 0, memory, structure, &choice);
+	if(dispatchexplain) printf("\n%s", choice.reason);
+	if(status==0)
+	{
+		printf("\nUnable to invert the matrix of order %d: no engine fits\n",n);
+		return 0;
+	}
+	status=invertmatengine(choice.engine, n, mata, inverta);
+	if(structure==INVSTRUCTGENERAL && choice.engine==INVENGINEPIVOT && mata!=inverta)
+	{
+		//Block pivoting bounds the condition of its pivot blocks, not of the Schur complements: the result is checked
+		//against the matrix (not when it was inverted over itself) and redone by the slower Gauss-Jordan when poor.
+		residual=(status==1)?dispatchresidual(n, mata, inverta):1;
+		if(!(residual<=DISPATCHRESIDUAL))
+		{
+			if(dispatchexplain) printf("\n  residual %.3g of pivot over %.3g: inverted again by Gauss-Jordan with partial pivoting\n",residual,DISPATCHRESIDUAL);
+			status=invertmatgj(n, mata, inverta);
+		}
+	}
+	return status;
+}
+
+double dispatchresidual(int n, double** mata, double** inverta)
+{
+	//|A x - b| / (|A| |x| + |b|) in the infinity norm for x = inverta b, b a fixed vector of elements in [-1, 1]:
+	//about n times the rounding error of a double for a backward stable inversion, much more for an unstable one.
+	//Returns 1 when the memory is lacking, so that the caller takes the safe path.
+	int i, j;
+	unsigned int seed;
+	double *b, *x, anorm, xnorm, bnorm, rnorm, sum, rowsum;
+
+	b=(double *) malloc(2*(size_t)n*sizeof(double));
+	if(b==NULL) return 1;
+	x=b+n;
+	seed=12345;
+	for(i=0;i<n;i++)
+	{
+		seed=seed*1103515245u+12345u;
+		b[i]=((seed>>8)&0xffff)/32767.5-1;
+	}
+	xnorm=0;
+	bnorm=0;
+	for(i=0;i<n;i++)
+	{
+		for(sum=0,j=0;j<n;j++) sum+=inverta[i][j]*b[j];
+		x[i]=sum;
+		if(fabs(sum)>xnorm) xnorm=fabs(sum);
+		if(fabs(b[i])>bnorm) bnorm=fabs(b[i]);
+	}
+	anorm=0;
+	rnorm=0;
+	for(i=0;i<n;i++)
+	{
+		for(sum=-b[i],rowsum=0,j=0;j<n;j++)
+		{
+			sum+=mata[i][j]*x[j];
+			rowsum+=fabs(mata[i][j]);
+		}
+		if(fabs(sum)>rnorm) rnorm=fabs(sum);
+		if(rowsum>anorm) anorm=rowsum;
+	}
+	free(b);
+	if(!(rnorm==rnorm) || !(xnorm==xnorm)) return 1;
+	return rnorm/(anorm*xnorm+bnorm);
+}
+
+int invertmatgj(int n, double** mata, double** inverta)
+{
+	//Gauss-Jordan with partial pivoting (invleafgj of `invertor_leaf.c') over the whole matrix: the slowest engine,
+	//and the reference for the accuracy of the others.
+	int i, invertstatus, *pivot;
+	double *a, *work;
+
+	if(n<=0) return 0;
+	a=(double *) malloc(((size_t)n*n+invleafworksize(n))*sizeof(double)+n*sizeof(int));
+	if(a==NULL)
+	{
+		printf("\nUnable to allocate workspace for the matrix of order = %d\n",n);
+		return 0;
+	}
+	work=a+(size_t)n*n;
+	pivot=(int *) (work+invleafworksize(n));
+	for(i=0;i<n;i++) memcpy(a+(size_t)i*n, mata[i], n*sizeof(double));
+	invertstatus=invleafgj(n, a, n, pivot, work);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",n);
+	}
+	for(i=0;i<n;i++) memcpy(inverta[i], a+(size_t)i*n, n*sizeof(double));
+	free(a);
+	return invertstatus;
+}
+
+int invertmat(int n, double** mata, double** inverta)
+{
+	//The front end: a matrix with invertible leading blocks, as every engine assumes, within INVERTOR_MEMORY.
+	return invertmatauto(n, mata, inverta, invertorbudget(), INVSTRUCTBLOCKS);
+}
+
+#endif
@@ -0,0 +1,258 @@
+// Binary matrix files: a header of INVFILEHEADER bytes followed by the raw doubles, row by row, so that a matrix is
+// read and written without any parsing and the file can be mapped into memory and used in place.
+// Header (all fields 8 byte integers after the magic): magic "INVMAT01", version, dtype (INVFILEDOUBLE), layout
+// (INVFILEROWMAJOR), byte order check, rows m, columns n, leading dimension ld (doubles from one row to the next),
+// byte offset of element (0,0) and its alignment.  The rows are padded to ld = invmatld(n) and the data starts at
+// INVFILEALIGN (a page), so the mapped matrix has the layout of a descriptor of `invertor_matrix.c': invfilemap
+// gives a struct invmat over the mapped pages, on which the engines work directly.
+// invfilesave and invfileload exchange a file with the 2 dimensional arrays of the user program; with file 4,
+// invertmatfile(path) inverts the matrix of a file in place in its mapped pages.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_FILE_C
+#define INVERTOR_FILE_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdint.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+
+#include "invertor_matrix.c"
+
+#define INVFILEMAGIC "INVMAT01"
+#define INVFILEVERSION 1
+#define INVFILEDOUBLE 1		//dtype: 8 byte IEEE doubles
+#define INVFILEROWMAJOR 0	//layout: row by row
+#define INVFILEBYTEORDER 0x0102030405060708LL
+#define INVFILEHEADER 128
+#define INVFILEALIGN 4096
+
+struct invfileheader
+{
+	char magic[8];
+	int64_t version;
+	int64_t dtype;
+	int64_t layout;
+	int64_t byteorder;	//INVFILEBYTEORDER as written by the machine that saved the file
+	int64_t m;
+	int64_t n;
+	int64_t ld;
+	int64_t offset;		//byte offset of element (0,0)
+	int64_t alignment;	//offset and the row starts are multiples of it (rows: of INVMATALIGN)
+	int64_t reserved[(INVFILEHEADER-8)/8-9];
+};
+
+struct invfilemapping
+{
+	void *addr;		//mapped pages
+	size_t bytes;
+	struct invmat mat;	//view of the matrix in the pages
+};
+
+int invfilesave(const char *path, int m, int n, double** rows);
+int invfileload(const char *path, int m, int n, double** rows);
+int invfileorder(const char *path, int *m, int *n);
+int invfilemap(const char *path, int writable, struct invfilemapping *map);
+int invfileunmap(struct invfilemapping *map);
+int invfileheaderread(int fd, const char *path, struct invfileheader *h);
+int invfileio(int fd, void *buf, size_t bytes, off_t pos, int writing);
+
+int invfilesave(const char *path, int m, int n, double** rows)
+{
+	//Writes the (m * n) matrix rows to path, replacing the file.
+	int fd, i, status;
+	struct invfileheader h;
+
+	if(m<=0 || n<=0) return 0;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, INVFILEMAGIC, 8);
+	h.version=INVFILEVERSION;
+	h.dtype=INVFILEDOUBLE;
+	h.layout=INVFILEROWMAJOR;
+	h.byteorder=INVFILEBYTEORDER;
+	h.m=m;
+	h.n=n;
+	h.ld=invmatld(n);
+	h.offset=INVFILEALIGN;
+	h.alignment=INVFILEALIGN;
+
+	fd=open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+	if(fd<0)
+	{
+		printf("\nUnable to create the matrix file %s\n",path);
+		return 0;
+	}
+	//The padding of the rows is left as a hole of the file.
+	status=(ftruncate(fd, (off_t)h.offset+(off_t)m*h.ld*sizeof(double))==0);
+	if(status) status=invfileio(fd, &h, sizeof(h), 0, 1);
+	for(i=0;i<m && status;i++) status=invfileio(fd, rows[i], n*sizeof(double), (off_t)h.offset+(off_t)i*h.ld*sizeof(double), 1);
+	if(close(fd)!=0) status=0;
+	if(status==0) printf("\nUnable to write the matrix file %s\n",path);
+	return status;
+}
+
+int invfileload(const char *path, int m, int n, double** rows)
+{
+	//Reads the matrix of path into rows, which must be (m * n) as given by invfileorder.
+	int fd, i, status;
+	struct invfileheader h;
+
+	fd=open(path, O_RDONLY);
+	if(fd<0)
+	{
+		printf("\nUnable to open the matrix file %s\n",path);
+		return 0;
+	}
+	status=invfileheaderread(fd, path, &h);
+	if(status && (h.m!=m || h.n!=n))
+	{
+		printf("\nThe matrix file %s holds a (%lld * %lld) matrix, not (%d * %d)\n",path,(long long) h.m,(long long) h.n,m,n);
+		status=0;
+	}
+	for(i=0;i<m && status;i++) status=invfileio(fd, rows[i], n*sizeof(double), (off_t)h.offset+(off_t)i*h.ld*sizeof(double), 0);
+	if(status==0 && i>0) printf("\nUnable to read row %d of the matrix file %s\n",i-1,path);
+	close(fd);
+	return status;
+}
+
+int invfileorder(const char *path, int *m, int *n)
+{
+	//Rows and columns of the matrix of path.
+	int fd, status;
+	struct invfileheader h;
+
+	fd=open(path, O_RDONLY);
+	if(fd<0)
+	{
+		printf("\nUnable to open the matrix file %s\n",path);
+		return 0;
+	}
+	status=invfileheaderread(fd, path, &h);
+	close(fd);
+	if(status==0) return 0;
+	*m=(int) h.m;
+	*n=(int) h.n;
+	return 1;
+}
+
+int invfilemap(const char *path, int writable, struct invfilemapping *map)
+{
+	//Maps the file (shared, so that writes through map->mat go to the file when writable is 1) and sets map->mat to
+	//the matrix in the mapped pages.
+	int fd;
+	struct invfileheader h;
+	struct stat sb;
+
+	map->addr=NULL;
+	map->bytes=0;
+	fd=open(path, writable?O_RDWR:O_RDONLY);
+	if(fd<0)
+	{
+		printf("\nUnable to open the matrix file %s\n",path);
+		return 0;
+	}
+	if(invfileheaderread(fd, path, &h)==0 || fstat(fd, &sb)!=0)
+	{
+		close(fd);
+		return 0;
+	}
+	if((h.offset%INVMATALIGN)!=0 || ((h.ld*sizeof(double))%INVMATALIGN)!=0 || (size_t)sb.st_size<(size_t)h.offset+(size_t)h.m*h.ld*sizeof(double))
+	{
+		printf("\nThe matrix file %s cannot be mapped: unaligned rows or short file\n",path);
+		close(fd);
+		return 0;
+	}
+	map->bytes=(size_t)h.offset+(size_t)h.m*h.ld*sizeof(double);
+	map->addr=mmap(NULL, map->bytes, writable?(PROT_READ|PROT_WRITE):PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map->addr==MAP_FAILED)
+	{
+		printf("\nUnable to map %zu bytes of the matrix file %s\n",map->bytes,path);
+		map->addr=NULL;
+		return 0;
+	}
+	map->mat.m=(int) h.m;
+	map->mat.n=(int) h.n;
+	map->mat.ld=(int) h.ld;
+	map->mat.data=(double *) ((char *) map->addr+h.offset);
+	map->mat.base=NULL;
+	return 1;
+}
+
+int invfileunmap(struct invfilemapping *map)
+{
+	//Writes the modified pages back to the file and unmaps it.
+	int status;
+
+	if(map->addr==NULL) return 1;
+	status=(msync(map->addr, map->bytes, MS_SYNC)==0);
+	if(munmap(map->addr, map->bytes)!=0) status=0;
+	if(status==0) printf("\nUnable to write back the mapped matrix file\n");
+	map->addr=NULL;
+	map->mat.data=NULL;
+	return status;
+}
+
+int invfileheaderread(int fd, const char *path, struct invfileheader *h)
+{
+	//Reads and checks the header: only double matrices row by row, saved with the byte order of this machine.
+	if(invfileio(fd, h, sizeof(*h), 0, 0)==0 || memcmp(h->magic, INVFILEMAGIC, 8)!=0)
+	{
+		printf("\nThe file %s is not a matrix file\n",path);
+		return 0;
+	}
+	if(h->byteorder!=INVFILEBYTEORDER)
+	{
+		printf("\nThe matrix file %s was saved with another byte order\n",path);
+		return 0;
+	}
+	if(h->version!=INVFILEVERSION || h->dtype!=INVFILEDOUBLE || h->layout!=INVFILEROWMAJOR)
+	{
+		printf("\nThe matrix file %s has version %lld, type %lld and layout %lld: only version %d, doubles (%d) row by row (%d) are read\n",
+			path,(long long) h->version,(long long) h->dtype,(long long) h->layout,INVFILEVERSION,INVFILEDOUBLE,INVFILEROWMAJOR);
+		return 0;
+	}
+	if(h->m<=0 || h->n<=0 || h->m>INT32_MAX || h->n>INT32_MAX || h->ld<h->n || h->offset<INVFILEHEADER)
+	{
+		printf("\nThe matrix file %s has an invalid header\n",path);
+		return 0;
+	}
+	return 1;
+}
+
+int invfileio(int fd, void *buf, size_t bytes, off_t pos, int writing)
+{
+	//bytes at pos of the file, looping over the partial transfers of pread and pwrite.
+	char *p=(char *) buf;
+	ssize_t done;
+
+	while(bytes>0)
+	{
+		done=writing?pwrite(fd, p, bytes, pos):pread(fd, p, bytes, pos);
+		if(done<=0) return 0;
+		p+=done;
+		pos+=done;
+		bytes-=done;
+	}
+	return 1;
+}
+
+#endif
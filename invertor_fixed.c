@@ -0,0 +1,140 @@
+// Fixed order inversion kernels for the orders INVFIXEDMIN (5) to INVFIXEDMAX (16), the small blocks of the engines
+// and the detector geometry sizes.  The kernels are generated by the macro INVFIXEDKERNEL, one function per order,
+// so that every loop bound is a compile time constant: the compiler unrolls the loops and keeps the matrix in a local
+// array of fixed size (registers and L1) instead of addressing a block through a leading dimension.
+// Each kernel is Gauss-Jordan elimination with partial pivoting, the same arithmetic as the leaf of `invertor_leaf.c',
+// which calls them for these orders; the other engines reach them through the leaf or through invertfixed.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_FIXED_C
+#define INVERTOR_FIXED_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<math.h>
+
+#define INVFIXEDMIN 5
+#define INVFIXEDMAX 16
+
+int invertfixed(int n, const double *a, int lda, double *inva, int ldi);
+
+//Kernel NAME for order N: inva (leading dimension ldi) := a^-1 (leading dimension lda).  a and inva may be the same
+//block.  Returns 0, leaving inva untouched, when a pivot column is zero.
+#define INVFIXEDKERNEL(N, NAME) \
+int NAME(const double *a, int lda, double *inva, int ldi) \
+{ \
+	int i, j, k, p; \
+	int pivot[N]; \
+	double m[N][N], r[N], t, big, d, f; \
+	\
+	for(i=0;i<N;i++) \
+		_Pragma("GCC unroll 16") \
+		for(j=0;j<N;j++) m[i][j]=a[(size_t)i*lda+j]; \
+	\
+	for(k=0;k<N;k++) \
+	{ \
+		for(p=k,big=fabs(m[k][k]),i=k+1;i<N;i++) \
+			if(fabs(m[i][k])>big) \
+			{ \
+				big=fabs(m[i][k]); \
+				p=i; \
+			} \
+		if(big==0) return 0; \
+		pivot[k]=p; \
+		if(p!=k) \
+		{ \
+			_Pragma("GCC unroll 16") \
+			for(j=0;j<N;j++) \
+			{ \
+				t=m[k][j]; \
+				m[k][j]=m[p][j]; \
+				m[p][j]=t; \
+			} \
+		} \
+		\
+		/*r is row k of the inverse so far, with 1/pivot in column k.  Every row, row k too, is updated without a*/ \
+		/*branch and row k is then replaced by r.*/ \
+		d=1/m[k][k]; \
+		m[k][k]=1; \
+		_Pragma("GCC unroll 16") \
+		for(j=0;j<N;j++) r[j]=m[k][j]*d; \
+		_Pragma("GCC unroll 16") \
+		for(i=0;i<N;i++) \
+		{ \
+			f=m[i][k]; \
+			m[i][k]=0; \
+			_Pragma("GCC unroll 16") \
+			for(j=0;j<N;j++) m[i][j]-=f*r[j]; \
+		} \
+		_Pragma("GCC unroll 16") \
+		for(j=0;j<N;j++) m[k][j]=r[j]; \
+	} \
+	\
+	/*Swapping rows k and pivot[k] of the matrix swaps columns k and pivot[k] of its inverse.*/ \
+	for(k=N-1;k>=0;k--) \
+	{ \
+		if(pivot[k]==k) continue; \
+		for(i=0;i<N;i++) \
+		{ \
+			t=m[i][k]; \
+			m[i][k]=m[i][pivot[k]]; \
+			m[i][pivot[k]]=t; \
+		} \
+	} \
+	\
+	for(i=0;i<N;i++) \
+		_Pragma("GCC unroll 16") \
+		for(j=0;j<N;j++) inva[(size_t)i*ldi+j]=m[i][j]; \
+	return 1; \
+}
+
+INVFIXEDKERNEL(5, invertfixedfive)
+INVFIXEDKERNEL(6, invertfixedsix)
+INVFIXEDKERNEL(7, invertfixedseven)
+INVFIXEDKERNEL(8, invertfixedeight)
+INVFIXEDKERNEL(9, invertfixednine)
+INVFIXEDKERNEL(10, invertfixedten)
+INVFIXEDKERNEL(11, invertfixedeleven)
+INVFIXEDKERNEL(12, invertfixedtwelve)
+INVFIXEDKERNEL(13, invertfixedthirteen)
+INVFIXEDKERNEL(14, invertfixedfourteen)
+INVFIXEDKERNEL(15, invertfixedfifteen)
+INVFIXEDKERNEL(16, invertfixedsixteen)
+
+int invertfixed(int n, const double *a, int lda, double *inva, int ldi)
+{
+	//The kernel of order n.  Returns 0 for a singular block or an order outside INVFIXEDMIN ... INVFIXEDMAX.
+	switch(n)
+	{
+		case 5: return invertfixedfive(a, lda, inva, ldi);
+		case 6: return invertfixedsix(a, lda, inva, ldi);
+		case 7: return invertfixedseven(a, lda, inva, ldi);
+		case 8: return invertfixedeight(a, lda, inva, ldi);
+		case 9: return invertfixednine(a, lda, inva, ldi);
+		case 10: return invertfixedten(a, lda, inva, ldi);
+		case 11: return invertfixedeleven(a, lda, inva, ldi);
+		case 12: return invertfixedtwelve(a, lda, inva, ldi);
+		case 13: return invertfixedthirteen(a, lda, inva, ldi);
+		case 14: return invertfixedfourteen(a, lda, inva, ldi);
+		case 15: return invertfixedfifteen(a, lda, inva, ldi);
+		case 16: return invertfixedsixteen(a, lda, inva, ldi);
+	}
+	printf("\nNo fixed order kernel for order %d (orders %d to %d)\n", n, INVFIXEDMIN, INVFIXEDMAX);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,253 @@
+// Cache blocked matrix multiplication used for the Schur complement updates of the invertor engines.
+// Computes C := alpha * A * B + beta * C for row-major blocks addressed by a pointer and a leading dimension,
+// so that it can be called directly on sub-blocks of a `struct invmat' (see `invertor_matrix.c').
+// B is packed by panels of KC rows * NC columns (kept in L3), A by blocks of MC rows * KC columns (kept in L2),
+// and a register micro-kernel computes MR * NR tiles of C from slivers of the packed A and B (kept in L1).
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_GEMM_C
+#define INVERTOR_GEMM_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#include "invertor_config.c"
+
+//Register tile of C computed by the micro-kernel: MR rows * NR columns, NR being two vectors of GEMMVL doubles.
+//The vectors are GCC vector extensions; the compiler lowers them to the widest registers the target allows.
+#if defined(__AVX512F__)
+#define GEMMVL 8
+#elif defined(__AVX__)
+#define GEMMVL 4
+#else
+#define GEMMVL 2
+#endif
+#define GEMMMR 6
+#define GEMMNR (2*GEMMVL)
+//Cache blocking: MC and NC are multiples of MR and NR.  These are the defaults of gemm_mc, gemm_kc and gemm_nc of the
+//configuration (`invertor_config.c'), which gemmconfig reads into gemmmc, gemmkc and gemmnc at startup.
+#define GEMMMC 120
+#define GEMMKC 256
+#define GEMMNC 2048
+//Below this many multiply-adds, packing costs more than it saves.
+#define GEMMSMALL 32768
+
+typedef double gemmvec __attribute__((vector_size(GEMMVL*sizeof(double))));
+
+size_t invgemmworksize(int m, int n, int k);
+int invgemm(int m, int n, int k, double alpha, const double *a, int lda, const double *b, int ldb, double beta, double *c, int ldc, double *work);
+int invgemmtrans(int transa, int transb, int m, int n, int k, double alpha, const double *a, int lda, const double *b, int ldb, double beta, double *c, int ldc, double *work);
+void gemmpacka(int mc, int kc, const double *a, int ars, int acs, double *apack);
+void gemmpackb(int kc, int nc, const double *b, int brs, int bcs, double *bpack);
+void gemmmicrokernel(int kc, double alpha, const double *apack, const double *bpack, double *c, int ldc, int mr, int nr);
+void gemmconfig(void) __attribute__((constructor));
+
+static int gemmmc=GEMMMC, gemmkc=GEMMKC, gemmnc=GEMMNC;
+
+void gemmconfig(void)
+{
+	//The blocks of the configuration, rounded to the register tile; values below one tile are ignored.
+	int v;
+
+	v=invconfigint("gemm_mc", GEMMMC);
+	if(v>=GEMMMR) gemmmc=(v/GEMMMR)*GEMMMR;
+	v=invconfigint("gemm_kc", GEMMKC);
+	if(v>=1) gemmkc=v;
+	v=invconfigint("gemm_nc", GEMMNC);
+	if(v>=GEMMNR) gemmnc=(v/GEMMNR)*GEMMNR;
+}
+
+size_t invgemmworksize(int m, int n, int k)
+{
+	//Number of doubles needed for the packed blocks of A and B for this product.
+	size_t mc, kc, nc;
+
+	mc=(m<gemmmc)?m:gemmmc;
+	kc=(k<gemmkc)?k:gemmkc;
+	nc=(n<gemmnc)?n:gemmnc;
+	mc=((mc+GEMMMR-1)/GEMMMR)*GEMMMR;
+	nc=((nc+GEMMNR-1)/GEMMNR)*GEMMNR;
+	return mc*kc+kc*nc;
+}
+
+int invgemm(int m, int n, int k, double alpha, const double *a, int lda, const double *b, int ldb, double beta, double *c, int ldc, double *work)
+{
+	//a is (m * k), b is (k * n) and c is (m * n).  c must not overlap a or b.
+	//work holds invgemmworksize(m,n,k) doubles.  If it is NULL, the packing buffers are allocated here.
+	return invgemmtrans(0, 0, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc, work);
+}
+
+int invgemmtrans(int transa, int transb, int m, int n, int k, double alpha, const double *a, int lda, const double *b, int ldb, double beta, double *c, int ldc, double *work)
+{
+	//As invgemm, with A^T (a stored as (k * m)) when transa is 1 and B^T (b stored as (n * k)) when transb is 1.
+	//A transposed operand only changes the strides used when it is packed.
+
+	int i,j,p;
+	int ic, jc, pc, ir, jr, mc, nc, kc;
+	int ars, acs, brs, bcs;
+	double ap, *apack, *bpack, *owned, *ci;
+	const double *bp;
+	size_t mcmax;
+
+	if(m<=0 || n<=0) return 1;
+
+	if(beta==0)
+	{
+		for(i=0;i<m;i++) memset(c+(size_t)i*ldc, 0, n*sizeof(double));
+	}
+	else if(beta!=1)
+	{
+		for(i=0;i<m;i++)
+			for(j=0;j<n;j++)
+				c[(size_t)i*ldc+j]*=beta;
+	}
+	if(k<=0 || alpha==0) return 1;
+
+	//Element (i,p) of A is a[i*ars+p*acs] and element (p,j) of B is b[p*brs+j*bcs].
+	ars=(transa==0)?lda:1;
+	acs=(transa==0)?1:lda;
+	brs=(transb==0)?ldb:1;
+	bcs=(transb==0)?1:ldb;
+
+	if((double)m*n*k<GEMMSMALL)
+	{
+		for(i=0;i<m;i++)
+		{
+			ci=c+(size_t)i*ldc;
+			for(p=0;p<k;p++)
+			{
+				ap=alpha*a[(size_t)i*ars+(size_t)p*acs];
+				bp=b+(size_t)p*brs;
+				if(bcs==1) for(j=0;j<n;j++) ci[j]+=ap*bp[j];
+				else for(j=0;j<n;j++) ci[j]+=ap*bp[(size_t)j*bcs];
+			}
+		}
+		return 1;
+	}
+
+	owned=NULL;
+	if(work==NULL)
+	{
+		owned=(double *) aligned_alloc(64, ((invgemmworksize(m,n,k)*sizeof(double)+63)/64)*64);
+		if(owned==NULL)
+		{
+			printf("\nUnable to allocate the packing buffers for multiplication of order %d * %d * %d\n",m,k,n);
+			return 0;
+		}
+		work=owned;
+	}
+	mcmax=(m<gemmmc)?m:gemmmc;
+	mcmax=((mcmax+GEMMMR-1)/GEMMMR)*GEMMMR;
+	apack=work;
+	bpack=work+mcmax*((k<gemmkc)?k:gemmkc);
+
+	for(jc=0;jc<n;jc+=gemmnc)
+	{
+		nc=(n-jc<gemmnc)?n-jc:gemmnc;
+		for(pc=0;pc<k;pc+=gemmkc)
+		{
+			kc=(k-pc<gemmkc)?k-pc:gemmkc;
+			gemmpackb(kc, nc, b+(size_t)pc*brs+(size_t)jc*bcs, brs, bcs, bpack);
+			for(ic=0;ic<m;ic+=gemmmc)
+			{
+				mc=(m-ic<gemmmc)?m-ic:gemmmc;
+				gemmpacka(mc, kc, a+(size_t)ic*ars+(size_t)pc*acs, ars, acs, apack);
+				for(jr=0;jr<nc;jr+=GEMMNR)
+					for(ir=0;ir<mc;ir+=GEMMMR)
+						gemmmicrokernel(kc, alpha, apack+(size_t)ir*kc, bpack+(size_t)jr*kc, c+(size_t)(ic+ir)*ldc+jc+jr, ldc, (mc-ir<GEMMMR)?mc-ir:GEMMMR, (nc-jr<GEMMNR)?nc-jr:GEMMNR);
+			}
+		}
+	}
+
+	if(owned!=NULL) free(owned);
+	return 1;
+}
+
+void gemmpacka(int mc, int kc, const double *a, int ars, int acs, double *apack)
+{
+	//Slivers of MR rows: for every column p, the MR elements of the sliver are contiguous.
+	//Rows beyond mc are padded with zeros, so the micro-kernel never tests for the edge.
+	int i,ir,p,mr;
+
+	for(ir=0;ir<mc;ir+=GEMMMR)
+	{
+		mr=(mc-ir<GEMMMR)?mc-ir:GEMMMR;
+		for(p=0;p<kc;p++)
+		{
+			for(i=0;i<mr;i++) apack[i]=a[(size_t)(ir+i)*ars+(size_t)p*acs];
+			for(;i<GEMMMR;i++) apack[i]=0;
+			apack+=GEMMMR;
+		}
+	}
+}
+
+void gemmpackb(int kc, int nc, const double *b, int brs, int bcs, double *bpack)
+{
+	//Slivers of NR columns: for every row p, the NR elements of the sliver are contiguous.
+	int j,jr,p,nr;
+	const double *bp;
+
+	for(jr=0;jr<nc;jr+=GEMMNR)
+	{
+		nr=(nc-jr<GEMMNR)?nc-jr:GEMMNR;
+		for(p=0;p<kc;p++)
+		{
+			bp=b+(size_t)p*brs+(size_t)jr*bcs;
+			if(bcs==1) for(j=0;j<nr;j++) bpack[j]=bp[j];
+			else for(j=0;j<nr;j++) bpack[j]=bp[(size_t)j*bcs];
+			for(;j<GEMMNR;j++) bpack[j]=0;
+			bpack+=GEMMNR;
+		}
+	}
+}
+
+void gemmmicrokernel(int kc, double alpha, const double *apack, const double *bpack, double *c, int ldc, int mr, int nr)
+{
+	//C(mr * nr) += alpha * Apack * Bpack.  The MR * 2 vector accumulators stay in registers over the kc loop:
+	//each step loads two vectors of the B sliver and broadcasts the MR elements of the A sliver.
+	int i,j,p;
+	gemmvec ab[GEMMMR][2], b0, b1, ai;
+	double tile[GEMMMR][GEMMNR];
+
+	for(i=0;i<GEMMMR;i++)
+	{
+		ab[i][0]=(gemmvec){0};
+		ab[i][1]=(gemmvec){0};
+	}
+
+	for(p=0;p<kc;p++)
+	{
+		__builtin_memcpy(&b0, bpack, sizeof(gemmvec));
+		__builtin_memcpy(&b1, bpack+GEMMVL, sizeof(gemmvec));
+		for(i=0;i<GEMMMR;i++)
+		{
+			ai=apack[i]-(gemmvec){0};
+			ab[i][0]+=ai*b0;
+			ab[i][1]+=ai*b1;
+		}
+		apack+=GEMMMR;
+		bpack+=GEMMNR;
+	}
+
+	__builtin_memcpy(tile, ab, sizeof(tile));
+	for(i=0;i<mr;i++)
+		for(j=0;j<nr;j++)
+			c[(size_t)i*ldc+j]+=alpha*tile[i][j];
+}
+
+#endif
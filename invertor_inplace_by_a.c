@@ -24,36 +24,271 @@
 #include<stdlib.h>
 
 //#include "matgeneral.c"
+#include "invertor_matrix.c"
+#include "invertor_gemm.c"
+#include "invertor_simd.c"
+#include "invertor_leaf.c"
+#include "invertor_perf.c"
+#include "invertor_spd.c"
+#include "invertor_update.c"
+#include "invertor_file.c"
 
-int invertinplace(int order, double** mat, int pos);
-int inplaceblocksbya(int order, double** mat, int pos);
-int inplaceblocksbyd(int order, double** mat, int pos);
-int inplaceleftmatmul(double** mat, int ordera, int aposmn, int nb, int bposm, int bposn);
-int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm, int aposn);
-int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym);
+//With OpenMP, blocks of order INPLACETASKCUTOFF and above are inverted by tasks on panels and tiles of
+//INPLACETASKTILE rows or columns (inplaceblocksbyatasks).  Smaller blocks run the steps in order.
+#define INPLACETASKCUTOFF 512
+#define INPLACETASKTILE 256
+
+//Block pivoting (inplaceblockspivot) keeps the inverse of a diagonal block only when its reciprocal condition number
+//in the 1-norm is at least INPLACEPIVOTRCOND: elimination by a worse block loses about log10(1/rcond) digits more than
+//partial pivoting.  When no block qualifies, the level is inverted by the partially pivoted leaf instead.
+#ifndef INPLACEPIVOTRCOND
+#define INPLACEPIVOTRCOND 1e-2
+#endif
+
+//Inversion of a diagonal block in place, as invertinplace.  The steps after the first inversion of a level
+//(inplaceschurbya, inplaceschurbyd) take the inversion of the Schur complement as such a function.
+typedef int (*inplaceinvert)(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+
+int invertinplace(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+int inplaceblocksbya(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+int inplaceblocksbyd(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+int inplaceschurbya(int order, struct invmat *mat, int pos, inplaceinvert invert, struct invworkspace *ws);
+int inplaceschurbyd(int order, struct invmat *mat, int pos, inplaceinvert invert, struct invworkspace *ws);
+int invertinplacepivot(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+int inplaceblockspivot(int order, struct invmat *mat, int pos, int *perm, struct invworkspace *ws);
+double inplacediagscore(struct invmat *mat, int order, int pos);
+int inplacerowpivot(struct invmat *mat, int order, int pos, int *perm, double *row);
+void inplacecolumnunpivot(struct invmat *mat, int order, int pos, int *perm, double *row);
+size_t inplacepivotworkspace(int order);
+size_t invertmatpivotworkspace(int n);
+int invertmatpivotws(int n, double** mata, double** inverta, int *perm, void *work, size_t bytes);
+int invertmatpivot(int n, double** mata, double** inverta, int *perm);
+int inplaceleftmatmul(struct invmat *mat, int ordera, int aposmn, int nb, int bposm, int bposn, struct invworkspace *ws);
+int inplacerightmatmul(struct invmat *mat, int orderb, int bposmn, int ma, int aposm, int aposn, struct invworkspace *ws);
+int schurcomplement(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws);
+int schurcomplementtile(struct invmat *mat, int m, int n, int mposm, int mposn, int xposm, int xposn, int xn, int yposm, int yposn, struct invworkspace *ws);
+int inplaceblocksbyatasks(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+size_t invertinplaceworkspace(int order);
+int inplacethreads(int order, int threads);
+int inplaceleaf(int order, struct invmat *mat, int pos, struct invworkspace *ws);
+size_t inplaceleafworkspace(int order);
+size_t invertmatworkspace(int n);
+size_t invertmatthreadsworkspace(int n, int threads);
+int invertmatws(int n, double** mata, double** inverta, void *work, size_t bytes);
+int invertmatfile(const char *path);
 
 int invertmat(int n, double** mata, double** inverta)
 {
+	//Adapter for 2 dimensional arrays: one arena of invertmatworkspace(n) bytes is allocated
+	//for the whole inversion and handed to invertmatws.
+	int invertstatus;
+	size_t bytes;
+	void *work;
+	
+	if(n<=0) return 0;
+	
+	bytes=invertmatworkspace(n);
+	work=malloc(bytes);
+	if(work==NULL)
+	{
+		printf("\nUnable to allocate workspace of %zu bytes for the matrix of order = %d\n",bytes,n);
+		return 0;
+	}
+	invertstatus=invertmatws(n, mata, inverta, work, bytes);
+	free(work);
+	return invertstatus;
+}
+
+size_t invertmatworkspace(int n)
+{
+	//Bytes of the arena for invertmatws: alignment, the contiguous copy of the matrix and the scratch of invertinplace
+	//for each of the inplacethreads(n, invthreads()) threads.  Call it with the same number of OpenMP threads as invertmatws.
+	return invertmatthreadsworkspace(n, invthreads());
+}
+
+size_t invertmatthreadsworkspace(int n, int threads)
+{
+	//As invertmatworkspace for threads OpenMP threads.
+	if(n<=0) return 0;
+	return INVMATALIGN+invmatbytes(n, n)+invwsthreadsbytes(inplacethreads(n, threads), invertinplaceworkspace(n));
+}
+
+int inplacethreads(int order, int threads)
+{
+	//Threads of the team inverting a matrix of order order out of threads, hence arenas to allocate.  Below
+	//INPLACETASKCUTOFF no team is forked, so one arena is enough however many threads OpenMP offers.  Above it no step
+	//has more concurrent tasks than the tiles and panels of the larger half at the top level, so more threads would
+	//only hold idle arenas.
+	int tiles;
+
+	if(order<INPLACETASKCUTOFF || threads<1) return 1;
+	tiles=(order-order/2+INPLACETASKTILE-1)/INPLACETASKTILE;
+	if(threads>tiles*tiles+tiles) threads=tiles*tiles+tiles;
+	return threads;
+}
+
+int invertmatws(int n, double** mata, double** inverta, void *work, size_t bytes)
+{
+	//The matrix is copied into one contiguous descriptor carved from work,
+	//inverted in place there and copied back to inverta.  No heap allocation is done.
+	//With OpenMP the recursion runs as tasks of a team of inplacethreads(n, invthreads()) threads, each with its own arena.
 	int invertstatus;
-	int i,j, order;
+	int order, threads;
+	struct invmat mat;
+	struct invworkspace ws, *arenas;
 	
 	if(n<=0) return 0;
 	
-	for(i=0;i<n;i++)
-		for(j=0;j<n;j++)
-			inverta[i][j]=mata[i][j];
 	order = n;
+	threads = inplacethreads(order, invthreads());
+	invwsinit(&ws, work, bytes);
+	if(invmatwsalloc(&ws, &mat, order, order)==0) return 0;
+	arenas = invwsthreads(&ws, threads, invertinplaceworkspace(order));
+	if(arenas==NULL) return 0;
+	invmatfromrows(&mat, mata);
 	
 	//order=2;
-	invertstatus = invertinplace(order, inverta, 0);
+	#pragma omp parallel num_threads(threads) if(threads>1 && order>=INPLACETASKCUTOFF)
+	#pragma omp single
+	invertstatus = invertinplace(order, &mat, 0, arenas);
 	if(invertstatus==0)
 	{
 		printf("\nUnable to invert the matrix of order = %d\n",order);
 	}
+	invmattorows(&mat, inverta);
+	return invertstatus;
+}
+
+int invertmatfile(const char *path)
+{
+	//The matrix of a file of `invertor_file.c' is inverted in place in its mapped pages, which are written back:
+	//no copy of the matrix is made, only the scratch of invertinplace is allocated.
+	int invertstatus;
+	int order, threads;
+	size_t bytes;
+	void *work;
+	struct invfilemapping map;
+	struct invworkspace ws, *arenas;
+
+	if(invfilemap(path, 1, &map)==0) return 0;
+	order=map.mat.m;
+	if(map.mat.n!=order)
+	{
+		printf("\nThe matrix of %s is (%d * %d), not square\n",path,map.mat.m,map.mat.n);
+		invfileunmap(&map);
+		return 0;
+	}
+
+	threads=inplacethreads(order, invthreads());
+	bytes=INVMATALIGN+invwsthreadsbytes(threads, invertinplaceworkspace(order));
+	work=malloc(bytes);
+	if(work==NULL)
+	{
+		printf("\nUnable to allocate workspace of %zu bytes for the matrix of order = %d\n",bytes,order);
+		invfileunmap(&map);
+		return 0;
+	}
+	invwsinit(&ws, work, bytes);
+	arenas=invwsthreads(&ws, threads, invertinplaceworkspace(order));
+	invertstatus=0;
+	if(arenas!=NULL)
+	{
+		#pragma omp parallel num_threads(threads) if(threads>1 && order>=INPLACETASKCUTOFF)
+		#pragma omp single
+		invertstatus = invertinplace(order, &map.mat, 0, arenas);
+		if(invertstatus==0)
+		{
+			printf("\nUnable to invert the matrix of order = %d\n",order);
+		}
+	}
+	free(work);
+	if(invfileunmap(&map)==0) invertstatus=0;
+	return invertstatus;
+}
+
+int invertmatpivot(int n, double** mata, double** inverta, int *perm)
+{
+	//As invertmat, with block pivoting (inplaceblockspivot): the matrix needs no invertible block A.
+	//perm (n integers, may be NULL) receives the row permutation that was needed, see inplaceblockspivot.
+	int invertstatus;
+	size_t bytes;
+	void *work;
+	
+	if(n<=0) return 0;
+	
+	bytes=invertmatpivotworkspace(n);
+	work=malloc(bytes);
+	if(work==NULL)
+	{
+		printf("\nUnable to allocate workspace of %zu bytes for the matrix of order = %d\n",bytes,n);
+		return 0;
+	}
+	invertstatus=invertmatpivotws(n, mata, inverta, perm, work, bytes);
+	free(work);
 	return invertstatus;
 }
 
-int invertinplace(int order, double** mat, int pos)
+size_t invertmatpivotworkspace(int n)
+{
+	if(n<=0) return 0;
+	return INVMATALIGN+invmatbytes(n, n)+invwsbytes((n*sizeof(int)+sizeof(double)-1)/sizeof(double))+inplacepivotworkspace(n);
+}
+
+int invertmatpivotws(int n, double** mata, double** inverta, int *perm, void *work, size_t bytes)
+{
+	//As invertmatws with block pivoting.  The steps run in order on the calling thread.
+	int invertstatus;
+	int i;
+	struct invmat mat;
+	struct invworkspace ws;
+	
+	if(n<=0) return 0;
+	
+	invwsinit(&ws, work, bytes);
+	if(invmatwsalloc(&ws, &mat, n, n)==0) return 0;
+	if(perm==NULL) perm=(int *) invwsalloc(&ws, n*sizeof(int));
+	if(perm==NULL) return 0;
+	invmatfromrows(&mat, mata);
+	
+	if(n<=invleaforder())
+	{
+		//The leaf pivots by itself.
+		for(i=0;i<n;i++) perm[i]=i;
+		invertstatus=invertinplace(n, &mat, 0, &ws);
+	}
+	else invertstatus=inplaceblockspivot(n, &mat, 0, perm, &ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",n);
+	}
+	invmattorows(&mat, inverta);
+	return invertstatus;
+}
+
+size_t invertinplaceworkspace(int order)
+{
+	//Bytes of scratch used by invertinplace for this order.  The kernels of a step give their buffers back
+	//at the end of the step, so this is the largest buffer of any step at any level of the recursion.
+	size_t size, step;
+	int ordera, orderd;
+	
+	if(order<=3) return 0;
+	if(order<=invleaforder()) return inplaceleafworkspace(order);
+	ordera=order/2;
+	orderd=order-ordera;
+	
+	size=invertinplaceworkspace(ordera);
+	step=invertinplaceworkspace(orderd);		if(step>size) size=step;
+	step=invwsbytes(simdleftworksize(ordera));	if(step>size) size=step;
+	step=invwsbytes(simdleftworksize(orderd));	if(step>size) size=step;
+	step=invwsbytes(simdrightworksize(ordera));	if(step>size) size=step;
+	step=invwsbytes(simdrightworksize(orderd));	if(step>size) size=step;
+	step=invwsbytes(invgemmworksize(orderd, orderd, ordera));	if(step>size) size=step;
+	step=invwsbytes(invgemmworksize(ordera, ordera, orderd));	if(step>size) size=step;
+	return size;
+}
+
+int invertinplace(int order, struct invmat *mat, int pos, struct invworkspace *ws)
 {
 	int invertstatus;
 	double modmat, a11, a12, a13, a21, a22, a23, a31, a32, a33;
@@ -61,41 +296,41 @@ int invertinplace(int order, double** mat, int pos)
 	switch(order)
 	{
 		case 1:
-			if (mat[pos][pos]==0) 
+			if (MATEL(mat,pos,pos)==0) 
 			{
 				printf("\n Unable to invert matrix of order 1\n");
 				return 0;
 			}
-			mat[pos][pos]/=(mat[pos][pos]*mat[pos][pos]);
+			MATEL(mat,pos,pos)/=(MATEL(mat,pos,pos)*MATEL(mat,pos,pos));
 			invertstatus=1;
 			break;
 		case 2:
 		
-			modmat=(-(mat[pos+0][pos+1]*mat[pos+1][pos+0]) + mat[pos+0][pos+0]*mat[pos+1][pos+1]);
+			modmat=(-(MATEL(mat,pos+0,pos+1)*MATEL(mat,pos+1,pos+0)) + MATEL(mat,pos+0,pos+0)*MATEL(mat,pos+1,pos+1));
 			if(modmat==0) 
 			{
 				printf("\n Unable to invert matrix of order 2\n");
 				return 0;
 			}
 	
-			mat[pos+1][pos+1]*=mat[pos+0][pos+0]/modmat;
+			MATEL(mat,pos+1,pos+1)*=MATEL(mat,pos+0,pos+0)/modmat;
 			
-			mat[pos+0][pos+0]=(mat[pos+1][pos+1]/mat[pos+0][pos+0]);
-			mat[pos+0][pos+1]/=(-1*modmat);
-			mat[pos+1][pos+0]/=(-1*modmat);
-			mat[pos+1][pos+1]/=(mat[pos+0][pos+0]*modmat);
+			MATEL(mat,pos+0,pos+0)=(MATEL(mat,pos+1,pos+1)/MATEL(mat,pos+0,pos+0));
+			MATEL(mat,pos+0,pos+1)/=(-1*modmat);
+			MATEL(mat,pos+1,pos+0)/=(-1*modmat);
+			MATEL(mat,pos+1,pos+1)/=(MATEL(mat,pos+0,pos+0)*modmat);
 			invertstatus=1;
 			break;
 		case 3:
-			a11=mat[pos+0][pos+0];
-			a12=mat[pos+0][pos+1];
-			a13=mat[pos+0][pos+2];
-			a21=mat[pos+1][pos+0];
-			a22=mat[pos+1][pos+1];
-			a23=mat[pos+1][pos+2];
-			a31=mat[pos+2][pos+0];
-			a32=mat[pos+2][pos+1];
-			a33=mat[pos+2][pos+2];
+			a11=MATEL(mat,pos+0,pos+0);
+			a12=MATEL(mat,pos+0,pos+1);
+			a13=MATEL(mat,pos+0,pos+2);
+			a21=MATEL(mat,pos+1,pos+0);
+			a22=MATEL(mat,pos+1,pos+1);
+			a23=MATEL(mat,pos+1,pos+2);
+			a31=MATEL(mat,pos+2,pos+0);
+			a32=MATEL(mat,pos+2,pos+1);
+			a33=MATEL(mat,pos+2,pos+2);
 			
 			modmat=(-(a13*a22*a31) + a12*a23*a31 + a13*a21*a32 - a11*a23*a32 - a12*a21*a33 + a11*a22*a33);
 			if(modmat==0) 
@@ -104,29 +339,78 @@ int invertinplace(int order, double** mat, int pos)
 				return 0;
 			}
 	
-			mat[pos+0][pos+0]=(-(a23*a32) + a22*a33)/modmat;
-			mat[pos+0][pos+1]=(a13*a32 - a12*a33)/modmat;			
-			mat[pos+0][pos+2]=(-(a13*a22) + a12*a23)/modmat;
-			mat[pos+1][pos+0]=(a23*a31 - a21*a33)/modmat;
-			mat[pos+1][pos+1]=(-(a13*a31) + a11*a33)/modmat;
-			mat[pos+1][pos+2]=(a13*a21 - a11*a23)/modmat;
-			mat[pos+2][pos+0]=(-(a22*a31) + a21*a32)/modmat;
-			mat[pos+2][pos+1]=(a12*a31 - a11*a32)/modmat;
-			mat[pos+2][pos+2]=(-(a12*a21) + a11*a22)/modmat; 
-
+			MATEL(mat,pos+0,pos+0)=(-(a23*a32) + a22*a33)/modmat;
+			MATEL(mat,pos+0,pos+1)=(a13*a32 - a12*a33)/modmat;			
+			MATEL(mat,pos+0,pos+2)=(-(a13*a22) + a12*a23)/modmat;
+			MATEL(mat,pos+1,pos+0)=(a23*a31 - a21*a33)/modmat;
+			MATEL(mat,pos+1,pos+1)=(-(a13*a31) + a11*a33)/modmat;
+			MATEL(mat,pos+1,pos+2)=(a13*a21 - a11*a23)/modmat;
+			MATEL(mat,pos+2,pos+0)=(-(a22*a31) + a21*a32)/modmat;
+			MATEL(mat,pos+2,pos+1)=(a12*a31 - a11*a32)/modmat;
+			MATEL(mat,pos+2,pos+2)=(-(a12*a21) + a11*a22)/modmat; 
+			invertstatus=1;
 			break;
 		default:
-			//printf("\ncalling block function");
-			invertstatus=inplaceblocksbya(order, mat, pos);
+			//Below the cutoff the Gauss-Jordan leaf is used instead of the recursion.
+			if(order<=invleaforder()) invertstatus=inplaceleaf(order, mat, pos, ws);
+			else invertstatus=inplaceblocksbya(order, mat, pos, ws);
 			break;
 	}
 	return invertstatus;
 }
-int inplaceblocksbya(int order, double** mat, int pos)
+
+int inplaceleaf(int order, struct invmat *mat, int pos, struct invworkspace *ws)
+{
+	//The block of order (order * order) at (pos,pos) is inverted in place by the Gauss-Jordan leaf of `invertor_leaf.c',
+	//with its pivots and panel buffers taken from the workspace of the calling thread.
+	int status;
+	size_t mark;
+	int *pivot;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	pivot=(ws==NULL)?NULL:(int *) invwsalloc(ws, order*sizeof(int));
+	PERFBEGIN(INVPERFLEAF);
+	status=invleafgj(order, MATROW(mat,pos)+pos, mat->ld, pivot, invwsdoubles(ws, invleafworksize(order)));
+	PERFEND(INVPERFLEAF);
+	invwsrelease(ws, mark);
+	if(status==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",order);
+	}
+	return status;
+}
+
+size_t inplaceleafworkspace(int order)
+{
+	return invwsbytes((order*sizeof(int)+sizeof(double)-1)/sizeof(double))+invwsbytes(invleafworksize(order));
+}
+int inplaceblocksbya(int order, struct invmat *mat, int pos, struct invworkspace *ws)
+{
+	int invertstatus;
+	int ordera;
+	
+#ifdef _OPENMP
+	if(order>=INPLACETASKCUTOFF && omp_get_num_threads()>1) return inplaceblocksbyatasks(order, mat, pos, ws);
+#endif
+	
+	//step-2: Calculating A^-1
+	ordera=order/2;
+	invertstatus=invertinplace(ordera, mat, pos, ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",ordera);
+		return 0;
+	}
+	return inplaceschurbya(order, mat, pos, invertinplace, ws);
+}
+
+int inplaceschurbya(int order, struct invmat *mat, int pos, inplaceinvert invert, struct invworkspace *ws)
 {
+	//The steps of inplaceblocksbya after A^-1 is in place of A.  S is inverted by invert
+	//(invertinplace, or invertinplacepivot for the block pivoting).
 	int invertstatus;
 
-	int i,j;
 	int ordera, orderd, mb, nb, mc, nc;
 	int bposm, bposn, cposm, cposn;
 	
@@ -145,50 +429,49 @@ int inplaceblocksbya(int order, double** mat, int pos)
 	cposm=pos+ordera;
 	cposn=pos;
 	
-	//step-2: Calculating A^-1
-	invertstatus=invertinplace(ordera, mat, pos);
-	if(invertstatus==0)
-	{
-		printf("\nUnable to invert the matrix of order = %d\n",ordera);
-	}
-	
 	//step-3: Calculating -1*A^-1*B
-//int inplaceleftmatmul(double** mat, int ordera, int aposmn, int nb, int bposm, int bposn)
-	invertstatus=inplaceleftmatmul(mat, ordera, pos, nb, bposm, bposn);
+//int inplaceleftmatmul(struct invmat *mat, int ordera, int aposmn, int nb, int bposm, int bposn, struct invworkspace *ws)
+	invertstatus=inplaceleftmatmul(mat, ordera, pos, nb, bposm, bposn, ws);
 	
 	//step-4: Calculating Schur complement S = D - C A^-1B
-//int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
-	invertstatus=schurcomplement(mat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb);
+//int schurcomplement(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws)
+	invertstatus=schurcomplement(mat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb, ws);
 	
 	//step-5: Calculating C * A^-1
-//int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm, int aposn)
-	invertstatus=inplacerightmatmul(mat, ordera, pos, mc, cposm, cposn);
+//int inplacerightmatmul(struct invmat *mat, int orderb, int bposmn, int ma, int aposm, int aposn, struct invworkspace *ws)
+	invertstatus=inplacerightmatmul(mat, ordera, pos, mc, cposm, cposn, ws);
 	
 	//step-6: Calculating S^-1 
-	invertstatus=invertinplace(orderd, mat, pos+ordera);
+	invertstatus=invert(orderd, mat, pos+ordera, ws);
 	if(invertstatus==0)
 	{
 		printf("\nUnable to invert the matrix of order = %d\n",orderd);
+		return 0;
 	}
 	
 	//step-7: Calculatin S^-1 * CA^-1
-	invertstatus=inplaceleftmatmul(mat, orderd, pos+ordera, nc, cposm, cposn);
+	invertstatus=inplaceleftmatmul(mat, orderd, pos+ordera, nc, cposm, cposn, ws);
 	
 	//step-8: Calculating Schur completed at A: A^-1 + A^-1B * S^-1CA^-1
-	invertstatus=schurcomplement(mat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc);
+	invertstatus=schurcomplement(mat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc, ws);
 	
 	//step-9: Calculating -A^-1B * S^-1
-	invertstatus=inplacerightmatmul(mat, orderd, pos+ordera, mb, bposm, bposn);
+	invertstatus=inplacerightmatmul(mat, orderd, pos+ordera, mb, bposm, bposn, ws);
 
 	return invertstatus;
 }
 
-int inplaceblocksbyd(int order, double** mat, int pos)
+int inplaceblocksbyatasks(int order, struct invmat *mat, int pos, struct invworkspace *ws)
 {
-	//This function is based on invertability of d
-	int invertstatus;
+	//The steps of inplaceblocksbya as OpenMP tasks on panels and tiles of INPLACETASKTILE.
+	//The first element of a panel stands for the panel in the depend clauses, so that a tile of step 4 (8)
+	//starts as soon as the panel of step 3 (7) it reads is done.  Step 5 needs the whole row of step 4
+	//and runs alongside the inversion of S (step 6), which spawns its own tasks.
+	//Each task takes its scratch from the arena of the thread running it.
+	//A failed inversion of A or S ends the level at once, as in inplaceblocksbya: no task of the later steps is spawned.
+	int invertstatus, status6;
 
-	int i,j;
+	int i, j, h, w;
 	int ordera, orderd, mb, nb, mc, nc;
 	int bposm, bposn, cposm, cposn;
 	
@@ -207,72 +490,381 @@ int inplaceblocksbyd(int order, double** mat, int pos)
 	cposm=pos+ordera;
 	cposn=pos;
 	
+	//step-2: Calculating A^-1
+	invertstatus=invertinplace(ordera, mat, pos, ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",ordera);
+		return 0;
+	}
+	
+	//step-3: Calculating -1*A^-1*B by column panels of B
+	//step-4: Calculating Schur complement S = D - C A^-1B by tiles of D
+	for(j=0;j<nb;j+=INPLACETASKTILE)
+	{
+		w=(nb-j<INPLACETASKTILE)?nb-j:INPLACETASKTILE;
+		#pragma omp task depend(out: MATEL(mat,bposm,bposn+j))
+		inplaceleftmatmul(mat, ordera, pos, w, bposm, bposn+j, ws);
+	}
+	for(i=0;i<orderd;i+=INPLACETASKTILE)
+		for(j=0;j<orderd;j+=INPLACETASKTILE)
+		{
+			h=(orderd-i<INPLACETASKTILE)?orderd-i:INPLACETASKTILE;
+			w=(orderd-j<INPLACETASKTILE)?orderd-j:INPLACETASKTILE;
+			#pragma omp task depend(in: MATEL(mat,bposm,bposn+j))
+			schurcomplementtile(mat, h, w, pos+ordera+i, pos+ordera+j, cposm+i, cposn, nc, bposm, bposn+j, ws);
+		}
+	#pragma omp taskwait
+	
+	//step-5: Calculating C * A^-1 by row panels of C, while
+	//step-6: Calculating S^-1 
+	#pragma omp task shared(status6)
+	status6=invertinplace(orderd, mat, pos+ordera, ws);
+	for(i=0;i<mc;i+=INPLACETASKTILE)
+	{
+		h=(mc-i<INPLACETASKTILE)?mc-i:INPLACETASKTILE;
+		#pragma omp task
+		inplacerightmatmul(mat, ordera, pos, h, cposm+i, cposn, ws);
+	}
+	#pragma omp taskwait
+	if(status6==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",orderd);
+		return 0;
+	}
+	
+	//step-7: Calculatin S^-1 * CA^-1 by column panels of C
+	//step-8: Calculating Schur completed at A: A^-1 + A^-1B * S^-1CA^-1 by tiles of A
+	for(j=0;j<nc;j+=INPLACETASKTILE)
+	{
+		w=(nc-j<INPLACETASKTILE)?nc-j:INPLACETASKTILE;
+		#pragma omp task depend(out: MATEL(mat,cposm,cposn+j))
+		inplaceleftmatmul(mat, orderd, pos+ordera, w, cposm, cposn+j, ws);
+	}
+	for(i=0;i<ordera;i+=INPLACETASKTILE)
+		for(j=0;j<ordera;j+=INPLACETASKTILE)
+		{
+			h=(ordera-i<INPLACETASKTILE)?ordera-i:INPLACETASKTILE;
+			w=(ordera-j<INPLACETASKTILE)?ordera-j:INPLACETASKTILE;
+			#pragma omp task depend(in: MATEL(mat,cposm,cposn+j))
+			schurcomplementtile(mat, h, w, pos+i, pos+j, bposm+i, bposn, nb, cposm, cposn+j, ws);
+		}
+	#pragma omp taskwait
+	
+	//step-9: Calculating -A^-1B * S^-1 by row panels of B
+	for(i=0;i<mb;i+=INPLACETASKTILE)
+	{
+		h=(mb-i<INPLACETASKTILE)?mb-i:INPLACETASKTILE;
+		#pragma omp task
+		inplacerightmatmul(mat, orderd, pos+ordera, h, bposm+i, bposn, ws);
+	}
+	#pragma omp taskwait
+
+	return invertstatus;
+}
+
+int inplaceblocksbyd(int order, struct invmat *mat, int pos, struct invworkspace *ws)
+{
+	//This function is based on invertability of d
+	int invertstatus;
+	int ordera, orderd;
+	
 	//step-2: Calculating D^-1
-	invertstatus=invertinplace(orderd, mat, pos+ordera);
+	ordera=order/2;
+	orderd=order-ordera;
+	invertstatus=invertinplace(orderd, mat, pos+ordera, ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",orderd);
+		return 0;
+	}
+	return inplaceschurbyd(order, mat, pos, invertinplace, ws);
+}
+
+int inplaceschurbyd(int order, struct invmat *mat, int pos, inplaceinvert invert, struct invworkspace *ws)
+{
+	//The steps of inplaceblocksbyd after D^-1 is in place of D.  S is inverted by invert.
+	int invertstatus;
+
+	int ordera, orderd, mb, nb, mc, nc;
+	int bposm, bposn, cposm, cposn;
+	
+	//step-1: Preparing the blocks A, B, C, D
+	ordera=order/2;
+	orderd=order-ordera;
+	
+	mb=ordera;
+	nb=orderd;
+	
+	mc=orderd;
+	nc=ordera;
+	
+	bposm=pos;
+	bposn=pos+ordera;
+	cposm=pos+ordera;
+	cposn=pos;
 	
 	//step-3: Calculating -1*D^-1*C
-//int inplaceleftmatmul(double** mat, int ordera, int aposmn, int nb, int bposm, int bposn)
-	invertstatus=inplaceleftmatmul(mat, orderd, pos+ordera, nc, cposm, cposn);
+//int inplaceleftmatmul(struct invmat *mat, int ordera, int aposmn, int nb, int bposm, int bposn, struct invworkspace *ws)
+	invertstatus=inplaceleftmatmul(mat, orderd, pos+ordera, nc, cposm, cposn, ws);
 	
 	//step-4: Calculating Schur complement S = D - B * D^-1C
-//int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
-	invertstatus=schurcomplement(mat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc);
+//int schurcomplement(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws)
+	invertstatus=schurcomplement(mat, ordera, pos, bposm, bposn, nb, cposm, cposn, mc, ws);
 	
 	//step-5: Calculating B * D^-1
-//int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm, int aposn)
-	invertstatus=inplacerightmatmul(mat, orderd, pos+ordera, mb, bposm, bposn);
+//int inplacerightmatmul(struct invmat *mat, int orderb, int bposmn, int ma, int aposm, int aposn, struct invworkspace *ws)
+	invertstatus=inplacerightmatmul(mat, orderd, pos+ordera, mb, bposm, bposn, ws);
 	
 	//step-6: Calculating S^-1 
-	invertstatus=invertinplace(ordera, mat, pos);
+	invertstatus=invert(ordera, mat, pos, ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",ordera);
+		return 0;
+	}
 	
 	//step-7: Calculatin S^-1 * BD^-1
-	invertstatus=inplaceleftmatmul(mat, ordera, pos, nb, bposm, bposn);
+	invertstatus=inplaceleftmatmul(mat, ordera, pos, nb, bposm, bposn, ws);
 	
 	//step-8: Calculating Schur completed at D: D^-1 + D^-1C * S^-1BD^-1
-	invertstatus=schurcomplement(mat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb);
+	invertstatus=schurcomplement(mat, orderd, pos+ordera, cposm, cposn, nc, bposm, bposn, mb, ws);
 	
 	//step-9: Calculating -D^-1C * S^-1
-	invertstatus=inplacerightmatmul(mat, ordera, pos, mc, cposm, cposn);
+	invertstatus=inplacerightmatmul(mat, ordera, pos, mc, cposm, cposn, ws);
 
 	return invertstatus;
 }
 
+int invertinplacepivot(int order, struct invmat *mat, int pos, struct invworkspace *ws)
+{
+	//invertinplace with block pivoting above the leaf.  The leaf and the formulas of order 1, 2, 3 are those of invertinplace.
+	if(order<=invleaforder()) return invertinplace(order, mat, pos, ws);
+	return inplaceblockspivot(order, mat, pos, NULL, ws);
+}
 
-int inplaceleftmatmul(double** mat, int ordera, int aposmn, int nb, int bposm, int bposn)
+int inplaceblockspivot(int order, struct invmat *mat, int pos, int *perm, struct invworkspace *ws)
 {
-	//This computes -1*mat A * mat B and stores it in mat B.
-	//mat A is square matrix of order (ordera * ordera).
-	//mat B is not square matrix.  It is of order (ordera * nb).
-	//The result matrix will be stored at mat B's location with order (ordera * nb).
-	//Since the required multiplications for block inversion are with sqare matrix, we use minimum variables.
+	//Block pivoting.  Of the diagonal blocks A and D, the one with the larger inplacediagscore is inverted first
+	//and the level goes on with the steps of inplaceblocksbya or inplaceblocksbyd; the Schur complement is inverted
+	//the same way.  The block is copied aside before its inversion, and its inverse is kept only if the block is
+	//well conditioned: rcond = 1/(|block|_1 |inverse|_1) at least INPLACEPIVOTRCOND.  Otherwise (or if it is singular)
+	//the copy is put back and the other block is tried.  When both fail, the rows of the matrix are permuted by
+	//inplacerowpivot and A and D are tried again; the inverse of the permuted matrix is permuted back on its columns
+	//at the end.  When they fail again, the whole level is inverted by Gauss-Jordan with partial pivoting (inplaceleaf).
+	//perm (order integers, may be NULL) receives the row permutation: row i of the permuted matrix was row perm[i].
+	//It is the identity when no row permutation was needed.
+	//A failure of the Schur complement means that the matrix itself is singular, and is not retried.
+	int invertstatus;
+	int i, k, m, p, tries, permuted, tried, first;
+	int ordera, orderd;
+	size_t mark, blockmark;
+	double *row, *save, score[2], rcond;
 	
-	int i,j,k;
+	ordera=order/2;
+	orderd=order-ordera;
+	
+	mark=invwsmark(ws);
+	if(perm==NULL) perm=(int *) invwsalloc(ws, order*sizeof(int));
+	row=invwsdoubles(ws, order);
+	if(perm==NULL || (ws!=NULL && row==NULL))
+	{
+		printf("\nUnable to allocate the pivoting workspace for the matrix of order = %d\n",order);
+		invwsrelease(ws, mark);
+		return 0;
+	}
+	if(ws==NULL) row=(double *) malloc(order*sizeof(double));
+	for(i=0;i<order;i++) perm[i]=i;
+	
+	invertstatus=0;
+	permuted=0;
+	tried=0;
+	for(tries=0;tries<2 && invertstatus==0 && tried==0;tries++)
+	{
+		if(tries==1)
+		{
+			if(inplacerowpivot(mat, order, pos, perm, row)==0) break;
+			permuted=1;
+		}
+		score[0]=inplacediagscore(mat, ordera, pos);
+		score[1]=inplacediagscore(mat, orderd, pos+ordera);
+		first=(score[1]>score[0])?1:0;
+		for(k=0;k<2 && invertstatus==0;k++)
+		{
+			m=((first^k)==0)?ordera:orderd;
+			p=((first^k)==0)?pos:pos+ordera;
+			if(score[first^k]==0) continue;	//a zero on the diagonal: not worth inverting as a pivot block
+			
+			//step-2 of the chosen block, undone from the copy when it fails.
+			blockmark=invwsmark(ws);
+			save=invwsdoubles(ws, (size_t)m*m);
+			if(ws==NULL) save=(double *) malloc((size_t)m*m*sizeof(double));
+			if(save==NULL)
+			{
+				printf("\nUnable to allocate the pivoting workspace for the matrix of order = %d\n",order);
+				break;
+			}
+			for(i=0;i<m;i++) memcpy(save+(size_t)i*m, MATROW(mat,p+i)+p, m*sizeof(double));
+			invertstatus=invertinplacepivot(m, mat, p, ws);
+			if(invertstatus==1)
+			{
+				rcond=1/(updatenorm(m, m, m, save)*updatenorm(m, m, mat->ld, MATROW(mat,p)+p));
+				if(!(rcond>=INPLACEPIVOTRCOND)) invertstatus=0;
+			}
+			if(invertstatus==0)
+				for(i=0;i<m;i++) memcpy(MATROW(mat,p+i)+p, save+(size_t)i*m, m*sizeof(double));
+			if(ws==NULL) free(save);
+			invwsrelease(ws, blockmark);
+		}
+		if(invertstatus==1)
+		{
+			tried=1;
+			if(p==pos) invertstatus=inplaceschurbya(order, mat, pos, invertinplacepivot, ws);
+			else invertstatus=inplaceschurbyd(order, mat, pos, invertinplacepivot, ws);
+		}
+	}
+	if(invertstatus==0 && tried==0) invertstatus=inplaceleaf(order, mat, pos, ws);
+	if(invertstatus==1 && permuted==1) inplacecolumnunpivot(mat, order, pos, perm, row);
+	if(ws==NULL) free(row);
+	invwsrelease(ws, mark);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d with block pivoting\n",order);
+	}
+	return invertstatus;
+}
 
-	double *btemp;
-	btemp =(double *) malloc(ordera*sizeof(double));
+double inplacediagscore(struct invmat *mat, int order, int pos)
+{
+	//Cheap guess, before any inversion, of which diagonal block to try first (the rcond of inplaceblockspivot decides):
+	//the smallest ratio over its rows of |diagonal element| / (sum of |elements| of the row), in [0, 1].
+	//It is 1 for a diagonal block and near 0 when a row hardly depends on its own unknown.
+	int i, j;
+	double *ai, sum, ratio, score;
+	
+	score=1;
+	for(i=0;i<order;i++)
+	{
+		ai=MATROW(mat,pos+i)+pos;
+		for(sum=0,j=0;j<order;j++) sum+=fabs(ai[j]);
+		ratio=(sum==0)?0:fabs(ai[i])/sum;
+		if(ratio<score) score=ratio;
+	}
+	return score;
+}
 
-	for(j=0;j<nb;j++)
+int inplacerowpivot(struct invmat *mat, int order, int pos, int *perm, double *row)
+{
+	//Permutes the rows of the block of order (order * order) at (pos,pos) to put large elements on its diagonal:
+	//column j takes, of the rows not yet taken, the one where column j is largest relative to the row.
+	//perm[i] is set to the row moved to row i.  row holds order doubles of scratch.
+	//Returns 0, leaving the block as it was, when a column has no nonzero element left.
+	int i, j, k, best;
+	double big, v;
+	
+	//row[i] := 1/(largest |element| of row i), -1 once row i is taken.
+	for(i=0;i<order;i++)
+	{
+		for(big=0,j=0;j<order;j++) if(fabs(MATEL(mat,pos+i,pos+j))>big) big=fabs(MATEL(mat,pos+i,pos+j));
+		if(big==0) return 0;
+		row[i]=1/big;
+	}
+	for(j=0;j<order;j++)
+	{
+		for(best=-1,big=0,i=0;i<order;i++)
 		{
-			//printf("-------");
-			for(k=0; k<ordera; k++) 
+			if(row[i]<0) continue;
+			v=fabs(MATEL(mat,pos+i,pos+j))*row[i];
+			if(v>big)
 			{
-				btemp[k]=mat[bposm+k][bposn+j];  //printf("\n%lf",btemp[k]);
-				//mat[bposm+i][bposn+k]=0;
-			}
-		
-		for(i=0;i<ordera;i++) 
-			{ 
-				mat[bposm+i][bposn+j]=0;
-				for(k=0; k<ordera; k++)
-				mat[bposm+i][bposn+j]+=mat[aposmn+i][aposmn+k]*btemp[k];
-				mat[bposm+i][bposn+j]*=-1;
+				big=v;
+				best=i;
 			}
-		}	
-	free(btemp);
+		}
+		if(best<0)
+		{
+			for(i=0;i<order;i++) perm[i]=i;
+			return 0;
+		}
+		perm[j]=best;
+		row[best]=-1;
+	}
+	
+	//The rows are moved along the cycles of perm; perm[i] is marked by -(perm[i]+1) once row i is in place.
+	for(i=0;i<order;i++)
+	{
+		if(perm[i]<0 || perm[i]==i) continue;
+		memcpy(row, MATROW(mat,pos+i)+pos, order*sizeof(double));
+		for(j=i;perm[j]!=i;j=k)
+		{
+			k=perm[j];
+			memcpy(MATROW(mat,pos+j)+pos, MATROW(mat,pos+k)+pos, order*sizeof(double));
+			perm[j]=-(k+1);
+		}
+		memcpy(MATROW(mat,pos+j)+pos, row, order*sizeof(double));
+		perm[j]=-(i+1);
+	}
+	for(i=0;i<order;i++) if(perm[i]<0) perm[i]=-perm[i]-1;
 	return 1;
 }
 
-int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm, int aposn)
+void inplacecolumnunpivot(struct invmat *mat, int order, int pos, int *perm, double *row)
+{
+	//The block holds (P M)^-1 = M^-1 P^-1, where row i of P M is row perm[i] of M.
+	//M^-1 is recovered by moving column i of each row to column perm[i].
+	int i, j;
+	double *ai;
+	
+	for(i=0;i<order;i++)
+	{
+		ai=MATROW(mat,pos+i)+pos;
+		for(j=0;j<order;j++) row[perm[j]]=ai[j];
+		memcpy(ai, row, order*sizeof(double));
+	}
+}
+
+size_t inplacepivotworkspace(int order)
+{
+	//Bytes of scratch used by inplaceblockspivot: the permutation and a row, the copy of the block being inverted
+	//with the scratch of its inversion, or the scratch of the other steps or of the leaf over the whole level.
+	size_t size, step;
+	int ordera, orderd;
+	
+	if(order<=invleaforder()) return invertinplaceworkspace(order);
+	ordera=order/2;
+	orderd=order-ordera;
+	
+	size=invertinplaceworkspace(order);
+	step=inplaceleafworkspace(order);	if(step>size) size=step;
+	step=inplacepivotworkspace(ordera);	if(step>size) size=step;
+	step=inplacepivotworkspace(orderd);	if(step>size) size=step;
+	step+=invwsbytes((size_t)orderd*orderd);	if(step>size) size=step;
+	return invwsbytes((order*sizeof(int)+sizeof(double)-1)/sizeof(double))+invwsbytes(order)+size;
+}
+
+int inplaceleftmatmul(struct invmat *mat, int ordera, int aposmn, int nb, int bposm, int bposn, struct invworkspace *ws)
+{
+	//This computes -1*mat A * mat B and stores it in mat B.
+	//mat A is square matrix of order (ordera * ordera).
+	//mat B is not square matrix.  It is of order (ordera * nb).
+	//The result matrix will be stored at mat B's location with order (ordera * nb).
+	//Since the required multiplications for block inversion are with sqare matrix, we use minimum variables.
+	//Column panels of B are copied and multiplied by the vector kernel of `invertor_simd.c', which folds in the sign.
+	
+	//The panel is taken from the workspace (if any) of the calling thread and given back on return.
+	int status;
+	size_t mark;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	PERFBEGIN(INVPERFLEFT);
+	status=simdleftmatmul(ordera, nb, MATROW(mat,aposmn)+aposmn, mat->ld, MATROW(mat,bposm)+bposn, mat->ld, invwsdoubles(ws, simdleftworksize(ordera)));
+	PERFEND(INVPERFLEFT);
+	invwsrelease(ws, mark);
+	return status;
+}
+
+int inplacerightmatmul(struct invmat *mat, int orderb, int bposmn, int ma, int aposm, int aposn, struct invworkspace *ws)
 {
 	//Left Multiplication we track -ve sign.  For Right Multiplication we track +ve sign.
 	//This computes mat A * mat B and stores it in mat A.
@@ -280,34 +872,21 @@ int inplacerightmatmul(double** mat, int orderb, int bposmn, int ma, int aposm,
 	//mat B is square matrix of order (orderb * orderb).
 	//The result matrix will be stored at mat A's location with order (ma * orderb).
 	//Since the required multiplications for block inversion are with sqare matrix, we use minimum variables.
-	
-	int i,j,k;
-
-	double *atemp;
-	atemp =(double *) malloc(orderb*sizeof(double));
-
-	for(i=0;i<ma;i++)
-		{
-			//printf("-------");
-			for(k=0; k<orderb; k++) 
-			{
-				atemp[k]=mat[aposm+i][aposn+k];  //printf("\n%lf",atemp[k]);
-				//mat[bposm+i][bposn+k]=0;
-			}
-		
-		for(j=0;j<orderb;j++) 
-			{ 
-				mat[aposm+i][aposn+j]=0;
-				for(k=0; k<orderb; k++)
-				mat[aposm+i][aposn+j]+=atemp[k]*mat[bposmn+k][bposmn+j];
-				//mat[aposm+i][aposn+j]*=-1;
-			}
-		}	
-	free(atemp);
-	return 1;
+	//Rows of A are copied a few at a time and multiplied by the vector kernel of `invertor_simd.c'.
+	
+	int status;
+	size_t mark;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	PERFBEGIN(INVPERFRIGHT);
+	status=simdrightmatmul(ma, orderb, MATROW(mat,aposm)+aposn, mat->ld, MATROW(mat,bposmn)+bposmn, mat->ld, invwsdoubles(ws, simdrightworksize(orderb)));
+	PERFEND(INVPERFRIGHT);
+	invwsrelease(ws, mark);
+	return status;
 }
 
-int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym)
+int schurcomplement(struct invmat *mat, int order, int matpos, int xposm, int xposn, int xn, int yposm, int yposn, int ym, struct invworkspace *ws)
 {
 	//If block D is invertible, then Schur complement of the block D is
 	//	M / D := A − B D^{-1} C 
@@ -331,15 +910,23 @@ int schurcomplement(double** mat, int order, int matpos, int xposm, int xposn, i
 	//y matrix is at the location (yposm, yposn) with order (order * yn).
 	//Here we calculate, mat = mat + xmatrix*ymatrix and stores at the location of mat.
 	
-	int i,j,k;
-	
-	for(i=0;i<order;i++)
-		for(j=0;j<order;j++)
-			for(k=0;k<xn;k++)  //xn == ym
-			{
-				mat[matpos+i][matpos+j]+=mat[xposm+i][xposn+k]*mat[yposm+k][yposn+j];
-			}
-	return 1;
+	return schurcomplementtile(mat, order, order, matpos, matpos, xposm, xposn, xn, yposm, yposn, ws);  //xn == ym
+}
+
+int schurcomplementtile(struct invmat *mat, int m, int n, int mposm, int mposn, int xposm, int xposn, int xn, int yposm, int yposn, struct invworkspace *ws)
+{
+	//mat(m * n) at (mposm, mposn) += x(m * xn) at (xposm, xposn) * y(xn * n) at (yposm, yposn).
+	//The product is done by the blocked multiplication of `invertor_gemm.c'.  The three blocks do not overlap.
+	int status;
+	size_t mark;
+	
+	ws=invwsthread(ws);
+	mark=invwsmark(ws);
+	PERFBEGIN(INVPERFSCHUR);
+	status=invgemm(m, n, xn, 1.0, MATROW(mat,xposm)+xposn, mat->ld, MATROW(mat,yposm)+yposn, mat->ld, 1.0, MATROW(mat,mposm)+mposn, mat->ld, invwsdoubles(ws, invgemmworksize(m, n, xn)));
+	PERFEND(INVPERFSCHUR);
+	invwsrelease(ws, mark);
+	return status;
 }
 
 
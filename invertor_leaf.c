@@ -0,0 +1,209 @@
+// Dense leaf inversion for the diagonal blocks of the invertor engines.
+// invleafgj inverts in place a block addressed by a pointer and a leading dimension (row-major) by Gauss-Jordan
+// elimination with partial pivoting.  The columns are eliminated by panels of INVLEAFPANEL: within a panel the
+// steps update rows of the panel only (contiguous, vectorized inner loops), and the panel is then applied to
+// all the other columns at once by the blocked multiplication of `invertor_gemm.c'.
+// The rows swapped by the pivoting are undone on the columns at the end.
+// The recursive engines stop the recursion at invleaforder() and call invleafgj below it.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_LEAF_C
+#define INVERTOR_LEAF_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
+
+#include "invertor_config.c"
+#include "invertor_gemm.c"
+#include "invertor_fixed.c"
+
+//Default order at and below which the recursive engines use the leaf.  The key leaf of the configuration
+//(`invertor_config.c') and, over it, the environment variable INVERTOR_LEAF override it at run time
+//(INVERTOR_LEAF=3 recurses down to the cofactor formulas as before).
+#ifndef INVLEAFORDER
+#define INVLEAFORDER 32
+#endif
+//Columns eliminated together before the other columns are updated by one multiplication.
+#define INVLEAFPANEL 32
+
+int invleaforder(void);
+void leafconfig(void) __attribute__((constructor));
+size_t invleafworksize(int n);
+int invleafgj(int n, double *a, int lda, int *pivot, double *work);
+int invleafgjpanel(int n, int k0, int nb, double *a, int lda, int *pivot);
+
+static int invleafcutoff=0;
+
+int invleaforder(void)
+{
+	//Read once, at startup, from the configuration and INVERTOR_LEAF; values below 1 are ignored.
+	const char *env;
+	int order;
+
+	if(invleafcutoff==0)
+	{
+		order=invconfigint("leaf", INVLEAFORDER);
+		if(order<1) order=INVLEAFORDER;
+		env=getenv("INVERTOR_LEAF");
+		if(env!=NULL && atoi(env)>0) order=atoi(env);
+		invleafcutoff=order;
+	}
+	return invleafcutoff;
+}
+
+void leafconfig(void)
+{
+	//The order is read before main, so that the threads of the engines only read it.
+	invleaforder();
+}
+
+size_t invleafworksize(int n)
+{
+	//Doubles of work for invleafgj: the rows of a panel and the packing buffers of the multiplication.
+	if(n<=INVLEAFPANEL) return 0;
+	return (size_t)INVLEAFPANEL*n+invgemmworksize(n, n, INVLEAFPANEL);
+}
+
+int invleafgj(int n, double *a, int lda, int *pivot, double *work)
+{
+	//a (n * n) is replaced by its inverse.  pivot holds n integers and work invleafworksize(n) doubles;
+	//either is allocated here if NULL.  Returns 0, leaving a partly eliminated, when a pivot column is zero.
+
+	//Eliminating the columns K = [k, k+nb) turns the matrix M into E*M, where E differs from the identity only in the
+	//columns K: the panel itself ends up holding E(:,K), and every other column J becomes
+	//	M(K,J) := P^-1 * M(K,J)  for the rows K,  and  M(i,J) += E(i,K) * M(K,J)  for the other rows,
+	//with P^-1 = E(K,K) and the rows M(K,J) taken before the update.
+	int i,k,nb,status;
+	int *ownedpivot;
+	double t, *ai, *r, *gemmwork, *owned;
+
+	if(n<=0) return 1;
+	if(n>=INVFIXEDMIN && n<=INVFIXEDMAX) return invertfixed(n, a, lda, a, lda);
+	ownedpivot=NULL;
+	owned=NULL;
+	if(pivot==NULL) pivot=ownedpivot=(int *) malloc(n*sizeof(int));
+	if(work==NULL && invleafworksize(n)>0) work=owned=(double *) malloc(invleafworksize(n)*sizeof(double));
+	if(pivot==NULL || (work==NULL && invleafworksize(n)>0))
+	{
+		printf("\nUnable to allocate the leaf workspace for order %d\n", n);
+		free(ownedpivot);
+		free(owned);
+		return 0;
+	}
+
+	status=1;
+	if(n<=INVLEAFPANEL) status=invleafgjpanel(n, 0, n, a, lda, pivot);
+	else
+	{
+		r=work;
+		gemmwork=work+(size_t)INVLEAFPANEL*n;
+		for(k=0;k<n && status==1;k+=INVLEAFPANEL)
+		{
+			nb=(n-k<INVLEAFPANEL)?n-k:INVLEAFPANEL;
+			status=invleafgjpanel(n, k, nb, a, lda, pivot);
+			if(status==0) break;
+
+			//r (nb * (n-nb)) := M(K,J), the columns left of the panel followed by those right of it.
+			for(i=0;i<nb;i++)
+			{
+				ai=a+(size_t)(k+i)*lda;
+				memcpy(r+(size_t)i*(n-nb), ai, k*sizeof(double));
+				memcpy(r+(size_t)i*(n-nb)+k, ai+k+nb, (n-k-nb)*sizeof(double));
+			}
+			ai=a+(size_t)k*lda;
+			invgemm(nb, k, nb, 1.0, ai+k, lda, r, n-nb, 0.0, ai, lda, gemmwork);
+			invgemm(nb, n-k-nb, nb, 1.0, ai+k, lda, r+k, n-nb, 0.0, ai+k+nb, lda, gemmwork);
+			invgemm(k, k, nb, 1.0, a+k, lda, r, n-nb, 1.0, a, lda, gemmwork);
+			invgemm(k, n-k-nb, nb, 1.0, a+k, lda, r+k, n-nb, 1.0, a+k+nb, lda, gemmwork);
+			ai=a+(size_t)(k+nb)*lda;
+			invgemm(n-k-nb, k, nb, 1.0, ai+k, lda, r, n-nb, 1.0, ai, lda, gemmwork);
+			invgemm(n-k-nb, n-k-nb, nb, 1.0, ai+k, lda, r+k, n-nb, 1.0, ai+k+nb, lda, gemmwork);
+		}
+	}
+
+	//Swapping rows k and pivot[k] of the matrix swaps columns k and pivot[k] of its inverse.
+	for(k=n-1;k>=0 && status==1;k--)
+	{
+		if(pivot[k]==k) continue;
+		for(i=0;i<n;i++)
+		{
+			ai=a+(size_t)i*lda;
+			t=ai[k];
+			ai[k]=ai[pivot[k]];
+			ai[pivot[k]]=t;
+		}
+	}
+	free(ownedpivot);
+	free(owned);
+	return status;
+}
+
+int invleafgjpanel(int n, int k0, int nb, double *a, int lda, int *pivot)
+{
+	//Gauss-Jordan steps for the columns k0 ... k0+nb-1, updating only those columns of the n rows.
+	//The pivot rows are swapped over the whole row.
+	int i,j,k,p;
+	double big, d, f, t;
+	double *ak, *ai;
+
+	for(k=k0;k<k0+nb;k++)
+	{
+		for(p=k,big=fabs(a[(size_t)k*lda+k]),i=k+1;i<n;i++)
+			if(fabs(a[(size_t)i*lda+k])>big)
+			{
+				big=fabs(a[(size_t)i*lda+k]);
+				p=i;
+			}
+		if(big==0)
+		{
+			printf("\nUnable to invert the block of order %d: zero pivot in column %d\n", n, k);
+			return 0;
+		}
+		pivot[k]=p;
+		ak=a+(size_t)k*lda;
+		if(p!=k)
+		{
+			ai=a+(size_t)p*lda;
+			for(j=0;j<n;j++)
+			{
+				t=ak[j];
+				ak[j]=ai[j];
+				ai[j]=t;
+			}
+		}
+
+		//Row k becomes row k of the inverse so far; its column k holds 1/pivot.
+		d=1/ak[k];
+		ak[k]=1;
+		for(j=k0;j<k0+nb;j++) ak[j]*=d;
+
+		for(i=0;i<n;i++)
+		{
+			if(i==k) continue;
+			ai=a+(size_t)i*lda;
+			f=ai[k];
+			if(f==0) continue;
+			ai[k]=0;
+			for(j=k0;j<k0+nb;j++) ai[j]-=f*ak[j];
+		}
+	}
+	return 1;
+}
+
+#endif
@@ -0,0 +1,288 @@
+// Matrix descriptor shared by the invertor engines.
+// A matrix is kept in one aligned contiguous buffer, row after row, with a leading dimension (row stride)
+// that may be larger than the number of columns.  Sub-blocks are described by views into the same buffer.
+// The engines `invertor_by_a.c', `invertor_inplace_by_a.c' and `invertor_by_ad.c' work on this descriptor.
+// The "invertmat" functions of those files keep taking 2 dimensional arrays and copy through a descriptor.
+// Scratch matrices and buffers of the engines are carved from a workspace: one arena given by the caller,
+// handed out by a bump pointer and given back in stack order with a mark, so no heap allocation is done
+// while inverting.  Each engine has a query function returning the exact arena size for an order.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_MATRIX_C
+#define INVERTOR_MATRIX_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#ifdef _OPENMP
+#include<omp.h>
+#endif
+
+#include "invertor_config.c"
+
+//Alignment of the buffer and of every row (in bytes).
+#define INVMATALIGN 64
+
+struct invmat
+{
+	int m;		//number of rows
+	int n;		//number of columns
+	int ld;		//leading dimension: number of doubles from one row to the next
+	double *data;	//element (0,0) of the matrix or of the view
+	double *base;	//allocated buffer.  NULL for views, which do not own their elements.
+};
+
+struct invworkspace
+{
+	char *base;	//first aligned byte of the arena given by the caller
+	size_t size;	//usable bytes from base
+	size_t used;	//bytes handed out so far
+	int threads;	//1, or the number of per-thread arenas in the array starting here (see invwsthreads)
+};
+
+//Element (i,j) and the address of row i of a descriptor.
+#define MATEL(mat,i,j) ((mat)->data[(size_t)(i)*(mat)->ld+(j)])
+#define MATROW(mat,i) ((mat)->data+(size_t)(i)*(mat)->ld)
+
+int invmatld(int n);
+int invmatalloc(struct invmat *mat, int m, int n);
+void invmatfree(struct invmat *mat);
+int invmatview(struct invmat *view, struct invmat *mat, int posm, int posn, int m, int n);
+int invmatcopy(struct invmat *dest, struct invmat *src);
+int invmatfromrows(struct invmat *mat, double** rows);
+int invmattorows(struct invmat *mat, double** rows);
+size_t invmatbytes(int m, int n);
+size_t invwsbytes(size_t count);
+void invwsinit(struct invworkspace *ws, void *buffer, size_t bytes);
+void *invwsalloc(struct invworkspace *ws, size_t bytes);
+double *invwsdoubles(struct invworkspace *ws, size_t count);
+size_t invwsmark(struct invworkspace *ws);
+void invwsrelease(struct invworkspace *ws, size_t mark);
+int invmatwsalloc(struct invworkspace *ws, struct invmat *mat, int m, int n);
+int invthreads(void);
+void matrixconfig(void) __attribute__((constructor));
+size_t invwsthreadsbytes(int threads, size_t bytes);
+struct invworkspace *invwsthreads(struct invworkspace *ws, int threads, size_t bytes);
+struct invworkspace *invwsthread(struct invworkspace *ws);
+
+int invmatld(int n)
+{
+	//Rows start on a cache line.  When the row length in bytes is a multiple of 2 kB, rows of a column
+	//map to a few cache sets only (power of two orders), so one extra cache line is added as padding.
+	int ld;
+	int perline=INVMATALIGN/sizeof(double);
+
+	ld=((n+perline-1)/perline)*perline;
+	if(ld==0) ld=perline;
+	if((ld%256)==0) ld+=perline;
+	return ld;
+}
+
+int invmatalloc(struct invmat *mat, int m, int n)
+{
+	size_t bytes;
+
+	mat->m=m;
+	mat->n=n;
+	mat->ld=invmatld(n);
+	bytes=invmatbytes(m, n);
+	mat->base=(double *) aligned_alloc(INVMATALIGN, bytes);
+	mat->data=mat->base;
+	if(mat->base==NULL)
+	{
+		printf("\nUnable to allocate matrix of order %d * %d\n",m,n);
+		return 0;
+	}
+	memset(mat->base, 0, bytes);
+	return 1;
+}
+
+void invmatfree(struct invmat *mat)
+{
+	if(mat->base!=NULL) free(mat->base);
+	mat->base=NULL;
+	mat->data=NULL;
+}
+
+int invmatview(struct invmat *view, struct invmat *mat, int posm, int posn, int m, int n)
+{
+	//view is the (m * n) block of mat starting at (posm, posn).  It shares the elements of mat.
+	if(posm<0 || posn<0 || posm+m>mat->m || posn+n>mat->n) return 0;
+	view->m=m;
+	view->n=n;
+	view->ld=mat->ld;
+	view->data=mat->data+(size_t)posm*mat->ld+posn;
+	view->base=NULL;
+	return 1;
+}
+
+int invmatcopy(struct invmat *dest, struct invmat *src)
+{
+	//Copies the elements of src into dest, which has the same order.  Either may be a view.
+	int i;
+	if(dest->m!=src->m || dest->n!=src->n) return 0;
+	for(i=0;i<src->m;i++) memcpy(MATROW(dest,i), MATROW(src,i), src->n*sizeof(double));
+	return 1;
+}
+
+int invmatfromrows(struct invmat *mat, double** rows)
+{
+	int i;
+	for(i=0;i<mat->m;i++) memcpy(MATROW(mat,i), rows[i], mat->n*sizeof(double));
+	return 1;
+}
+
+int invmattorows(struct invmat *mat, double** rows)
+{
+	int i;
+	for(i=0;i<mat->m;i++) memcpy(rows[i], MATROW(mat,i), mat->n*sizeof(double));
+	return 1;
+}
+
+size_t invmatbytes(int m, int n)
+{
+	//Bytes taken by a descriptor of order (m * n), as carved from a workspace or allocated by invmatalloc.
+	size_t bytes;
+	bytes=(size_t)(m>0?m:1)*invmatld(n)*sizeof(double);
+	return ((bytes+INVMATALIGN-1)/INVMATALIGN)*INVMATALIGN;
+}
+
+size_t invwsbytes(size_t count)
+{
+	//Bytes taken by a buffer of count doubles carved from a workspace.
+	return ((count*sizeof(double)+INVMATALIGN-1)/INVMATALIGN)*INVMATALIGN;
+}
+
+void invwsinit(struct invworkspace *ws, void *buffer, size_t bytes)
+{
+	//The arena may start anywhere: up to INVMATALIGN bytes are skipped to align it.
+	size_t skip;
+
+	skip=(INVMATALIGN-((size_t)buffer%INVMATALIGN))%INVMATALIGN;
+	if(buffer==NULL || bytes<skip) skip=bytes=0;
+	ws->base=(char *)buffer+skip;
+	ws->size=bytes-skip;
+	ws->used=0;
+	ws->threads=1;
+}
+
+void *invwsalloc(struct invworkspace *ws, size_t bytes)
+{
+	void *ptr;
+
+	bytes=((bytes+INVMATALIGN-1)/INVMATALIGN)*INVMATALIGN;
+	if(ws->used+bytes>ws->size)
+	{
+		printf("\nWorkspace of %zu bytes is too small: %zu more bytes needed\n",ws->size,ws->used+bytes-ws->size);
+		return NULL;
+	}
+	ptr=ws->base+ws->used;
+	ws->used+=bytes;
+	return ptr;
+}
+
+double *invwsdoubles(struct invworkspace *ws, size_t count)
+{
+	//Buffer for the kernels.  Without a workspace NULL is returned and the kernel allocates its own buffer.
+	if(ws==NULL) return NULL;
+	return (double *) invwsalloc(ws, count*sizeof(double));
+}
+
+size_t invwsmark(struct invworkspace *ws)
+{
+	return (ws==NULL)?0:ws->used;
+}
+
+void invwsrelease(struct invworkspace *ws, size_t mark)
+{
+	//Everything handed out after invwsmark returned mark is given back.
+	if(ws!=NULL) ws->used=mark;
+}
+
+int invmatwsalloc(struct invworkspace *ws, struct invmat *mat, int m, int n)
+{
+	//Descriptor carved from the workspace.  It does not own its buffer, so invmatfree leaves the arena alone.
+	//Without a workspace the descriptor is allocated from the heap as by invmatalloc.
+	if(ws==NULL) return invmatalloc(mat, m, n);
+	mat->m=m;
+	mat->n=n;
+	mat->ld=invmatld(n);
+	mat->base=NULL;
+	mat->data=(double *) invwsalloc(ws, invmatbytes(m, n));
+	if(mat->data==NULL) return 0;
+	return 1;
+}
+
+//Parallel engines give every thread its own arena, so that tasks never share a bump pointer.  A tied task
+//runs on one thread and the tasks it waits for run to completion on top of it, so each arena stays a stack.
+
+static int invmatthreads=0;
+
+void matrixconfig(void)
+{
+	//Key threads of the configuration, 0 (the default) for the OpenMP default.
+	invmatthreads=invconfigint("threads", 0);
+}
+
+int invthreads(void)
+{
+	//Threads an engine will use: the arenas are sized for this many.
+#ifdef _OPENMP
+	if(invmatthreads>0) return invmatthreads;
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+size_t invwsthreadsbytes(int threads, size_t bytes)
+{
+	//Bytes taken by invwsthreads from a workspace: the array of arenas and an arena of bytes per thread.
+	return ((threads*sizeof(struct invworkspace)+INVMATALIGN-1)/INVMATALIGN)*INVMATALIGN+threads*(((bytes+INVMATALIGN-1)/INVMATALIGN)*INVMATALIGN);
+}
+
+struct invworkspace *invwsthreads(struct invworkspace *ws, int threads, size_t bytes)
+{
+	//Carves threads arenas of bytes each from ws.  The array is passed on as the workspace of a parallel engine.
+	int i;
+	struct invworkspace *arenas;
+	void *buffer;
+
+	if(threads<=1) return ws;
+	arenas=(struct invworkspace *) invwsalloc(ws, threads*sizeof(struct invworkspace));
+	if(arenas==NULL) return NULL;
+	bytes=((bytes+INVMATALIGN-1)/INVMATALIGN)*INVMATALIGN;
+	for(i=0;i<threads;i++)
+	{
+		buffer=invwsalloc(ws, bytes);
+		if(buffer==NULL) return NULL;
+		invwsinit(&arenas[i], buffer, bytes);
+	}
+	arenas[0].threads=threads;
+	return arenas;
+}
+
+struct invworkspace *invwsthread(struct invworkspace *ws)
+{
+	//The arena of the calling thread.
+#ifdef _OPENMP
+	if(ws!=NULL && ws->threads>1) return ws+omp_get_thread_num();
+#endif
+	return ws;
+}
+
+#endif
@@ -0,0 +1,391 @@
+// Out-of-core inversion of a matrix kept in a file, for orders whose matrix does not fit in memory.
+// The matrix (order n, doubles, row-major, starting at a byte offset of the file) is inverted in place in the file
+// by block Gauss-Jordan elimination over panels of nb rows, the sweep form of the block formula of inplaceblocksbya:
+// for the panel K, with P = A(K,K)^-1,
+//	A(K,J) := P A(K,J),  A(K,K) := P,  and for the other rows I:  A(I,J) -= A(I,K) A(K,J),  A(I,K) := -A(I,K) P
+// so each panel is one pass over the file.  The row panel stays in memory during its pass and the other rows are
+// streamed through OOCBUFFERS buffers of tr rows: an I/O thread reads the blocks ahead and writes the finished ones
+// behind, while the update of the current block (one product of `invertor_gemm.c', shared among the OpenMP threads
+// when compiled with -fopenmp) runs.  nb and tr are chosen from the memory given: half for the panel, half for the
+// buffers.  As for the other engines, the diagonal blocks A(K,K) of the successive Schur complements must be
+// invertible; they are inverted by the leaf of `invertor_leaf.c' with partial pivoting inside the block.
+// The rows of the file may be padded: invertfd takes the leading dimension ld (doubles from one row to the next), and
+// invertmatfileooc(path, memory) inverts a matrix file of `invertor_file.c' (INVMAT01) with the order, ld and offset
+// of its header.  Compile with -lpthread.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_OOC_C
+#define INVERTOR_OOC_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<pthread.h>
+
+#include "invertor_matrix.c"
+#include "invertor_gemm.c"
+#include "invertor_leaf.c"
+#include "invertor_file.c"
+
+//Buffers of streamed rows: one being updated, one being read ahead and one being written behind.
+#ifndef OOCBUFFERS
+#define OOCBUFFERS 3
+#endif
+//Columns of a product handed to one thread.
+#ifndef OOCCOLUMNS
+#define OOCCOLUMNS 512
+#endif
+
+#define OOCEMPTY 0
+#define OOCREADY 1
+#define OOCDONE 2
+
+struct oocstream
+{
+	int fd;
+	off_t offset;
+	int n;
+	int ld;			//doubles from one row of the file to the next
+	int k0, nb;		//panel of the pass
+	int tr;			//rows of a buffer
+	int blocks;		//blocks of rows streamed in the pass
+	double *panel;		//rows of the panel, written first
+	double *buffer[OOCBUFFERS];
+	int state[OOCBUFFERS];
+	int block[OOCBUFFERS];	//block held by a buffer
+	int error;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+
+int invertfile(const char *path, int n, off_t offset, size_t memory);
+int invertmatfileooc(const char *path, size_t memory);
+int invertfd(int fd, int n, int ld, off_t offset, size_t memory);
+int oocpanelorder(int n, size_t memory, int *tr);
+size_t oocbytes(int n, int nb, int tr);
+int oocpanel(int n, double *panel, int k0, int nb, double *work, int cw, int *pivot, double *leafwork);
+void oocupdate(int n, double *rows, int m, const double *panel, int k0, int nb, double *c);
+void oocblockrows(struct oocstream *st, int b, int *r0, int *m);
+void *oocio(void *arg);
+int oocrows(struct oocstream *st, double *rows, int r0, int m, int writing);
+
+int invertfile(const char *path, int n, off_t offset, size_t memory)
+{
+	//The matrix of order n at byte offset of the file path (rows not padded) is replaced by its inverse,
+	//using about memory bytes.
+	int fd, invertstatus;
+
+	fd=open(path, O_RDWR);
+	if(fd<0)
+	{
+		printf("\nUnable to open the matrix file %s\n",path);
+		return 0;
+	}
+	invertstatus=invertfd(fd, n, n, offset, memory);
+	if(close(fd)!=0)
+	{
+		printf("\nUnable to close the matrix file %s\n",path);
+		invertstatus=0;
+	}
+	return invertstatus;
+}
+
+int invertmatfileooc(const char *path, size_t memory)
+{
+	//The matrix of a matrix file of `invertor_file.c' is replaced by its inverse, using about memory bytes.
+	int fd, invertstatus;
+	struct invfileheader h;
+
+	fd=open(path, O_RDWR);
+	if(fd<0)
+	{
+		printf("\nUnable to open the matrix file %s\n",path);
+		return 0;
+	}
+	invertstatus=invfileheaderread(fd, path, &h);
+	if(invertstatus==1 && h.m!=h.n)
+	{
+		printf("\nThe matrix of %s is (%lld * %lld), not square\n",path,(long long) h.m,(long long) h.n);
+		invertstatus=0;
+	}
+	if(invertstatus==1) invertstatus=invertfd(fd, (int) h.n, (int) h.ld, (off_t) h.offset, memory);
+	if(close(fd)!=0)
+	{
+		printf("\nUnable to close the matrix file %s\n",path);
+		invertstatus=0;
+	}
+	return invertstatus;
+}
+
+int invertfd(int fd, int n, int ld, off_t offset, size_t memory)
+{
+	//As invertfile for a file open for reading and writing, row i starting at byte offset+i*ld*sizeof(double).
+	//On failure the file holds a partly inverted matrix.
+	int i, k0, nb, tr, b, slot, cw, r0, m, invertstatus;
+	int *pivot;
+	double *base, *c, *leafwork;
+	size_t bytes;
+	pthread_t thread;
+	struct oocstream st;
+
+	if(n<=0 || ld<n) return 0;
+	nb=oocpanelorder(n, memory, &tr);
+	if(nb==0)
+	{
+		printf("\nMemory of %zu bytes is too small for the matrix of order = %d: at least %zu bytes needed\n",memory,n,oocbytes(n, 1, 1));
+		return 0;
+	}
+
+	bytes=oocbytes(n, nb, tr);
+	base=(double *) malloc(bytes);
+	if(base==NULL)
+	{
+		printf("\nUnable to allocate %zu bytes of buffers for the matrix of order = %d\n",bytes,n);
+		return 0;
+	}
+	st.fd=fd;
+	st.offset=offset;
+	st.n=n;
+	st.ld=ld;
+	st.tr=tr;
+	st.panel=base;
+	for(i=0;i<OOCBUFFERS;i++) st.buffer[i]=st.panel+(size_t)nb*n+(size_t)i*tr*n;
+	c=st.buffer[0]+(size_t)OOCBUFFERS*tr*n;
+	leafwork=c+(size_t)tr*nb;
+	pivot=(int *) (leafwork+invleafworksize(nb));
+	pthread_mutex_init(&st.lock, NULL);
+	pthread_cond_init(&st.cond, NULL);
+
+	invertstatus=1;
+	for(k0=0;k0<n && invertstatus==1;k0+=nb)
+	{
+		st.k0=k0;
+		st.nb=(n-k0<nb)?n-k0:nb;
+		st.blocks=(k0+tr-1)/tr+(n-k0-st.nb+tr-1)/tr;
+		st.error=0;
+		for(i=0;i<OOCBUFFERS;i++) st.state[i]=OOCEMPTY;
+
+		//The panel is read, inverted at its diagonal and scaled; a buffer is the scratch of the scaling.
+		if(oocrows(&st, st.panel, k0, st.nb, 0)==0)
+		{
+			invertstatus=0;
+			break;
+		}
+		cw=(int) (((size_t)tr*n)/st.nb);
+		if(oocpanel(n, st.panel, k0, st.nb, st.buffer[0], cw, pivot, leafwork)==0)
+		{
+			printf("\nUnable to invert the diagonal block of order %d at row %d of the matrix of order = %d\n",st.nb,k0,n);
+			invertstatus=0;
+			break;
+		}
+
+		//The I/O thread writes the panel back and streams the other rows; this thread updates them in order.
+		if(pthread_create(&thread, NULL, oocio, &st)!=0)
+		{
+			printf("\nUnable to start the I/O thread for the matrix of order = %d\n",n);
+			invertstatus=0;
+			break;
+		}
+		for(b=0;b<st.blocks;b++)
+		{
+			slot=b%OOCBUFFERS;
+			pthread_mutex_lock(&st.lock);
+			while(!(st.state[slot]==OOCREADY && st.block[slot]==b) && st.error==0) pthread_cond_wait(&st.cond, &st.lock);
+			pthread_mutex_unlock(&st.lock);
+			if(st.error) break;
+
+			oocblockrows(&st, b, &r0, &m);
+			oocupdate(n, st.buffer[slot], m, st.panel, k0, st.nb, c);
+
+			pthread_mutex_lock(&st.lock);
+			st.state[slot]=OOCDONE;
+			pthread_cond_broadcast(&st.cond);
+			pthread_mutex_unlock(&st.lock);
+		}
+		if(b<st.blocks)
+		{
+			//The I/O thread stops at its next wait once the error is seen by both sides.
+			pthread_mutex_lock(&st.lock);
+			st.error=1;
+			pthread_cond_broadcast(&st.cond);
+			pthread_mutex_unlock(&st.lock);
+		}
+		pthread_join(thread, NULL);
+		if(st.error) invertstatus=0;
+	}
+
+	pthread_cond_destroy(&st.cond);
+	pthread_mutex_destroy(&st.lock);
+	free(base);
+	return invertstatus;
+}
+
+int oocpanelorder(int n, size_t memory, int *tr)
+{
+	//Rows nb of the panel and tr of a buffer for the memory given (0 if it is too small): half of it for the panel
+	//and half for the buffers, less the scratch of the leaf.
+	int nb;
+	size_t row;
+
+	row=(size_t)n*sizeof(double);
+	nb=(memory/2/row<(size_t)n)?(int) (memory/2/row):n;
+	*tr=(memory/2/(OOCBUFFERS*row)<(size_t)n)?(int) (memory/2/(OOCBUFFERS*row)):n;
+	if(*tr>nb) *tr=nb;
+	while(nb>0 && *tr>0 && oocbytes(n, nb, *tr)>memory)
+	{
+		nb-=(nb>64)?nb/16:1;
+		if(*tr>nb) *tr=nb;
+	}
+	if(nb<=0 || *tr<=0) return 0;
+	return nb;
+}
+
+size_t oocbytes(int n, int nb, int tr)
+{
+	//Bytes of buffers for panels of nb rows and buffers of tr rows: the panel, the buffers, the columns A(I,K) of a
+	//block, the scratch and the pivots of the leaf.
+	return ((size_t)nb*n+(size_t)OOCBUFFERS*tr*n+(size_t)tr*nb+invleafworksize(nb))*sizeof(double)+nb*sizeof(int);
+}
+
+int oocpanel(int n, double *panel, int k0, int nb, double *work, int cw, int *pivot, double *leafwork)
+{
+	//panel holds the rows K = [k0, k0+nb) (nb * n).  A(K,K) is replaced by P = A(K,K)^-1 and the other columns J by
+	//P A(K,J), cw columns at a time copied to work (nb * cw).
+	int i, j, jj, w, cols;
+
+	if(invleafgj(nb, panel+k0, n, pivot, leafwork)==0) return 0;
+	if(cw<1) cw=1;
+	for(j=0;j<n;j+=w)
+	{
+		if(j==k0)
+		{
+			w=nb;
+			continue;
+		}
+		w=(j<k0)?k0-j:n-j;
+		if(w>cw) w=cw;
+		for(i=0;i<nb;i++) memcpy(work+(size_t)i*w, panel+(size_t)i*n+j, w*sizeof(double));
+		cols=w;
+		#pragma omp parallel for schedule(dynamic)
+		for(jj=0;jj<cols;jj+=OOCCOLUMNS)
+			invgemm(nb, (cols-jj<OOCCOLUMNS)?cols-jj:OOCCOLUMNS, nb, 1.0, panel+k0, n, work+jj, cols, 0.0, panel+j+jj, n, NULL);
+	}
+	return 1;
+}
+
+void oocupdate(int n, double *rows, int m, const double *panel, int k0, int nb, double *c)
+{
+	//rows (m * n) outside the panel: A(I,J) -= A(I,K) A(K,J) and A(I,K) := -A(I,K) P, as one product over all the
+	//columns after A(I,K) is moved to c (m * nb) and zeroed, the panel holding P at its columns K.
+	int i, j;
+
+	for(i=0;i<m;i++)
+	{
+		memcpy(c+(size_t)i*nb, rows+(size_t)i*n+k0, nb*sizeof(double));
+		memset(rows+(size_t)i*n+k0, 0, nb*sizeof(double));
+	}
+	#pragma omp parallel for schedule(dynamic)
+	for(j=0;j<n;j+=OOCCOLUMNS)
+		invgemm(m, (n-j<OOCCOLUMNS)?n-j:OOCCOLUMNS, nb, -1.0, c, nb, panel+j, n, 1.0, rows+j, n, NULL);
+}
+
+void oocblockrows(struct oocstream *st, int b, int *r0, int *m)
+{
+	//First row r0 and rows m of the streamed block b: the rows above the panel, then those below it.
+	int above, end;
+
+	above=(st->k0+st->tr-1)/st->tr;
+	if(b<above)
+	{
+		*r0=b*st->tr;
+		end=st->k0;
+	}
+	else
+	{
+		*r0=st->k0+st->nb+(b-above)*st->tr;
+		end=st->n;
+	}
+	*m=(end-*r0<st->tr)?end-*r0:st->tr;
+}
+
+void *oocio(void *arg)
+{
+	//I/O thread of a pass: writes the panel, then reads the blocks into the buffers in turn, writing back the block a
+	//buffer held once it has been updated, and finally writes the last blocks.
+	struct oocstream *st=(struct oocstream *) arg;
+	int b, slot, r0, m, status;
+
+	status=oocrows(st, st->panel, st->k0, st->nb, 1);
+	for(b=0;b<st->blocks+OOCBUFFERS && status;b++)
+	{
+		slot=b%OOCBUFFERS;
+		pthread_mutex_lock(&st->lock);
+		while(st->state[slot]==OOCREADY && st->error==0) pthread_cond_wait(&st->cond, &st->lock);
+		pthread_mutex_unlock(&st->lock);
+		if(st->error) return NULL;
+
+		if(st->state[slot]==OOCDONE)
+		{
+			oocblockrows(st, st->block[slot], &r0, &m);
+			status=oocrows(st, st->buffer[slot], r0, m, 1);
+			pthread_mutex_lock(&st->lock);
+			st->state[slot]=OOCEMPTY;
+			pthread_mutex_unlock(&st->lock);
+		}
+		if(b>=st->blocks || status==0) continue;
+		oocblockrows(st, b, &r0, &m);
+		status=oocrows(st, st->buffer[slot], r0, m, 0);
+
+		pthread_mutex_lock(&st->lock);
+		st->block[slot]=b;
+		st->state[slot]=OOCREADY;
+		pthread_cond_broadcast(&st->cond);
+		pthread_mutex_unlock(&st->lock);
+	}
+	if(status==0)
+	{
+		pthread_mutex_lock(&st->lock);
+		st->error=1;
+		pthread_cond_broadcast(&st->cond);
+		pthread_mutex_unlock(&st->lock);
+	}
+	return NULL;
+}
+
+int oocrows(struct oocstream *st, double *rows, int r0, int m, int writing)
+{
+	//The m rows from r0 of the file to rows (m * n, not padded), or back, by invfileio of `invertor_file.c':
+	//in one transfer when the rows of the file are not padded, else row by row.
+	int i, count;
+	size_t length;
+	off_t pos;
+
+	pos=st->offset+(off_t)r0*st->ld*sizeof(double);
+	count=(st->ld==st->n)?1:m;
+	length=(st->ld==st->n)?(size_t)m*st->n:(size_t)st->n;
+	for(i=0;i<count;i++)
+		if(invfileio(st->fd, rows+(size_t)i*length, length*sizeof(double), pos+(off_t)i*st->ld*sizeof(double), writing)==0)
+		{
+			printf("\nUnable to %s the rows %d to %d of the matrix file\n",writing?"write":"read",r0,r0+m-1);
+			return 0;
+		}
+	return 1;
+}
+
+#endif
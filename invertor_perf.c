@@ -0,0 +1,239 @@
+// Hardware counters of the phases of the engines, read with the Linux perf_event_open interface: cycles, instructions,
+// L1 data cache read misses, last level cache read misses, data TLB read misses and the task clock, summed over the
+// calls of each phase and over the threads that ran them.  Compiled only with -DINVERTORPERF: without it PERFBEGIN and
+// PERFEND expand to nothing and nothing of this file remains.
+//	INVPERFLEAF	dense leaf inversions (inplaceleaf of files 4 and 5, invertleaf of file 6)
+//	INVPERFSCHUR	schurcomplement updates (files 4 and 5)
+//	INVPERFLEFT	in-place left products inplaceleftmatmul (files 4 and 5)
+//	INVPERFRIGHT	in-place right products inplacerightmatmul (files 4 and 5)
+//	INVPERFMIRROR	copies of blocks into the mirrors (file 6)
+//	INVPERFASSEMBLY	assembly of the four solutions from E^-1 and S^-1 (file 3)
+// After the inversion, invperfread(&p) returns the totals in a struct invperf and invperfprint(&p) prints them with
+// the instructions per cycle and the misses per thousand instructions; invperfreset() starts again.  Reading them:
+// a low IPC with many LLC misses per thousand instructions is a phase waiting for memory bandwidth; a low IPC with
+// dTLB misses close to the LLC misses is a phase chasing row pointers across pages.  Counters the kernel or the
+// virtual machine does not offer (perf_event_paranoid, no PMU) are reported as "-"; the task clock is always there.
+// Every thread opens its own counters on its first phase; each phase costs two read calls, so tiny phases are slowed.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_PERF_C
+#define INVERTOR_PERF_C
+
+#ifdef INVERTORPERF
+
+#include<stdio.h>
+#include<string.h>
+#ifdef __linux__
+#include<unistd.h>
+#include<sys/syscall.h>
+#include<linux/perf_event.h>
+#endif
+
+#define INVPERFLEAF 0
+#define INVPERFSCHUR 1
+#define INVPERFLEFT 2
+#define INVPERFRIGHT 3
+#define INVPERFMIRROR 4
+#define INVPERFASSEMBLY 5
+#define INVPERFPHASES 6
+
+#define INVPERFCYCLES 0
+#define INVPERFINSTRUCTIONS 1
+#define INVPERFL1DMISSES 2
+#define INVPERFLLCMISSES 3
+#define INVPERFDTLBMISSES 4
+#define INVPERFTASKCLOCK 5	//nanoseconds
+#define INVPERFEVENTS 6
+
+struct invperf
+{
+	int counted[INVPERFEVENTS];	//0 when the event could not be opened: its counts are 0
+	unsigned long long calls[INVPERFPHASES];
+	unsigned long long count[INVPERFPHASES][INVPERFEVENTS];
+};
+
+static const char *invperfphasenames[INVPERFPHASES]={"leaf", "schurcomplement", "leftmatmul", "rightmatmul", "mirror copy", "assembly"};
+static const char *invperfeventnames[INVPERFEVENTS]={"cycles", "instructions", "L1D misses", "LLC misses", "dTLB misses", "task clock"};
+
+static unsigned long long invperftotal[INVPERFPHASES][INVPERFEVENTS];
+static unsigned long long invperfcalls[INVPERFPHASES];
+static int invperfcounted[INVPERFEVENTS];
+
+//Counters of the calling thread: one group, read at once, whose leader is the first event opened.
+static __thread int invperfstate=0;		//0 not opened yet, 1 open, -1 no counter
+static __thread int invperfleader=-1;
+static __thread int invperfslot[INVPERFEVENTS];	//place of the event in the group read, -1 if not opened
+static __thread int invperfmembers=0;
+static __thread unsigned long long invperfbegin[INVPERFPHASES][INVPERFEVENTS];
+
+int invperfopen(void);
+int invperfsample(unsigned long long *value);
+void invperfstart(int phase);
+void invperfstop(int phase);
+int invperfread(struct invperf *p);
+void invperfreset(void);
+void invperfprint(const struct invperf *p);
+
+#define PERFBEGIN(phase) invperfstart(phase)
+#define PERFEND(phase) invperfstop(phase)
+
+int invperfopen(void)
+{
+	//Opens the counters of the calling thread, user space only.  Returns 1 if at least one could be opened.
+	int e, fd;
+#ifdef __linux__
+	struct perf_event_attr attr;
+	static const unsigned int type[INVPERFEVENTS]={PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_SOFTWARE};
+	static const unsigned long long config[INVPERFEVENTS]={PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ<<8) | (PERF_COUNT_HW_CACHE_RESULT_MISS<<16),
+		PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ<<8) | (PERF_COUNT_HW_CACHE_RESULT_MISS<<16),
+		PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ<<8) | (PERF_COUNT_HW_CACHE_RESULT_MISS<<16),
+		PERF_COUNT_SW_TASK_CLOCK};
+#endif
+
+	invperfstate=-1;
+	for(e=0;e<INVPERFEVENTS;e++)
+	{
+		invperfslot[e]=-1;
+#ifdef __linux__
+		memset(&attr, 0, sizeof(attr));
+		attr.size=sizeof(attr);
+		attr.type=type[e];
+		attr.config=config[e];
+		attr.exclude_kernel=1;
+		attr.exclude_hv=1;
+		attr.read_format=PERF_FORMAT_GROUP;
+		fd=syscall(SYS_perf_event_open, &attr, 0, -1, invperfleader, 0);
+		if(fd<0) continue;
+		if(invperfleader<0) invperfleader=fd;
+		invperfslot[e]=invperfmembers++;
+		invperfstate=1;
+		#pragma omp atomic write
+		invperfcounted[e]=1;
+#else
+		fd=-1;
+#endif
+	}
+	return invperfstate==1;
+}
+
+int invperfsample(unsigned long long *value)
+{
+	//value[e] := the count of event e of the calling thread so far.
+	unsigned long long group[1+INVPERFEVENTS];
+	int e;
+
+#ifdef __linux__
+	if(read(invperfleader, group, (1+invperfmembers)*sizeof(unsigned long long))!=(ssize_t)((1+invperfmembers)*sizeof(unsigned long long))) return 0;
+#else
+	return 0;
+#endif
+	for(e=0;e<INVPERFEVENTS;e++) value[e]=(invperfslot[e]<0)?0:group[1+invperfslot[e]];
+	return 1;
+}
+
+void invperfstart(int phase)
+{
+	if(invperfstate==0) invperfopen();
+	if(invperfstate<0) return;
+	if(invperfsample(invperfbegin[phase])==0) invperfstate=-1;
+}
+
+void invperfstop(int phase)
+{
+	unsigned long long now[INVPERFEVENTS], delta;
+	int e;
+
+	if(invperfstate<0) return;
+	if(invperfsample(now)==0)
+	{
+		invperfstate=-1;
+		return;
+	}
+	for(e=0;e<INVPERFEVENTS;e++)
+	{
+		delta=now[e]-invperfbegin[phase][e];
+		#pragma omp atomic update
+		invperftotal[phase][e]+=delta;
+	}
+	#pragma omp atomic update
+	invperfcalls[phase]++;
+}
+
+int invperfread(struct invperf *p)
+{
+	//Totals since the start or the last invperfreset.  Returns the number of events counted (0: no counter at all).
+	int phase, e, events=0;
+
+	for(e=0;e<INVPERFEVENTS;e++)
+	{
+		p->counted[e]=invperfcounted[e];
+		events+=invperfcounted[e];
+	}
+	for(phase=0;phase<INVPERFPHASES;phase++)
+	{
+		p->calls[phase]=invperfcalls[phase];
+		for(e=0;e<INVPERFEVENTS;e++) p->count[phase][e]=invperftotal[phase][e];
+	}
+	return events;
+}
+
+void invperfreset(void)
+{
+	memset(invperftotal, 0, sizeof(invperftotal));
+	memset(invperfcalls, 0, sizeof(invperfcalls));
+}
+
+void invperfprint(const struct invperf *p)
+{
+	//One line per phase that ran: the counts, then IPC and the misses per thousand instructions.
+	int phase, e;
+	double kinst;
+
+	printf("%-16s %10s", "phase", "calls");
+	for(e=0;e<INVPERFEVENTS;e++) printf(" %14s", invperfeventnames[e]);
+	printf(" %6s %8s %8s %8s\n", "IPC", "L1D/ki", "LLC/ki", "dTLB/ki");
+	for(phase=0;phase<INVPERFPHASES;phase++)
+	{
+		if(p->calls[phase]==0) continue;
+		printf("%-16s %10llu", invperfphasenames[phase], p->calls[phase]);
+		for(e=0;e<INVPERFEVENTS;e++)
+		{
+			if(p->counted[e]) printf(" %14llu", p->count[phase][e]);
+			else printf(" %14s", "-");
+		}
+		if(p->counted[INVPERFCYCLES] && p->counted[INVPERFINSTRUCTIONS] && p->count[phase][INVPERFCYCLES]>0)
+			printf(" %6.2f", (double) p->count[phase][INVPERFINSTRUCTIONS]/p->count[phase][INVPERFCYCLES]);
+		else printf(" %6s", "-");
+		kinst=p->count[phase][INVPERFINSTRUCTIONS]/1000.0;
+		for(e=INVPERFL1DMISSES;e<=INVPERFDTLBMISSES;e++)
+		{
+			if(p->counted[e] && p->counted[INVPERFINSTRUCTIONS] && kinst>0) printf(" %8.3f", p->count[phase][e]/kinst);
+			else printf(" %8s", "-");
+		}
+		printf("\n");
+	}
+}
+
+#else
+
+#define PERFBEGIN(phase)
+#define PERFEND(phase)
+
+#endif
+
+#endif
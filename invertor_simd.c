@@ -0,0 +1,309 @@
+// Vector kernels for the in-place products of the invertor engines, chosen at run time from the processor.
+// inplaceleftmatmul (B := -A * B) and inplacerightmatmul (A := A * B) overwrite one of their operands, so
+// the overwritten rows or columns are first copied to a contiguous temporary and the result is written back
+// by a kernel computing  out := s * T * M  for up to SIMDROWS rows of T at a time, with s = -1 or 1.
+// The kernel is compiled for AVX-512, AVX2 and plain C in the same binary (GCC target attributes), and the
+// widest one supported by the processor is selected once at startup, before any thread runs.  Setting the environment variable
+// INVERTOR_SIMD to "scalar", "avx2" or "avx512" forces a kernel (if the processor supports it).
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_SIMD_C
+#define INVERTOR_SIMD_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SIMDX86
+#include<immintrin.h>
+#endif
+
+//Rows of T handled together by a kernel call, and columns of B copied together by the left product.
+#define SIMDROWS 4
+#define SIMDPANEL 64
+
+typedef void (*simdkernelfn)(int r, int n, int w, double s, const double *t, int ldt, const double *m, int ldm, double *out, int ldo);
+
+void simdkernelscalar(int r, int n, int w, double s, const double *t, int ldt, const double *m, int ldm, double *out, int ldo);
+#ifdef SIMDX86
+void simdkernelavx2(int r, int n, int w, double s, const double *t, int ldt, const double *m, int ldm, double *out, int ldo);
+void simdkernelavx512(int r, int n, int w, double s, const double *t, int ldt, const double *m, int ldm, double *out, int ldo);
+#endif
+void simdconfig(void) __attribute__((constructor));
+simdkernelfn simdkernelselect(void);
+const char *simdkernelname(void);
+size_t simdleftworksize(int n);
+size_t simdrightworksize(int n);
+int simdleftmatmul(int n, int nb, const double *a, int lda, double *b, int ldb, double *work);
+int simdrightmatmul(int ma, int n, double *a, int lda, const double *b, int ldb, double *work);
+
+static simdkernelfn simdkernel=simdkernelscalar;
+static const char *simdname="scalar";
+
+void simdkernelscalar(int r, int n, int w, double s, const double *t, int ldt, const double *m, int ldm, double *out, int ldo)
+{
+	//out(r * w) := s * T(r * n) * M(n * w).  Rows of out are accumulated row by row of M.
+	int i,j,k;
+	double *oi;
+	const double *ti, *mk;
+
+	for(i=0;i<r;i++)
+	{
+		oi=out+(size_t)i*ldo;
+		ti=t+(size_t)i*ldt;
+		for(j=0;j<w;j++) oi[j]=0;
+		for(k=0;k<n;k++)
+		{
+			mk=m+(size_t)k*ldm;
+			for(j=0;j<w;j++) oi[j]+=ti[k]*mk[j];
+		}
+		for(j=0;j<w;j++) oi[j]*=s;
+	}
+}
+
+#ifdef SIMDX86
+__attribute__((target("avx2,fma")))
+void simdkernelavx2(int r, int n, int w, double s, const double *t, int ldt, const double *m, int ldm, double *out, int ldo)
+{
+	//Tiles of SIMDROWS rows * 8 columns: 8 accumulators of 4 doubles.  When r < SIMDROWS the missing
+	//rows repeat row 0 and are not stored.  Columns beyond the last full tile go to the scalar kernel.
+	int j,k;
+	const double *t0, *t1, *t2, *t3, *mk;
+	__m256d c00, c01, c10, c11, c20, c21, c30, c31, m0, m1, a, sv;
+	double *oi;
+
+	t0=t;
+	t1=t+(size_t)((r>1)?1:0)*ldt;
+	t2=t+(size_t)((r>2)?2:0)*ldt;
+	t3=t+(size_t)((r>3)?3:0)*ldt;
+	sv=_mm256_set1_pd(s);
+
+	for(j=0;j+8<=w;j+=8)
+	{
+		c00=c01=c10=c11=c20=c21=c30=c31=_mm256_setzero_pd();
+		for(k=0;k<n;k++)
+		{
+			mk=m+(size_t)k*ldm+j;
+			m0=_mm256_loadu_pd(mk);
+			m1=_mm256_loadu_pd(mk+4);
+			a=_mm256_broadcast_sd(t0+k);
+			c00=_mm256_fmadd_pd(a,m0,c00);
+			c01=_mm256_fmadd_pd(a,m1,c01);
+			a=_mm256_broadcast_sd(t1+k);
+			c10=_mm256_fmadd_pd(a,m0,c10);
+			c11=_mm256_fmadd_pd(a,m1,c11);
+			a=_mm256_broadcast_sd(t2+k);
+			c20=_mm256_fmadd_pd(a,m0,c20);
+			c21=_mm256_fmadd_pd(a,m1,c21);
+			a=_mm256_broadcast_sd(t3+k);
+			c30=_mm256_fmadd_pd(a,m0,c30);
+			c31=_mm256_fmadd_pd(a,m1,c31);
+		}
+		oi=out+j;
+		_mm256_storeu_pd(oi, _mm256_mul_pd(sv,c00));
+		_mm256_storeu_pd(oi+4, _mm256_mul_pd(sv,c01));
+		if(r>1)
+		{
+			oi+=ldo;
+			_mm256_storeu_pd(oi, _mm256_mul_pd(sv,c10));
+			_mm256_storeu_pd(oi+4, _mm256_mul_pd(sv,c11));
+		}
+		if(r>2)
+		{
+			oi+=ldo;
+			_mm256_storeu_pd(oi, _mm256_mul_pd(sv,c20));
+			_mm256_storeu_pd(oi+4, _mm256_mul_pd(sv,c21));
+		}
+		if(r>3)
+		{
+			oi+=ldo;
+			_mm256_storeu_pd(oi, _mm256_mul_pd(sv,c30));
+			_mm256_storeu_pd(oi+4, _mm256_mul_pd(sv,c31));
+		}
+	}
+	if(j<w) simdkernelscalar(r, n, w-j, s, t, ldt, m+j, ldm, out+j, ldo);
+}
+
+__attribute__((target("avx512f")))
+void simdkernelavx512(int r, int n, int w, double s, const double *t, int ldt, const double *m, int ldm, double *out, int ldo)
+{
+	//Tiles of SIMDROWS rows * 16 columns: 8 accumulators of 8 doubles.  The last columns of a row
+	//are done with masked loads and stores, so no scalar tail is left.
+	int j,k,rest;
+	const double *t0, *t1, *t2, *t3, *mk;
+	__m512d c00, c01, c10, c11, c20, c21, c30, c31, m0, m1, a, sv;
+	__mmask8 k0, k1;
+	double *oi;
+
+	t0=t;
+	t1=t+(size_t)((r>1)?1:0)*ldt;
+	t2=t+(size_t)((r>2)?2:0)*ldt;
+	t3=t+(size_t)((r>3)?3:0)*ldt;
+	sv=_mm512_set1_pd(s);
+
+	for(j=0;j<w;j+=16)
+	{
+		rest=w-j;
+		k0=(rest>=8)?0xFF:(__mmask8)((1u<<rest)-1);
+		k1=(rest>=16)?0xFF:((rest>8)?(__mmask8)((1u<<(rest-8))-1):0);
+		c00=c01=c10=c11=c20=c21=c30=c31=_mm512_setzero_pd();
+		for(k=0;k<n;k++)
+		{
+			mk=m+(size_t)k*ldm+j;
+			m0=_mm512_maskz_loadu_pd(k0, mk);
+			m1=_mm512_maskz_loadu_pd(k1, mk+8);
+			a=_mm512_set1_pd(t0[k]);
+			c00=_mm512_fmadd_pd(a,m0,c00);
+			c01=_mm512_fmadd_pd(a,m1,c01);
+			a=_mm512_set1_pd(t1[k]);
+			c10=_mm512_fmadd_pd(a,m0,c10);
+			c11=_mm512_fmadd_pd(a,m1,c11);
+			a=_mm512_set1_pd(t2[k]);
+			c20=_mm512_fmadd_pd(a,m0,c20);
+			c21=_mm512_fmadd_pd(a,m1,c21);
+			a=_mm512_set1_pd(t3[k]);
+			c30=_mm512_fmadd_pd(a,m0,c30);
+			c31=_mm512_fmadd_pd(a,m1,c31);
+		}
+		oi=out+j;
+		_mm512_mask_storeu_pd(oi, k0, _mm512_mul_pd(sv,c00));
+		_mm512_mask_storeu_pd(oi+8, k1, _mm512_mul_pd(sv,c01));
+		if(r>1)
+		{
+			oi+=ldo;
+			_mm512_mask_storeu_pd(oi, k0, _mm512_mul_pd(sv,c10));
+			_mm512_mask_storeu_pd(oi+8, k1, _mm512_mul_pd(sv,c11));
+		}
+		if(r>2)
+		{
+			oi+=ldo;
+			_mm512_mask_storeu_pd(oi, k0, _mm512_mul_pd(sv,c20));
+			_mm512_mask_storeu_pd(oi+8, k1, _mm512_mul_pd(sv,c21));
+		}
+		if(r>3)
+		{
+			oi+=ldo;
+			_mm512_mask_storeu_pd(oi, k0, _mm512_mul_pd(sv,c30));
+			_mm512_mask_storeu_pd(oi+8, k1, _mm512_mul_pd(sv,c31));
+		}
+	}
+}
+#endif
+
+simdkernelfn simdkernelselect(void)
+{
+	//Called once: picks the widest kernel the processor supports, unless INVERTOR_SIMD asks for another.
+	const char *force;
+	simdkernelfn kernel;
+
+	force=getenv("INVERTOR_SIMD");
+	kernel=simdkernelscalar;
+	simdname="scalar";
+#ifdef SIMDX86
+	__builtin_cpu_init();
+	if(force!=NULL && strcmp(force,"scalar")==0) return kernel;
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+	{
+		kernel=simdkernelavx2;
+		simdname="avx2";
+	}
+	if(force!=NULL && strcmp(force,"avx2")==0) return kernel;
+	if(__builtin_cpu_supports("avx512f"))
+	{
+		kernel=simdkernelavx512;
+		simdname="avx512";
+	}
+#endif
+	return kernel;
+}
+
+void simdconfig(void)
+{
+	//The kernel is chosen before main, so the OpenMP tasks of the engines only ever read simdkernel.
+	simdkernel=simdkernelselect();
+}
+
+const char *simdkernelname(void)
+{
+	return simdname;
+}
+
+size_t simdleftworksize(int n)
+{
+	return (size_t)n*SIMDPANEL;
+}
+
+size_t simdrightworksize(int n)
+{
+	return (size_t)SIMDROWS*n;
+}
+
+int simdleftmatmul(int n, int nb, const double *a, int lda, double *b, int ldb, double *work)
+{
+	//B(n * nb) := -A(n * n) * B.  Panels of SIMDPANEL columns of B are copied to work (n * SIMDPANEL
+	//doubles, allocated here if NULL) and the rows of the product are written back into the panel.
+	int i,j,k,w;
+	double *owned;
+
+	owned=NULL;
+	if(work==NULL)
+	{
+		owned=(double *) malloc(simdleftworksize(n)*sizeof(double));
+		if(owned==NULL) return 0;
+		work=owned;
+	}
+
+	for(j=0;j<nb;j+=SIMDPANEL)
+	{
+		w=(nb-j<SIMDPANEL)?nb-j:SIMDPANEL;
+		for(k=0;k<n;k++) memcpy(work+(size_t)k*w, b+(size_t)k*ldb+j, w*sizeof(double));
+		for(i=0;i<n;i+=SIMDROWS)
+			simdkernel((n-i<SIMDROWS)?n-i:SIMDROWS, n, w, -1.0, a+(size_t)i*lda, lda, work, w, b+(size_t)i*ldb+j, ldb);
+	}
+
+	if(owned!=NULL) free(owned);
+	return 1;
+}
+
+int simdrightmatmul(int ma, int n, double *a, int lda, const double *b, int ldb, double *work)
+{
+	//A(ma * n) := A * B(n * n).  SIMDROWS rows of A at a time are copied to work (SIMDROWS * n doubles,
+	//allocated here if NULL) and their products with B are written back in place.
+	int i,k,r;
+	double *owned;
+
+	owned=NULL;
+	if(work==NULL)
+	{
+		owned=(double *) malloc(simdrightworksize(n)*sizeof(double));
+		if(owned==NULL) return 0;
+		work=owned;
+	}
+
+	for(i=0;i<ma;i+=SIMDROWS)
+	{
+		r=(ma-i<SIMDROWS)?ma-i:SIMDROWS;
+		for(k=0;k<r;k++) memcpy(work+(size_t)k*n, a+(size_t)(i+k)*lda, n*sizeof(double));
+		simdkernel(r, n, n, 1.0, work, n, b, ldb, a+(size_t)i*lda, lda);
+	}
+
+	if(owned!=NULL) free(owned);
+	return 1;
+}
+
+#endif
@@ -0,0 +1,353 @@
+// Inversion of symmetric positive definite matrices (covariance and Gram matrices) in half storage.
+// With C = B^T the Schur complements and the inverse are symmetric, so only the lower triangle is stored and updated.
+// The triangle is kept in a recursive layout: a block of order n is [A | C | D], A (order n/2) and D (order n - n/2)
+// being again such blocks and C (D rows * A columns) a plain row-major block, down to SPDLEAFORDER where the whole
+// square block is stored.  This takes about n^2/2 doubles and every product is a call of `invertor_gemm.c'.
+// The steps of inplaceblocksbya become:
+//	W = C A^-1, S = D - W C^T (lower part only), S^-1, C := -S^-1 W, A^-1 := A^-1 - W^T C (lower part only)
+// which needs about half of the multiplications, the upper blocks B being never formed.
+// C is replaced by W and by -S^-1 W panel by panel, so the scratch is SPDPANEL rows or columns of the matrix.
+// The in-place engine `invertor_inplace_by_a.c' includes this file; call invertmatspd in place of invertmat.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_SPD_C
+#define INVERTOR_SPD_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+#include "invertor_matrix.c"
+#include "invertor_gemm.c"
+#include "invertor_leaf.c"
+
+//Order at and below which a diagonal block is stored whole and inverted by the Gauss-Jordan leaf.
+#ifndef SPDLEAFORDER
+#define SPDLEAFORDER 64
+#endif
+//Rows (columns) of C replaced together by W (-S^-1 W).
+#define SPDPANEL 256
+
+size_t spdsize(int n);
+size_t spdworkspace(int n);
+size_t invertmatspdworkspace(int n);
+int invertmatspdws(int n, double** mata, double** inverta, void *work, size_t bytes);
+int invertmatspd(int n, double** mata, double** inverta);
+void spdfromrows(int n, double *t, double** mata, int pos);
+void spdtorows(int n, const double *t, double** inverta, int pos);
+int spdinvert(int n, double *t, struct invworkspace *ws);
+int spdschurrows(int dn, double *dt, double *c, int ldc, int a, const double *at, struct invworkspace *ws);
+int spdschurcols(int an, double *at, double *c, int ldc, int d, const double *dt, struct invworkspace *ws);
+int spdrightmul(int n, const double *t, int m, double alpha, const double *x, int ldx, double beta, double *y, int ldy, double *work);
+int spdleftmul(int n, const double *t, int m, double alpha, const double *x, int ldx, double beta, double *y, int ldy, double *work);
+int spdrankupdate(int n, double *t, int k, double alpha, int transx, const double *x, int ldx, int transy, const double *y, int ldy, double *work);
+
+size_t spdsize(int n)
+{
+	//Doubles taken by the lower triangle of order n in the recursive layout.
+	int a;
+
+	if(n<=SPDLEAFORDER) return (size_t)n*n;
+	a=n/2;
+	return spdsize(a)+(size_t)a*(n-a)+spdsize(n-a);
+}
+
+size_t spdworkspace(int n)
+{
+	//Bytes of scratch of spdinvert: a panel with the packing buffers, or the pivots and buffers of a leaf.
+	size_t leaf, schur;
+	int m;
+
+	m=(n<SPDLEAFORDER)?n:SPDLEAFORDER;
+	leaf=invwsbytes((m*sizeof(int)+sizeof(double)-1)/sizeof(double))+invwsbytes(invleafworksize(m));
+	if(n<=SPDLEAFORDER) return leaf;
+	schur=invwsbytes((size_t)SPDPANEL*n)+invwsbytes(invgemmworksize(n, n, n));
+	return (leaf>schur)?leaf:schur;
+}
+
+int invertmatspd(int n, double** mata, double** inverta)
+{
+	//As invertmat for a symmetric positive definite matrix.  Only the lower triangle of mata is read;
+	//both triangles of inverta are written.
+	int invertstatus;
+	size_t bytes;
+	void *work;
+
+	if(n<=0) return 0;
+
+	bytes=invertmatspdworkspace(n);
+	work=malloc(bytes);
+	if(work==NULL)
+	{
+		printf("\nUnable to allocate workspace of %zu bytes for the matrix of order = %d\n",bytes,n);
+		return 0;
+	}
+	invertstatus=invertmatspdws(n, mata, inverta, work, bytes);
+	free(work);
+	return invertstatus;
+}
+
+size_t invertmatspdworkspace(int n)
+{
+	//Bytes of the arena for invertmatspdws: the triangle and the scratch of spdinvert.
+	if(n<=0) return 0;
+	return INVMATALIGN+invwsbytes(spdsize(n))+spdworkspace(n);
+}
+
+int invertmatspdws(int n, double** mata, double** inverta, void *work, size_t bytes)
+{
+	//The lower triangle is copied into the recursive layout carved from work, inverted there and copied back.
+	int invertstatus;
+	double *t;
+	struct invworkspace ws;
+
+	if(n<=0) return 0;
+
+	invwsinit(&ws, work, bytes);
+	t=invwsdoubles(&ws, spdsize(n));
+	if(t==NULL)
+	{
+		printf("\nUnable to allocate the triangle for the matrix of order = %d\n",n);
+		return 0;
+	}
+	spdfromrows(n, t, mata, 0);
+	invertstatus=spdinvert(n, t, &ws);
+	if(invertstatus==0)
+	{
+		printf("\nUnable to invert the matrix of order = %d\n",n);
+	}
+	spdtorows(n, t, inverta, 0);
+	return invertstatus;
+}
+
+void spdfromrows(int n, double *t, double** mata, int pos)
+{
+	//Block of order n at (pos,pos) of mata into t; a leaf is filled whole from the lower triangle.
+	int i,j,a;
+	double *c;
+
+	if(n<=SPDLEAFORDER)
+	{
+		for(i=0;i<n;i++)
+			for(j=0;j<n;j++)
+				t[(size_t)i*n+j]=(i>=j)?mata[pos+i][pos+j]:mata[pos+j][pos+i];
+		return;
+	}
+	a=n/2;
+	c=t+spdsize(a);
+	spdfromrows(a, t, mata, pos);
+	for(i=0;i<n-a;i++) memcpy(c+(size_t)i*a, mata[pos+a+i]+pos, a*sizeof(double));
+	spdfromrows(n-a, c+(size_t)a*(n-a), mata, pos+a);
+}
+
+void spdtorows(int n, const double *t, double** inverta, int pos)
+{
+	//Block of order n of t into (pos,pos) of inverta, both triangles.
+	int i,j,a;
+	const double *c;
+
+	if(n<=SPDLEAFORDER)
+	{
+		for(i=0;i<n;i++)
+			for(j=0;j<n;j++)
+				inverta[pos+i][pos+j]=(i>=j)?t[(size_t)i*n+j]:t[(size_t)j*n+i];
+		return;
+	}
+	a=n/2;
+	c=t+spdsize(a);
+	spdtorows(a, t, inverta, pos);
+	for(i=0;i<n-a;i++)
+	{
+		memcpy(inverta[pos+a+i]+pos, c+(size_t)i*a, a*sizeof(double));
+		for(j=0;j<a;j++) inverta[pos+j][pos+a+i]=c[(size_t)i*a+j];
+	}
+	spdtorows(n-a, c+(size_t)a*(n-a), inverta, pos+a);
+}
+
+int spdinvert(int n, double *t, struct invworkspace *ws)
+{
+	//The triangle t of order n is replaced by the triangle of its inverse.
+	int invertstatus;
+	int a;
+	int *pivot;
+	size_t mark;
+	double *c, *d;
+
+	if(n<=SPDLEAFORDER)
+	{
+		mark=invwsmark(ws);
+		pivot=(ws==NULL)?NULL:(int *) invwsalloc(ws, n*sizeof(int));
+		invertstatus=invleafgj(n, t, n, pivot, invwsdoubles(ws, invleafworksize(n)));
+		invwsrelease(ws, mark);
+		if(invertstatus==0)
+		{
+			printf("\nUnable to invert the matrix of order = %d\n",n);
+		}
+		return invertstatus;
+	}
+
+	a=n/2;
+	c=t+spdsize(a);
+	d=c+(size_t)a*(n-a);
+
+	//step-2: Calculating A^-1
+	invertstatus=spdinvert(a, t, ws);
+	if(invertstatus==0) return 0;
+
+	//step-3, 4: W = C A^-1 in place of C, and S = D - W C^T in place of D
+	invertstatus=spdschurrows(n-a, d, c, a, a, t, ws);
+	if(invertstatus==0) return 0;
+
+	//step-6: Calculating S^-1
+	invertstatus=spdinvert(n-a, d, ws);
+	if(invertstatus==0) return 0;
+
+	//step-7, 8: C = -S^-1 W in place of W, and A^-1 - W^T C in place of A^-1
+	return spdschurcols(a, t, c, a, n-a, d, ws);
+}
+
+int spdschurrows(int dn, double *dt, double *c, int ldc, int a, const double *at, struct invworkspace *ws)
+{
+	//c (dn * a) is replaced by W = c A^-1 and the triangle dt (order dn) by dt - W c^T, at holding A^-1 (order a).
+	//By the blocks of dt: the rows of its first block are done, then the rows of C next to them
+	//update its block C by c2 A^-1 c1^T = c2 W1^T, and so on.  A panel is copied aside before it is replaced.
+	int i, status;
+	int d1;
+	size_t mark;
+	double *panel, *gemmwork;
+
+	mark=invwsmark(ws);
+	if(dn<=SPDPANEL || dn<=SPDLEAFORDER)
+	{
+		panel=invwsdoubles(ws, (size_t)dn*a);
+		gemmwork=invwsdoubles(ws, invgemmworksize((dn>a)?dn:a, (dn>a)?dn:a, (dn>a)?dn:a));
+		if(ws==NULL) panel=(double *) malloc((size_t)dn*a*sizeof(double));
+		if(panel==NULL)
+		{
+			printf("\nUnable to allocate a panel of %d * %d\n",dn,a);
+			invwsrelease(ws, mark);
+			return 0;
+		}
+		for(i=0;i<dn;i++) memcpy(panel+(size_t)i*a, c+(size_t)i*ldc, a*sizeof(double));
+		status=spdrightmul(a, at, dn, 1.0, panel, a, 0.0, c, ldc, gemmwork);
+		if(status==1) status=spdrankupdate(dn, dt, a, -1.0, 0, c, ldc, 1, panel, a, gemmwork);
+		if(ws==NULL) free(panel);
+		invwsrelease(ws, mark);
+		return status;
+	}
+
+	d1=dn/2;
+	status=spdschurrows(d1, dt, c, ldc, a, at, ws);
+	mark=invwsmark(ws);
+	gemmwork=invwsdoubles(ws, invgemmworksize(dn, dn, a));
+	if(status==1) status=invgemmtrans(0, 1, dn-d1, d1, a, -1.0, c+(size_t)d1*ldc, ldc, c, ldc, 1.0, dt+spdsize(d1), d1, gemmwork);
+	invwsrelease(ws, mark);
+	if(status==1) status=spdschurrows(dn-d1, dt+spdsize(d1)+(size_t)d1*(dn-d1), c+(size_t)d1*ldc, ldc, a, at, ws);
+	return status;
+}
+
+int spdschurcols(int an, double *at, double *c, int ldc, int d, const double *dt, struct invworkspace *ws)
+{
+	//c (d * an) holding W is replaced by -S^-1 W and the triangle at (order an) by at - W^T c, dt holding S^-1 (order d).
+	//By the blocks of at, as spdschurrows: its block C gets -W2^T (-S^-1 W1) with W2 not yet replaced.
+	int i, status;
+	int a1;
+	size_t mark;
+	double *panel, *gemmwork;
+
+	mark=invwsmark(ws);
+	if(an<=SPDPANEL || an<=SPDLEAFORDER)
+	{
+		panel=invwsdoubles(ws, (size_t)d*an);
+		gemmwork=invwsdoubles(ws, invgemmworksize((d>an)?d:an, (d>an)?d:an, (d>an)?d:an));
+		if(ws==NULL) panel=(double *) malloc((size_t)d*an*sizeof(double));
+		if(panel==NULL)
+		{
+			printf("\nUnable to allocate a panel of %d * %d\n",d,an);
+			invwsrelease(ws, mark);
+			return 0;
+		}
+		for(i=0;i<d;i++) memcpy(panel+(size_t)i*an, c+(size_t)i*ldc, an*sizeof(double));
+		status=spdleftmul(d, dt, an, -1.0, panel, an, 0.0, c, ldc, gemmwork);
+		if(status==1) status=spdrankupdate(an, at, d, -1.0, 1, panel, an, 0, c, ldc, gemmwork);
+		if(ws==NULL) free(panel);
+		invwsrelease(ws, mark);
+		return status;
+	}
+
+	a1=an/2;
+	status=spdschurcols(a1, at, c, ldc, d, dt, ws);
+	mark=invwsmark(ws);
+	gemmwork=invwsdoubles(ws, invgemmworksize(an, an, d));
+	if(status==1) status=invgemmtrans(1, 0, an-a1, a1, d, -1.0, c+a1, ldc, c, ldc, 1.0, at+spdsize(a1), a1, gemmwork);
+	invwsrelease(ws, mark);
+	if(status==1) status=spdschurcols(an-a1, at+spdsize(a1)+(size_t)a1*(an-a1), c+a1, ldc, d, dt, ws);
+	return status;
+}
+
+int spdrightmul(int n, const double *t, int m, double alpha, const double *x, int ldx, double beta, double *y, int ldy, double *work)
+{
+	//y (m * n) := beta * y + alpha * x * T, x (m * n) and T the symmetric matrix of the triangle t.
+	//[y1 y2] = [x1 x2] [A C^T; C D] = [x1 A + x2 C,  x2 D + x1 C^T]
+	int a, status;
+	const double *c;
+
+	if(n<=SPDLEAFORDER) return invgemm(m, n, n, alpha, x, ldx, t, n, beta, y, ldy, work);
+	a=n/2;
+	c=t+spdsize(a);
+	status=spdrightmul(a, t, m, alpha, x, ldx, beta, y, ldy, work);
+	if(status==1) status=invgemm(m, a, n-a, alpha, x+a, ldx, c, a, 1.0, y, ldy, work);
+	if(status==1) status=spdrightmul(n-a, c+(size_t)a*(n-a), m, alpha, x+a, ldx, beta, y+a, ldy, work);
+	if(status==1) status=invgemmtrans(0, 1, m, n-a, a, alpha, x, ldx, c, a, 1.0, y+a, ldy, work);
+	return status;
+}
+
+int spdleftmul(int n, const double *t, int m, double alpha, const double *x, int ldx, double beta, double *y, int ldy, double *work)
+{
+	//y (n * m) := beta * y + alpha * T * x, x (n * m).
+	//[y1; y2] = [A C^T; C D] [x1; x2] = [A x1 + C^T x2;  C x1 + D x2]
+	int a, status;
+	const double *c;
+
+	if(n<=SPDLEAFORDER) return invgemm(n, m, n, alpha, t, n, x, ldx, beta, y, ldy, work);
+	a=n/2;
+	c=t+spdsize(a);
+	status=spdleftmul(a, t, m, alpha, x, ldx, beta, y, ldy, work);
+	if(status==1) status=invgemmtrans(1, 0, a, m, n-a, alpha, c, a, x+(size_t)a*ldx, ldx, 1.0, y, ldy, work);
+	if(status==1) status=spdleftmul(n-a, c+(size_t)a*(n-a), m, alpha, x+(size_t)a*ldx, ldx, beta, y+(size_t)a*ldy, ldy, work);
+	if(status==1) status=invgemm(n-a, m, a, alpha, c, a, x, ldx, 1.0, y+(size_t)a*ldy, ldy, work);
+	return status;
+}
+
+int spdrankupdate(int n, double *t, int k, double alpha, int transx, const double *x, int ldx, int transy, const double *y, int ldy, double *work)
+{
+	//Lower triangle t (order n) += alpha * X * Y with X (n * k) and Y (k * n), either given transposed.
+	//The block above the diagonal is skipped; a leaf is updated whole.
+	int a, status;
+	const double *x2, *y2;
+
+	if(n<=SPDLEAFORDER) return invgemmtrans(transx, transy, n, n, k, alpha, x, ldx, y, ldy, 1.0, t, n, work);
+	a=n/2;
+	x2=(transx==0)?x+(size_t)a*ldx:x+a;
+	y2=(transy==0)?y+a:y+(size_t)a*ldy;
+	status=spdrankupdate(a, t, k, alpha, transx, x, ldx, transy, y, ldy, work);
+	if(status==1) status=invgemmtrans(transx, transy, n-a, a, k, alpha, x2, ldx, y, ldy, 1.0, t+spdsize(a), a, work);
+	if(status==1) status=spdrankupdate(n-a, t+spdsize(a)+(size_t)a*(n-a), k, alpha, transx, x2, ldx, transy, y2, ldy, work);
+	return status;
+}
+
+#endif
@@ -0,0 +1,196 @@
+// Timeline of the stages of a parallel engine, per thread, written as a Chrome trace (JSON of the Trace Event Format)
+// that chrome://tracing and https://ui.perfetto.dev open.  Compiled only with -DINVERTORTRACE: without it the macros
+// below expand to nothing (TRACEBARRIER to the bare barrier) and no code or data of this file remains.
+//	TRACESTART(threads)		before the parallel region: empty buffers for the threads, the clock starts
+//	TRACEBEGIN(name, loop)		a thread starts the stage name of the loop (e.g. loopid) loop
+//	TRACEEND()			it ends the stage it began last
+//	TRACEBARRIER(loop)		OpenMP barrier; the wait of every thread is recorded as a stage "barrier"
+//	TRACESTOP(order)		after the region: the events of all the threads are written to the file
+// The file is INVERTOR_TRACE, else invertor_trace.json; every traced inversion replaces it.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_TRACE_C
+#define INVERTOR_TRACE_C
+
+#ifdef INVERTORTRACE
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#ifdef _OPENMP
+#include<omp.h>
+#endif
+
+#define TRACEEVENTS 1024	//first size of the buffer of a thread; it doubles when full
+
+struct traceevent
+{
+	const char *name;
+	int loop;
+	double start, end;	//seconds from TRACESTART
+};
+
+struct tracebuffer
+{
+	struct traceevent *events;
+	int count, size;
+	const char *name;	//stage begun and not yet ended
+	int loop;
+	double start;
+	char pad[64];		//threads write their own buffer only: keep the buffers on separate cache lines
+};
+
+static struct tracebuffer *tracebuffers=NULL;
+static int tracethreads=0;
+static double traceorigin=0;
+
+double tracenow(void);
+int tracethread(void);
+void tracestart(int threads);
+void tracebegin(const char *name, int loop);
+void traceend(void);
+void traceadd(const char *name, int loop, double start, double end);
+void tracestop(int order);
+
+#define TRACESTART(threads) tracestart(threads)
+#define TRACEBEGIN(name, loop) tracebegin(name, loop)
+#define TRACEEND() traceend()
+#define TRACEBARRIER(loop) { double tracewait=tracenow(); _Pragma("omp barrier") traceadd("barrier", loop, tracewait, tracenow()); }
+#define TRACESTOP(order) tracestop(order)
+
+double tracenow(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec+1e-9*t.tv_nsec-traceorigin;
+}
+
+int tracethread(void)
+{
+#ifdef _OPENMP
+	return omp_get_thread_num();
+#else
+	return 0;
+#endif
+}
+
+void tracestart(int threads)
+{
+	//Called by one thread outside the parallel region.  Without memory the trace is skipped, not the inversion.
+	int t;
+
+	if(threads<1) threads=1;
+	tracebuffers=(struct tracebuffer *) calloc(threads, sizeof(struct tracebuffer));
+	tracethreads=(tracebuffers==NULL)?0:threads;
+	for(t=0;t<tracethreads;t++)
+	{
+		tracebuffers[t].events=(struct traceevent *) malloc(TRACEEVENTS*sizeof(struct traceevent));
+		tracebuffers[t].size=(tracebuffers[t].events==NULL)?0:TRACEEVENTS;
+	}
+	traceorigin=0;
+	traceorigin=tracenow();
+}
+
+void traceadd(const char *name, int loop, double start, double end)
+{
+	//Appends an event to the buffer of the calling thread.
+	struct tracebuffer *b;
+	struct traceevent *grown;
+	int t=tracethread();
+
+	if(t>=tracethreads) return;
+	b=&tracebuffers[t];
+	if(b->count==b->size)
+	{
+		grown=(struct traceevent *) realloc(b->events, 2*(size_t)b->size*sizeof(struct traceevent));
+		if(grown==NULL) return;
+		b->events=grown;
+		b->size*=2;
+	}
+	b->events[b->count].name=name;
+	b->events[b->count].loop=loop;
+	b->events[b->count].start=start;
+	b->events[b->count].end=end;
+	b->count++;
+}
+
+void tracebegin(const char *name, int loop)
+{
+	int t=tracethread();
+
+	if(t>=tracethreads) return;
+	tracebuffers[t].name=name;
+	tracebuffers[t].loop=loop;
+	tracebuffers[t].start=tracenow();
+}
+
+void traceend(void)
+{
+	int t=tracethread();
+
+	if(t>=tracethreads || tracebuffers[t].name==NULL) return;
+	traceadd(tracebuffers[t].name, tracebuffers[t].loop, tracebuffers[t].start, tracenow());
+	tracebuffers[t].name=NULL;
+}
+
+void tracestop(int order)
+{
+	//Writes the events as complete events ("ph":"X", microseconds), one track per thread, and frees the buffers.
+	FILE *f;
+	const char *path;
+	int t, e, first;
+	struct traceevent *ev;
+
+	path=getenv("INVERTOR_TRACE");
+	if(path==NULL || *path==0) path="invertor_trace.json";
+	f=fopen(path, "w");
+	if(f==NULL) printf("\nUnable to write the trace %s\n",path);
+	else
+	{
+		fprintf(f, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"order\":%d,\"threads\":%d},\"traceEvents\":[\n", order, tracethreads);
+		first=1;
+		for(t=0;t<tracethreads;t++)
+		{
+			fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", first?"":",\n", t, t);
+			first=0;
+			for(e=0;e<tracebuffers[t].count;e++)
+			{
+				ev=&tracebuffers[t].events[e];
+				fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"loopid\":%d}}",
+					ev->name, (ev->name[0]=='b')?"wait":"stage", t, ev->start*1e6, (ev->end-ev->start)*1e6, ev->loop);
+			}
+		}
+		fprintf(f, "\n]}\n");
+		if(fclose(f)!=0) printf("\nUnable to write the trace %s\n",path);
+	}
+	for(t=0;t<tracethreads;t++) free(tracebuffers[t].events);
+	free(tracebuffers);
+	tracebuffers=NULL;
+	tracethreads=0;
+}
+
+#else
+
+#define TRACESTART(threads)
+#define TRACEBEGIN(name, loop)
+#define TRACEEND()
+#define TRACEBARRIER(loop) _Pragma("omp barrier")
+#define TRACESTOP(order)
+
+#endif
+
+#endif
@@ -0,0 +1,449 @@
+// Update of an existing inverse after a low rank change of the matrix, by the Sherman-Morrison-Woodbury formula.
+// If A^-1 is known and the matrix becomes A + U C V (U of order n * k, C of order k * k, V of order k * n), then
+//	(A + U C V)^-1 = A^-1 - X S^-1 Y,	X = A^-1 U C,  Y = V A^-1,  S = I + V X	(capacitance, order k)
+// which takes about 3 n^2 k operations instead of a new inversion.  Changing the rows r of A by the rows dR is U = the
+// columns r of the identity, C = I and V = dR; changing columns is the transposed form.
+// S is inverted by the leaf of `invertor_leaf.c' (the fixed order kernels up to order 16) and its condition number
+// is checked: S near singular means that the new matrix is near singular or that the update cancels most of A, and
+// then the formula loses the digits a new inversion by invertmat would keep, so the inverse is left unchanged and the
+// function fails.  A^-1 is read and written UPDATEPANEL rows at a time, so the scratch is a few (n * k) blocks.
+// Bordering grows or shrinks an inverse by k rows and columns with the block formula of inplaceblocksbya:
+//	[A B; C D]^-1 = [A^-1 + W S^-1 Z, -W S^-1; -S^-1 Z, S^-1],	W = A^-1 B,  Z = C A^-1,  S = D - C W
+// (invertmatappend), and, the other way, if M is the inverse of a matrix of which the rows and columns R are removed,
+// the inverse of what is left is M(K,K) - M(K,R) M(R,R)^-1 M(R,K) (invertmatremove), both in about 3 n^2 k operations.
+// A sliding window removes its oldest k rows and columns and appends the new ones.
+// The in-place engine `invertor_inplace_by_a.c' includes this file; it may also be included alone.
+
+// Author: R. Thiru Senthil.
+// The Institute of Mathematical Sciences,
+// IV Cross St, CIT Campus, Taramani, Chennai 600113, Tamil Nadu, India.
+// Email: rtsenthil@imsc.res.in
+// Presented at: ICHEP 2022
+// Kindly cite as:
+// 1. Inspire Link: https://inspirehep.net/literature/2619671
+// R.~Thiru Senthil, ``Invertor - Program to compute exact inversion of large matrices,'' PoS \textbf{ICHEP2022}, 1129 (2022)
+// doi:10.22323/1.414.1129
+// 2. Inspire Link: https://inspirehep.net/literature/2660850
+// R. Thiru Senthil, ``Blockwise inversion and algorithms for inverting large partitioned matrices,'' [arXiv:2305.11103 [math.NA]].(Submitted)
+
+// The invertor project details with downloads are available in the webpage: https://www.imsc.res.in/~rtsenthil/invertor.html
+// and in github page: https://github.com/rthirusenthil/invertor
+
+#ifndef INVERTOR_UPDATE_C
+#define INVERTOR_UPDATE_C
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<math.h>
+
+#include "invertor_matrix.c"
+#include "invertor_gemm.c"
+#include "invertor_leaf.c"
+
+//Rows of A^-1 gathered into one contiguous panel for the products.
+#ifndef UPDATEPANEL
+#define UPDATEPANEL 64
+#endif
+//Smallest reciprocal condition number (1-norm) of the capacitance matrix S for which the update is done.
+#ifndef UPDATERCOND
+#define UPDATERCOND 1e-8
+#endif
+
+size_t invertmatupdateworkspace(int n, int k);
+int invertmatupdatews(int n, double** inverta, int k, double** u, double** c, double** v, double *rcond, void *work, size_t bytes);
+int invertmatupdate(int n, double** inverta, int k, double** u, double** c, double** v, double *rcond);
+size_t invertmatappendworkspace(int n, int k);
+int invertmatappendws(int n, double** inverta, int k, double** b, double** c, double** d, double *rcond, void *work, size_t bytes);
+int invertmatappend(int n, double** inverta, int k, double** b, double** c, double** d, double *rcond);
+size_t invertmatremoveworkspace(int n, int k);
+int invertmatremovews(int n, double** inverta, int pos, int k, double *rcond, void *work, size_t bytes);
+int invertmatremove(int n, double** inverta, int pos, int k, double *rcond);
+size_t updategemmworksize(int n, int k);
+double updatesmallinverse(int k, const double *s, double *sinv, double scale, struct invworkspace *ws);
+double updatenorm(int m, int n, int ld, const double *s);
+
+int invertmatupdate(int n, double** inverta, int k, double** u, double** c, double** v, double *rcond)
+{
+	//inverta (order n) holds A^-1 and is replaced by (A + U C V)^-1; u is (n * k), c (k * k) and v (k * n).
+	//c may be NULL for the identity.  rcond, if not NULL, receives the reciprocal condition number of S.
+	//Returns 0, leaving inverta unchanged, if S is singular or its rcond is below UPDATERCOND: invert the
+	//updated matrix with invertmat instead.
+	int invertstatus;
+	size_t bytes;
+	void *work;
+
+	if(n<=0 || k<0) return 0;
+
+	bytes=invertmatupdateworkspace(n, k);
+	work=malloc(bytes);
+	if(work==NULL)
+	{
+		printf("\nUnable to allocate workspace of %zu bytes for the update of rank %d of the matrix of order = %d\n",bytes,k,n);
+		return 0;
+	}
+	invertstatus=invertmatupdatews(n, inverta, k, u, c, v, rcond, work, bytes);
+	free(work);
+	return invertstatus;
+}
+
+size_t invertmatupdateworkspace(int n, int k)
+{
+	//Bytes of the arena for invertmatupdatews: U C and X (n * k), V, Y and S^-1 Y (k * n), S and its inverse,
+	//the panel of A^-1 and the packing buffers of the products.
+	size_t p;
+
+	if(n<=0 || k<=0) return 0;
+	p=(n<UPDATEPANEL)?n:UPDATEPANEL;
+	return INVMATALIGN+5*invwsbytes((size_t)n*k)+2*invwsbytes((size_t)k*k)+invwsbytes(p*n)
+		+invwsbytes(updategemmworksize(n, k))+invwsbytes(k)+invwsbytes(invleafworksize(k));
+}
+
+int invertmatupdatews(int n, double** inverta, int k, double** u, double** c, double** v, double *rcond, void *work, size_t bytes)
+{
+	//As invertmatupdate with the scratch carved from work (invertmatupdateworkspace(n,k) bytes).
+	int i,j,l,p,i0;
+	double r;
+	double *uc, *x, *vc, *y, *z, *s, *sinv, *panel, *gemmwork, *ui;
+	struct invworkspace ws;
+
+	if(rcond!=NULL) *rcond=0;
+	if(n<=0 || k<0) return 0;
+	if(k==0)
+	{
+		if(rcond!=NULL) *rcond=1;
+		return 1;
+	}
+
+	invwsinit(&ws, work, bytes);
+	uc=invwsdoubles(&ws, (size_t)n*k);
+	x=invwsdoubles(&ws, (size_t)n*k);
+	vc=invwsdoubles(&ws, (size_t)k*n);
+	y=invwsdoubles(&ws, (size_t)k*n);
+	z=invwsdoubles(&ws, (size_t)k*n);
+	s=invwsdoubles(&ws, (size_t)k*k);
+	sinv=invwsdoubles(&ws, (size_t)k*k);
+	panel=invwsdoubles(&ws, (size_t)((n<UPDATEPANEL)?n:UPDATEPANEL)*n);
+	gemmwork=invwsdoubles(&ws, updategemmworksize(n, k));
+	if(uc==NULL || x==NULL || vc==NULL || y==NULL || z==NULL || s==NULL || sinv==NULL || panel==NULL || gemmwork==NULL)
+	{
+		printf("\nUnable to allocate the scratch for the update of rank %d of the matrix of order = %d\n",k,n);
+		return 0;
+	}
+
+	//uc (n * k) := U C and vc (k * n) := V.
+	for(i=0;i<n;i++)
+	{
+		ui=uc+(size_t)i*k;
+		if(c==NULL) memcpy(ui, u[i], k*sizeof(double));
+		else
+		{
+			memset(ui, 0, k*sizeof(double));
+			for(l=0;l<k;l++)
+				for(j=0;j<k;j++) ui[j]+=u[i][l]*c[l][j];
+		}
+	}
+	for(l=0;l<k;l++) memcpy(vc+(size_t)l*n, v[l], n*sizeof(double));
+
+	//One pass over A^-1, a panel of rows P = A^-1(I,:) at a time: X(I,:) := P (U C) and Y += V(:,I) P.
+	for(i0=0;i0<n;i0+=UPDATEPANEL)
+	{
+		p=(n-i0<UPDATEPANEL)?n-i0:UPDATEPANEL;
+		for(i=0;i<p;i++) memcpy(panel+(size_t)i*n, inverta[i0+i], n*sizeof(double));
+		invgemm(p, k, n, 1.0, panel, n, uc, k, 0.0, x+(size_t)i0*k, k, gemmwork);
+		invgemm(k, n, p, 1.0, vc+i0, n, panel, n, (i0==0)?0.0:1.0, y, n, gemmwork);
+	}
+
+	//S := I + V X.  Its rounding errors are of the order of 1 + |V| |X|.
+	invgemm(k, k, n, 1.0, vc, n, x, k, 0.0, s, k, gemmwork);
+	for(l=0;l<k;l++) s[(size_t)l*k+l]+=1;
+	r=updatesmallinverse(k, s, sinv, 1+updatenorm(k, n, n, vc)*updatenorm(n, k, k, x), &ws);
+	if(rcond!=NULL) *rcond=r;
+	if(r<UPDATERCOND)
+	{
+		printf("\nThe update of rank %d is ill-conditioned (rcond = %g): invert the updated matrix of order = %d instead\n",k,r,n);
+		return 0;
+	}
+
+	//Z := S^-1 Y, then the second pass A^-1(I,:) -= X(I,:) Z.
+	invgemm(k, n, k, 1.0, sinv, k, y, n, 0.0, z, n, gemmwork);
+	for(i0=0;i0<n;i0+=UPDATEPANEL)
+	{
+		p=(n-i0<UPDATEPANEL)?n-i0:UPDATEPANEL;
+		for(i=0;i<p;i++) memcpy(panel+(size_t)i*n, inverta[i0+i], n*sizeof(double));
+		invgemm(p, n, k, -1.0, x+(size_t)i0*k, k, z, n, 1.0, panel, n, gemmwork);
+		for(i=0;i<p;i++) memcpy(inverta[i0+i], panel+(size_t)i*n, n*sizeof(double));
+	}
+	return 1;
+}
+
+int invertmatappend(int n, double** inverta, int k, double** b, double** c, double** d, double *rcond)
+{
+	//inverta holds A^-1 (order n) in its first n rows and columns and is replaced by the inverse of order n + k of
+	//[A B; C D]; its rows and the rows must have room for n + k.  b is (n * k), c (k * n) and d (k * k).
+	//rcond, if not NULL, receives the reciprocal condition number of S.  Returns 0, leaving inverta unchanged,
+	//if S is singular or its rcond is below UPDATERCOND: the bordered matrix is (close to) singular.
+	int invertstatus;
+	size_t bytes;
+	void *work;
+
+	if(n<0 || k<0) return 0;
+
+	bytes=invertmatappendworkspace(n, k);
+	work=malloc(bytes);
+	if(work==NULL)
+	{
+		printf("\nUnable to allocate workspace of %zu bytes for the border of order %d of the matrix of order = %d\n",bytes,k,n);
+		return 0;
+	}
+	invertstatus=invertmatappendws(n, inverta, k, b, c, d, rcond, work, bytes);
+	free(work);
+	return invertstatus;
+}
+
+size_t invertmatappendworkspace(int n, int k)
+{
+	//Bytes of the arena for invertmatappendws: B and W (n * k), C and Z (k * n), S and its inverse, the panel of
+	//A^-1 and the packing buffers of the products.
+	size_t p;
+
+	if(n<0 || k<=0) return 0;
+	p=(n<UPDATEPANEL)?n:UPDATEPANEL;
+	return INVMATALIGN+4*invwsbytes((size_t)n*k)+2*invwsbytes((size_t)k*k)+invwsbytes(p*n+p*k)
+		+invwsbytes(updategemmworksize(n, k))+invwsbytes(k)+invwsbytes(invleafworksize(k));
+}
+
+int invertmatappendws(int n, double** inverta, int k, double** b, double** c, double** d, double *rcond, void *work, size_t bytes)
+{
+	//As invertmatappend with the scratch carved from work (invertmatappendworkspace(n,k) bytes).
+	int i,j,l,p,i0;
+	double r, scale;
+	double *bc, *w, *cc, *z, *s, *sinv, *panel, *wsinv, *gemmwork;
+	struct invworkspace ws;
+
+	if(rcond!=NULL) *rcond=0;
+	if(n<0 || k<0) return 0;
+	if(k==0)
+	{
+		if(rcond!=NULL) *rcond=1;
+		return 1;
+	}
+
+	invwsinit(&ws, work, bytes);
+	bc=invwsdoubles(&ws, (size_t)n*k);
+	w=invwsdoubles(&ws, (size_t)n*k);
+	cc=invwsdoubles(&ws, (size_t)k*n);
+	z=invwsdoubles(&ws, (size_t)k*n);
+	s=invwsdoubles(&ws, (size_t)k*k);
+	sinv=invwsdoubles(&ws, (size_t)k*k);
+	p=(n<UPDATEPANEL)?n:UPDATEPANEL;
+	panel=invwsdoubles(&ws, (size_t)p*n+(size_t)p*k);
+	gemmwork=invwsdoubles(&ws, updategemmworksize(n, k));
+	if(bc==NULL || w==NULL || cc==NULL || z==NULL || s==NULL || sinv==NULL || panel==NULL || gemmwork==NULL)
+	{
+		printf("\nUnable to allocate the scratch for the border of order %d of the matrix of order = %d\n",k,n);
+		return 0;
+	}
+	wsinv=panel+(size_t)p*n;
+
+	for(i=0;i<n;i++) memcpy(bc+(size_t)i*k, b[i], k*sizeof(double));
+	for(l=0;l<k;l++) memcpy(cc+(size_t)l*n, c[l], n*sizeof(double));
+	for(l=0;l<k;l++) memcpy(s+(size_t)l*k, d[l], k*sizeof(double));
+
+	//One pass over A^-1, a panel of rows P = A^-1(I,:) at a time: W(I,:) := P B and Z += C(:,I) P.
+	for(i0=0;i0<n;i0+=UPDATEPANEL)
+	{
+		p=(n-i0<UPDATEPANEL)?n-i0:UPDATEPANEL;
+		for(i=0;i<p;i++) memcpy(panel+(size_t)i*n, inverta[i0+i], n*sizeof(double));
+		invgemm(p, k, n, 1.0, panel, n, bc, k, 0.0, w+(size_t)i0*k, k, gemmwork);
+		invgemm(k, n, p, 1.0, cc+i0, n, panel, n, (i0==0)?0.0:1.0, z, n, gemmwork);
+	}
+
+	//S := D - C W.  Its rounding errors are of the order of |D| + |C| |W|.
+	scale=updatenorm(k, k, k, s)+updatenorm(k, n, n, cc)*updatenorm(n, k, k, w);
+	if(n>0) invgemm(k, k, n, -1.0, cc, n, w, k, 1.0, s, k, gemmwork);
+	r=updatesmallinverse(k, s, sinv, scale, &ws);
+	if(rcond!=NULL) *rcond=r;
+	if(r<UPDATERCOND)
+	{
+		printf("\nThe border of order %d is ill-conditioned (rcond = %g): the matrix of order = %d is singular\n",k,r,n+k);
+		return 0;
+	}
+
+	//Z := S^-1 Z, then the second pass: A^-1(I,:) += W(I,:) Z and the new columns -W(I,:) S^-1.
+	if(n>0)
+	{
+		memcpy(bc, z, (size_t)k*n*sizeof(double));
+		invgemm(k, n, k, 1.0, sinv, k, bc, n, 0.0, z, n, gemmwork);
+	}
+	for(i0=0;i0<n;i0+=UPDATEPANEL)
+	{
+		p=(n-i0<UPDATEPANEL)?n-i0:UPDATEPANEL;
+		for(i=0;i<p;i++) memcpy(panel+(size_t)i*n, inverta[i0+i], n*sizeof(double));
+		invgemm(p, n, k, 1.0, w+(size_t)i0*k, k, z, n, 1.0, panel, n, gemmwork);
+		invgemm(p, k, k, -1.0, w+(size_t)i0*k, k, sinv, k, 0.0, wsinv, k, gemmwork);
+		for(i=0;i<p;i++)
+		{
+			memcpy(inverta[i0+i], panel+(size_t)i*n, n*sizeof(double));
+			memcpy(inverta[i0+i]+n, wsinv+(size_t)i*k, k*sizeof(double));
+		}
+	}
+	for(l=0;l<k;l++)
+	{
+		for(j=0;j<n;j++) inverta[n+l][j]=-z[(size_t)l*n+j];
+		memcpy(inverta[n+l]+n, sinv+(size_t)l*k, k*sizeof(double));
+	}
+	return 1;
+}
+
+int invertmatremove(int n, double** inverta, int pos, int k, double *rcond)
+{
+	//inverta holds the inverse (order n) of a matrix of which the rows and columns pos ... pos+k-1 are removed;
+	//it is replaced by the inverse (order n - k) of what is left, in its first n - k rows and columns.
+	//rcond, if not NULL, receives the reciprocal condition number of M(R,R).  Returns 0, leaving inverta unchanged,
+	//if M(R,R) is singular or its rcond is below UPDATERCOND: the matrix left is (close to) singular.
+	int invertstatus;
+	size_t bytes;
+	void *work;
+
+	if(n<=0 || k<0 || pos<0 || pos+k>n) return 0;
+
+	bytes=invertmatremoveworkspace(n, k);
+	work=malloc(bytes);
+	if(work==NULL)
+	{
+		printf("\nUnable to allocate workspace of %zu bytes for the removal of order %d from the matrix of order = %d\n",bytes,k,n);
+		return 0;
+	}
+	invertstatus=invertmatremovews(n, inverta, pos, k, rcond, work, bytes);
+	free(work);
+	return invertstatus;
+}
+
+size_t invertmatremoveworkspace(int n, int k)
+{
+	//Bytes of the arena for invertmatremovews: M(:,R) (n * k), M(R,:) and Z (k * n), M(R,R) and its inverse,
+	//the panel of M and the packing buffers of the products.
+	size_t p;
+
+	if(n<=0 || k<=0) return 0;
+	p=(n<UPDATEPANEL)?n:UPDATEPANEL;
+	return INVMATALIGN+3*invwsbytes((size_t)n*k)+2*invwsbytes((size_t)k*k)+invwsbytes(p*n)
+		+invwsbytes(updategemmworksize(n, k))+invwsbytes(k)+invwsbytes(invleafworksize(k));
+}
+
+int invertmatremovews(int n, double** inverta, int pos, int k, double *rcond, void *work, size_t bytes)
+{
+	//As invertmatremove with the scratch carved from work (invertmatremoveworkspace(n,k) bytes).
+	int i,l,p,i0,dst;
+	double r;
+	double *mcol, *mrow, *z, *t, *tinv, *panel, *pi, *gemmwork;
+	struct invworkspace ws;
+
+	if(rcond!=NULL) *rcond=0;
+	if(n<=0 || k<0 || pos<0 || pos+k>n) return 0;
+	if(k==0)
+	{
+		if(rcond!=NULL) *rcond=1;
+		return 1;
+	}
+
+	invwsinit(&ws, work, bytes);
+	mcol=invwsdoubles(&ws, (size_t)n*k);
+	mrow=invwsdoubles(&ws, (size_t)k*n);
+	z=invwsdoubles(&ws, (size_t)k*n);
+	t=invwsdoubles(&ws, (size_t)k*k);
+	tinv=invwsdoubles(&ws, (size_t)k*k);
+	panel=invwsdoubles(&ws, (size_t)((n<UPDATEPANEL)?n:UPDATEPANEL)*n);
+	gemmwork=invwsdoubles(&ws, updategemmworksize(n, k));
+	if(mcol==NULL || mrow==NULL || z==NULL || t==NULL || tinv==NULL || panel==NULL || gemmwork==NULL)
+	{
+		printf("\nUnable to allocate the scratch for the removal of order %d from the matrix of order = %d\n",k,n);
+		return 0;
+	}
+
+	for(i=0;i<n;i++) memcpy(mcol+(size_t)i*k, inverta[i]+pos, k*sizeof(double));
+	for(l=0;l<k;l++) memcpy(mrow+(size_t)l*n, inverta[pos+l], n*sizeof(double));
+	for(l=0;l<k;l++) memcpy(t+(size_t)l*k, inverta[pos+l]+pos, k*sizeof(double));
+
+	//M(R,R) is small against its columns M(:,R) when the matrix left is near singular.
+	r=updatesmallinverse(k, t, tinv, updatenorm(n, k, k, mcol), &ws);
+	if(rcond!=NULL) *rcond=r;
+	if(r<UPDATERCOND)
+	{
+		printf("\nThe removal of order %d is ill-conditioned (rcond = %g): the matrix of order = %d left is singular\n",k,r,n-k);
+		return 0;
+	}
+
+	//Z := M(R,R)^-1 M(R,:), then a pass over M: M(I,:) -= M(I,R) Z, and the rows and columns kept are moved up and
+	//left.  A row is only moved to a row above it, which has been read already.
+	invgemm(k, n, k, 1.0, tinv, k, mrow, n, 0.0, z, n, gemmwork);
+	for(i0=0;i0<n;i0+=UPDATEPANEL)
+	{
+		p=(n-i0<UPDATEPANEL)?n-i0:UPDATEPANEL;
+		for(i=0;i<p;i++) memcpy(panel+(size_t)i*n, inverta[i0+i], n*sizeof(double));
+		invgemm(p, n, k, -1.0, mcol+(size_t)i0*k, k, z, n, 1.0, panel, n, gemmwork);
+		for(i=0;i<p;i++)
+		{
+			if(i0+i>=pos && i0+i<pos+k) continue;
+			dst=(i0+i<pos)?i0+i:i0+i-k;
+			pi=panel+(size_t)i*n;
+			memcpy(inverta[dst], pi, pos*sizeof(double));
+			memcpy(inverta[dst]+pos, pi+pos+k, (n-pos-k)*sizeof(double));
+		}
+	}
+	return 1;
+}
+
+size_t updategemmworksize(int n, int k)
+{
+	//Doubles of packing work for the products of this file: every product has at most max(UPDATEPANEL,k) rows
+	//and n or k for its other dimensions, and the packing work grows with each dimension.
+	int m, l;
+
+	m=(n<UPDATEPANEL)?n:UPDATEPANEL;
+	if(k>m) m=k;
+	l=(n>k)?n:k;
+	return invgemmworksize(m, l, l);
+}
+
+double updatesmallinverse(int k, const double *s, double *sinv, double scale, struct invworkspace *ws)
+{
+	//sinv := s^-1 (both k * k) by the leaf of `invertor_leaf.c'.  Returns the reciprocal condition number in the
+	//1-norm, |s| being taken as at least scale, the size of the terms that were summed into s: when they cancel,
+	//|s| |s^-1| alone misses it (for k = 1 it is always 1).  Returns 0 for a singular s.
+	int status;
+	int *pivot;
+	double norm, cond;
+	size_t mark;
+
+	mark=invwsmark(ws);
+	pivot=(int *) invwsalloc(ws, k*sizeof(int));
+	memcpy(sinv, s, (size_t)k*k*sizeof(double));
+	status=(pivot!=NULL) && invleafgj(k, sinv, k, pivot, invwsdoubles(ws, invleafworksize(k)));
+	invwsrelease(ws, mark);
+	if(status==0) return 0;
+
+	norm=updatenorm(k, k, k, s);
+	if(scale>norm) norm=scale;
+	cond=norm*updatenorm(k, k, k, sinv);
+	if(!(cond>0 && cond<HUGE_VAL)) return 0;
+	return 1/cond;
+}
+
+double updatenorm(int m, int n, int ld, const double *s)
+{
+	//1-norm (largest column sum) of the (m * n) block s of leading dimension ld.
+	int i,j;
+	double norm, sum;
+
+	norm=0;
+	for(j=0;j<n;j++)
+	{
+		for(sum=0,i=0;i<m;i++) sum+=fabs(s[(size_t)i*ld+j]);
+		if(sum>norm) norm=sum;
+	}
+	return norm;
+}
+
+#endif
@@ -26,11 +26,23 @@
 #include<time.h>
 
 //Keep only one of the following include function as uncommented for performing inversion by that method.
+//`invertor_dispatch.c' has all of them and chooses one at run time (set INVERTOR_EXPLAIN to see which and why).
+#include "invertor_dispatch.c"
 //#include "invertor_by_a.c"
-#include "invertor_inplace_by_a.c"
+//#include "invertor_inplace_by_a.c"
 //#include "invertor_by_ad.c"
 //#include "invertor_by_prll.c"
 
+//With the dispatcher, the other entry points of the library are checked after the sample inversion (testentrypoints):
+//a failed check is printed as FAILED and makes the exit status 1.  `invertor_ooc.c' needs -lpthread.
+#ifdef INVERTOR_DISPATCH_C
+#include "invertor_batch.c"
+#include "invertor_ooc.c"
+#define TESTORDER 200		//above the leaf, so that the block steps and the block pivoting are run
+#define TESTTOLERANCE 1e-8	//largest accepted |A A^-1 - I| or difference from a fresh inversion
+#define TESTFILE "testinvertor.invmat"
+#endif
+
 int testfunc(double** , int , int , double** , int , int );
 
 int matmul( double** , int , int , double** , int , int , double** , int , int );
@@ -39,11 +51,19 @@ int matmulthree(double** mata, int ma, int na, double** matb, int mb, int nb, do
 
 int matmulfive(double** mata, int ma, int na, double** matb, int mb, int nb, double** matc, int mc, int nc, double** matd, int md, int nd, double** mate, int me, int ne, double** matres, int mres, int nres);
 
-int invertmatfive(double**, double** );
-int invertmatsix(double**, double** );
 //int invertmateleven(double**, double** );
 int scalarmul(double **, int, int, double );
 
+#ifdef INVERTOR_DISPATCH_C
+double **testmatrix(int m, int n);
+void testfreematrix(double **mat, int m);
+void testfill(double **mat, int n, double diagonal);
+double testresidual(double **mata, double **inverta, int n);
+double testdifference(double **x, double **y, int n);
+int testreport(const char *check, int passed, double value);
+int testentrypoints(void);
+#endif
+
 int mataddition( double** , int , int , double** , int , int , double** , int , int );
 int matsubtraction( double** , int , int , double** , int , int , double** , int , int );
 
@@ -157,7 +177,11 @@ int main()
 	for(i=0;i<n;i++) free(p1[i]); free(p1);
 	for(i=0;i<n;i++) free(matsmallres[i]); free(matsmallres);
 	for(i=0;i<n;i++) free(p2[i]); free(p2);
+#ifdef INVERTOR_DISPATCH_C
+	return (testentrypoints()==0);
+#else
 	return 0;
+#endif
 }
 
 int testfunc(double** mata, int ma, int na, double** matres, int mres, int nres)
@@ -255,5 +279,206 @@ int matsubtraction( double** mata, int ma, int na, double** matb, int mb, int nb
 	return 1;
 }
 
+#ifdef INVERTOR_DISPATCH_C
+double **testmatrix(int m, int n)
+{
+	//(m * n) matrix of zeros; the program stops when the memory is lacking.
+	int i;
+	double **mat;
+
+	mat=(double **) calloc(m, sizeof(double *));
+	if(mat==NULL) exit(1);
+	for(i=0;i<m;i++)
+	{
+		mat[i]=(double *) calloc(n, sizeof(double));
+		if(mat[i]==NULL) exit(1);
+	}
+	return mat;
+}
+
+void testfreematrix(double **mat, int m)
+{
+	int i;
+	for(i=0;i<m;i++) free(mat[i]);
+	free(mat);
+}
+
+void testfill(double **mat, int n, double diagonal)
+{
+	//Random elements in [-1, 1], diagonal added on the diagonal.
+	int i, j;
+	for(i=0;i<n;i++)
+		for(j=0;j<n;j++) mat[i][j]=2.0*rand()/RAND_MAX-1+((i==j)?diagonal:0);
+}
+
+double testresidual(double **mata, double **inverta, int n)
+{
+	//max |A A^-1 - I|
+	int i, j;
+	double err;
+	double **prod;
+
+	prod=testmatrix(n, n);
+	matmul(mata, n, n, inverta, n, n, prod, n, n);
+	err=0;
+	for(i=0;i<n;i++)
+		for(j=0;j<n;j++)
+			if(fabs(prod[i][j]-((i==j)?1:0))>err) err=fabs(prod[i][j]-((i==j)?1:0));
+	testfreematrix(prod, n);
+	return err;
+}
+
+double testdifference(double **x, double **y, int n)
+{
+	//max |x - y| over the (n * n) leading elements
+	int i, j;
+	double err=0;
+	for(i=0;i<n;i++)
+		for(j=0;j<n;j++)
+			if(fabs(x[i][j]-y[i][j])>err) err=fabs(x[i][j]-y[i][j]);
+	return err;
+}
 
+int testreport(const char *check, int passed, double value)
+{
+	printf("\n%-60s %s (%.3e)", check, passed?"passed":"FAILED", value);
+	return passed;
+}
 
+int testentrypoints(void)
+{
+	//Checks of the entry points besides invertmat.  Returns 1 when all of them pass.
+	int n=TESTORDER, k=8, i, j, e, m, st, passed=1;
+	double err, rcond;
+	double **a, **x, **y, **u, **v, **b, **c, **d;
+	double *ba, *bx, one;
+	unsigned char singular[16];
+
+	printf("\n\nchecks of the entry points, order %d\n", n);
+	srand(7);
+	a=testmatrix(n+k, n+k);
+	x=testmatrix(n+k, n+k);
+	y=testmatrix(n+k, n+k);
+
+	//Block pivoting: a matrix whose leading block A is zero, which no block engine can invert.
+	testfill(a, n, 0);
+	for(i=0;i<n/2;i++)
+		for(j=0;j<n/2;j++) a[i][j]=0;
+	st=invertmatpivot(n, a, x, NULL);
+	err=testresidual(a, x, n);
+	passed&=testreport("invertmatpivot, zero block A", st==1 && err<TESTTOLERANCE, err);
+	st=invertmatauto(n, a, x, 0, INVSTRUCTGENERAL);
+	err=testresidual(a, x, n);
+	passed&=testreport("invertmatauto, general matrix with zero block A", st==1 && err<TESTTOLERANCE, err);
+
+	//A singular matrix (a zero row) must be reported, not inverted.
+	printf("\n(the messages of the three singular matrices are expected)");
+	testfill(a, n, n);
+	for(j=0;j<n;j++) a[n-1][j]=0;
+	st=invertmatpivot(n, a, x, NULL);
+	passed&=testreport("invertmatpivot, singular matrix returns 0", st==0, 0);
+	st=invertmat(n, a, x);
+	passed&=testreport("invertmat, singular matrix returns 0", st==0, 0);
+	testfreematrix(y, n+k);
+	y=testmatrix(3*n, 3*n);
+	testfill(y, 3*n, 3*n);
+	for(j=0;j<3*n;j++) y[2*n][j]=0;
+	st=invertmatinplace(3*n, y, y);
+	passed&=testreport("invertmatinplace, singular S of the task path returns 0", st==0, 0);
+	testfreematrix(y, 3*n);
+	y=testmatrix(n+k, n+k);
+
+	//Symmetric positive definite.
+	testfill(a, n, n);
+	for(i=0;i<n;i++)
+		for(j=0;j<i;j++) a[j][i]=a[i][j];
+	st=invertmatspd(n, a, x);
+	err=testresidual(a, x, n);
+	passed&=testreport("invertmatspd", st==1 && err<TESTTOLERANCE, err);
+
+	//Update of k rows against a fresh inversion: U the columns 3 ... 3+k-1 of the identity, V the change of those rows.
+	testfill(a, n, n);
+	u=testmatrix(n, k);
+	v=testmatrix(k, n);
+	for(i=0;i<k;i++)
+	{
+		u[3+i][i]=1;
+		for(j=0;j<n;j++) v[i][j]=2.0*rand()/RAND_MAX-1;
+	}
+	invertmat(n, a, x);
+	st=invertmatupdate(n, x, k, u, NULL, v, &rcond);
+	for(i=0;i<k;i++)
+		for(j=0;j<n;j++) a[3+i][j]+=v[i][j];
+	invertmat(n, a, y);
+	err=testdifference(x, y, n);
+	passed&=testreport("invertmatupdate against invertmat", st==1 && err<TESTTOLERANCE, err);
+	testfreematrix(u, n);
+	testfreematrix(v, k);
+
+	//Append k rows and columns to the inverse of order n, then remove them again.
+	testfill(a, n+k, n);
+	b=testmatrix(n, k);
+	c=testmatrix(k, n);
+	d=testmatrix(k, k);
+	for(i=0;i<n;i++)
+		for(j=0;j<k;j++)
+		{
+			b[i][j]=a[i][n+j];
+			c[j][i]=a[n+j][i];
+		}
+	for(i=0;i<k;i++)
+		for(j=0;j<k;j++) d[i][j]=a[n+i][n+j];
+	invertmat(n, a, x);
+	st=invertmatappend(n, x, k, b, c, d, &rcond);
+	invertmat(n+k, a, y);
+	err=testdifference(x, y, n+k);
+	passed&=testreport("invertmatappend against invertmat", st==1 && err<TESTTOLERANCE, err);
+	st=invertmatremove(n+k, x, n, k, &rcond);
+	invertmat(n, a, y);
+	err=testdifference(x, y, n);
+	passed&=testreport("invertmatremove against invertmat", st==1 && err<TESTTOLERANCE, err);
+	testfreematrix(b, n);
+	testfreematrix(c, k);
+	testfreematrix(d, k);
+
+	//Matrix file: save, invert in the mapped file, load; then back to the matrix out of core with little memory.
+	testfill(a, n, n);
+	st=invfilesave(TESTFILE, n, n, a);
+	if(st==1) st=invertmatfile(TESTFILE);
+	if(st==1) st=invfileload(TESTFILE, n, n, x);
+	err=testresidual(a, x, n);
+	passed&=testreport("invfilesave, invertmatfile, invfileload", st==1 && err<TESTTOLERANCE, err);
+	if(st==1) st=invertmatfileooc(TESTFILE, 40*(size_t)n*sizeof(double));
+	if(st==1) st=invfileload(TESTFILE, n, n, x);
+	err=testdifference(a, x, n);
+	passed&=testreport("invertmatfileooc back to the matrix", st==1 && err<TESTTOLERANCE, err);
+	remove(TESTFILE);
+
+	//Batch of 16 matrices of order 4, the last one singular (zero).
+	m=4;
+	ba=(double *) calloc(16*m*m, sizeof(double));
+	bx=(double *) calloc(16*m*m, sizeof(double));
+	if(ba==NULL || bx==NULL) exit(1);
+	for(e=0;e<15;e++)
+		for(i=0;i<m;i++)
+			for(j=0;j<m;j++) ba[(i*m+j)*16+e]=2.0*rand()/RAND_MAX-1+((i==j)?m:0);
+	st=invertbatch(m, 16, ba, bx, INVBATCHSOA, singular);
+	err=0;
+	for(e=0;e<15;e++)
+		for(i=0;i<m;i++)
+			for(j=0;j<m;j++)
+			{
+				for(one=0,k=0;k<m;k++) one+=ba[(i*m+k)*16+e]*bx[(k*m+j)*16+e];
+				if(fabs(one-((i==j)?1:0))>err) err=fabs(one-((i==j)?1:0));
+			}
+	passed&=testreport("invertbatch, the singular matrix flagged", st==0 && singular[15]==1 && singular[0]==0 && err<TESTTOLERANCE, err);
+	free(ba);
+	free(bx);
+
+	testfreematrix(a, n+k);
+	testfreematrix(x, n+k);
+	testfreematrix(y, n+k);
+	printf("\n\nchecks of the entry points %s\n", passed?"passed":"FAILED");
+	return passed;
+}
+#endif